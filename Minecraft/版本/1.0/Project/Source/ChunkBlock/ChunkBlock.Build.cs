@@ -9,6 +9,7 @@ public class ChunkBlock: ModuleRules
         PrivateDependencyModuleNames.AddRange(new string[] {
             "Core", 
             "CoreUObject",
-            "Engine"});
+            "Engine",
+            "ProceduralMeshComponent"});
     }
 }
@@ -1,9 +1,13 @@
 ﻿#include "ChunkActor.h"
+#include "BlockSubsystem.h"
+#include "BlockType.h"
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"  // HISMC批量渲染核心组件
+#include "ProceduralMeshComponent.h"                                // 面剔除网格渲染
 #include "Components/SceneComponent.h"
 #include "Engine/StaticMesh.h"
 #include "Materials/MaterialInterface.h"
 #include "Engine/World.h"
+#include "Async/Async.h"
 
 DEFINE_LOG_CATEGORY(H_LogChunkBlock);
 //  构造函数   —— ChunkActor生成时最先执行，用于初始化组件与基础状态
@@ -16,8 +20,9 @@ AChunkActor::AChunkActor()
 	// 游戏中所有组件必须存在一个根组件作为坐标参考
 	// 场景中Chunk的位置=Root的位置
 	// 强制覆盖 RootComponent（关键！必须放最上面！）
+	// 区块 Actor 会被对象池回收后移动到新位置复用，因此使用 Movable
 	USceneComponent* Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
-	Root->SetMobility(EComponentMobility::Static);
+	Root->SetMobility(EComponentMobility::Movable);
 	RootComponent = Root;
 
 	//---------------------- 创建HISM容器 ----------------------
@@ -28,7 +33,17 @@ AChunkActor::AChunkActor()
 	HISMC->SetCanEverAffectNavigation(false);      // 不参与导航（提高性能）
 	HISMC->bDisableCollision = true;               // 关闭碰撞，未来你若做方块物理需改
 	HISMC->SetCastShadow(false);                   // 关闭阴影，减少开销（未来可按需开启）
-	HISMC->SetMobility(EComponentMobility::Static);// Static=顶级优化，Chunk不移动时最合理
+	HISMC->SetMobility(EComponentMobility::Movable);// 对象池复用时需要移动区块，Static 无法在运行时移动
+
+	//---------------------- 创建面剔除网格组件 ----------------------
+	// RenderMode = CulledMesh / GreedyMesh 时使用，每个 16 高的体素段一个网格段
+	ChunkMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ChunkMesh"));
+	ChunkMesh->SetupAttachment(RootComponent);
+	ChunkMesh->SetCanEverAffectNavigation(false);
+	ChunkMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ChunkMesh->SetCastShadow(false);
+	ChunkMesh->SetMobility(EComponentMobility::Movable);
+	ChunkMesh->bUseAsyncCooking = true;
 }
 
 
@@ -61,7 +76,7 @@ void AChunkActor::InitializeChunk(int32 InSizeX, int32 InSizeY, int32 InSizeZ, f
 	BlockSize = InBlockSize;              // UE单位=厘米，128=1.28m
 
 	//---------------------------------- 分配方块数组 -----------------------------------
-	Blocks.SetNumZeroed(SizeX * SizeY * SizeZ); // 全部初始化为空气方块ID=0
+	Blocks.Init(SizeX, SizeY, SizeZ, 0); // 全部初始化为空气方块ID=0（单一ID，不分配下标数组）
 
 	//---------------------------------- 清空历史渲染实例 --------------------------------
 	if (HISMC)
@@ -74,9 +89,15 @@ void AChunkActor::InitializeChunk(int32 InSizeX, int32 InSizeY, int32 InSizeZ, f
 
 	//---------------------------------- bInstancesDirty=未同步HISM状态 -------------------
 	bInstancesDirty = false;
-
-	//---------------------------------- 在这里调用 UpdateInstances() 才能显示渲染 ---
-	UpdateInstances();
+	bHasRendered = false;
+	DirtyCells.Reset();
+	DirtyBorderMask = 0;
+	DirtySections.Init(false, Blocks.GetNumSections());
+	PendingMeshSections.Init(false, Blocks.GetNumSections());
+	SectionTriangleCounts.Init(0, Blocks.GetNumSections());
+
+	//---------------------------------- 在这里调用 RebuildRendering() 才能显示渲染 ---
+	RebuildRendering();
 	// 因为刚填了Blocks但未生成实例，因此不会看见地面
 }
 
@@ -88,48 +109,26 @@ bool AChunkActor::SetBlock(int32 X, int32 Y, int32 Z, int32 BlockID, bool bUpdat
 		return false;
 
 	const int32 Index = ToIndex(X, Y, Z);
-	const int32 OldID = Blocks[Index];
-	Blocks[Index] = BlockID;
+	if (Blocks.Get(Index) == BlockID)
+		return true; // 未变化：不产生任何脏区
 
-	//---------------------------------- 若无需立即更新渲染，则仅标记脏区 -----------------
-	if (!bUpdateMesh)
-	{
-		bInstancesDirty = true;
-		return true;
-	}
+	// 方块被挖掉或替换：挖掘进度作废，原地换材质的实例也要去掉裂纹
+	if (MiningProgress.Remove(Index) > 0)
+		WriteDestroyStage(Index, 0);
 
-	//---------------------------------- 以下进入实时增量更新模式 --------------------------
-	// 优点：修改单一方块时不必重建整个chunk（极大提升效率）
+	Blocks.Set(Index, BlockID);
 
-	if (!HISMC)
-	{
-		if (bUpdateMesh) UpdateInstances(); // 防御写法
-		return true;
-	}
+	//---------------------------------- 记录脏区 -----------------------------------
+	// 实例模式记变更格；网格模式记所在段（及共享边界的上下段、贴边时的相邻区块）
+	MarkCellDirty(X, Y, Z);
 
-	// 空->方块 = AddInstance
-	if (OldID == 0 && BlockID != 0)
-	{
-		//!! 这里调试时需要注意vector是以世界中心为原点还是以chunk原点为原点
-		FVector Pos = FVector(X * BlockSize, Y * BlockSize, Z * BlockSize);
-		FTransform TF(FRotator::ZeroRotator, Pos, FVector(BlockSize / 128.f)); // 非统一缩放注意点!!!
-		AddBlockInstanceAt(Index, BlockID, TF);
-	}
-
-	// 方块->空气 = RemoveInstance
-	else if (OldID != 0 && BlockID == 0)
-		RemoveBlockInstanceAt(Index);
-
-	// 方块ID改变 = Remove再Add（可未来优化为CustomData更新直接变材质）
-	else if (OldID != 0 && BlockID != 0 && OldID != BlockID)
-	{
-		//!! 这里调试时需要注意vector是以世界中心为原点还是以chunk原点为原点
-		FVector Pos = FVector(X * BlockSize, Y * BlockSize, Z * BlockSize);
-		FTransform TF(FRotator::ZeroRotator, Pos, FVector(BlockSize / 128.f));
-		RemoveBlockInstanceAt(Index);
-		AddBlockInstanceAt(Index, BlockID, TF);
-	}
+	//---------------------------------- 批量编辑中 / 无需立即更新：等提交或 RefreshRendering ----
+	if (EditBatchDepth > 0 || !bUpdateMesh)
+		return true;
 
+	//---------------------------------- 以下进入实时增量更新模式 --------------------------
+	// 优点：修改单一方块时不必重建整个chunk（实例模式单格增删，网格模式只重建受影响的段）
+	RefreshRendering();
 	return true;
 }
 
@@ -138,7 +137,7 @@ int32 AChunkActor::GetBlock(int32 X, int32 Y, int32 Z) const
 {
 	if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY || Z < 0 || Z >= SizeZ)
 		return 0;
-	return Blocks[ToIndex(X, Y, Z)];
+	return Blocks.Get(ToIndex(X, Y, Z));
 }
 
 // 建立并刷新所有HISM实例（全量更新，支持数千方块）
@@ -148,7 +147,8 @@ void AChunkActor::UpdateInstances()
 	if (!HISMC || !GetWorld())
 		return;
 
-	HISMC->ClearInstances(); // 清除历史实例 → 将重新创建全部方块
+	// 上次的实例数作为本次容量预估（全体积预留在高区块上会分配数 MB）
+	const int32 ExpectedInstances = HISMC->GetInstanceCount();
 
 	// 运行时兜底安全设置Mesh与材质
 	if (!HISMC->GetStaticMesh() && DefaultMesh)
@@ -159,59 +159,181 @@ void AChunkActor::UpdateInstances()
 	UE_LOG(H_LogChunkBlock, Log, TEXT("AChunkActor::UpdateInstances() - Rebuilding chunk instances..."));
 	TArray<FTransform> InstanceTransforms; // 储存所有方块的local transform
 	TArray<float> CustomData;              // 每实例携带的自定义数据 buffer
+	TArray<int32> InstanceCells;           // 每实例对应的格子下标
+	CulledInstanceCount = 0;
 
-	InstanceTransforms.Reserve(SizeX * SizeY * SizeZ);
-	CustomData.Reserve(SizeX * SizeY * SizeZ * NumCustomDataFloatsPerInstance);
+	InstanceTransforms.Reserve(ExpectedInstances);
+	InstanceCells.Reserve(ExpectedInstances);
+	CustomData.Reserve(ExpectedInstances * NumCustomDataFloatsPerInstance);
 
-	//=================== 遍历所有Block，收集可见方块 ===================
-	for (int Z = 0; Z < SizeZ; Z++)
-		for (int Y = 0; Y < SizeY; Y++)
-			for (int X = 0; X < SizeX; X++)
-			{
-				int32 Index = ToIndex(X, Y, Z);
-				int32 ID = Blocks[Index];
+	// 先收缩调色板：被挖空/填满的段恢复为单一 ID，下面可整段跳过
+	Blocks.Compact();
 
-				if (ID == 0) continue; // 空气方块不渲染
+	//=================== 按段遍历所有Block，收集可见方块 ===================
+	for (int32 Section = 0; Section < Blocks.GetNumSections(); Section++)
+	{
+		if (Blocks.IsSectionEmpty(Section)) continue; // 整段空气直接跳过
+
+		const int32 MinZ = Blocks.GetSectionMinZ(Section);
+		const int32 MaxZ = MinZ + Blocks.GetSectionSizeZ(Section);
+		for (int Z = MinZ; Z < MaxZ; Z++)
+			for (int Y = 0; Y < SizeY; Y++)
+				for (int X = 0; X < SizeX; X++)
+				{
+					int32 Index = ToIndex(X, Y, Z);
+					int32 ID = Blocks.Get(Index);
+
+					if (ID == 0) continue; // 空气方块不渲染
+
+					// 六面都被不透明方块包围（含相邻区块）：永远看不见，不生成实例
+					if (bCullHiddenBlocks && IsBlockHidden(X, Y, Z))
+					{
+						CulledInstanceCount++;
+						continue;
+					}
+
+					// 实例transform —— 位置 + 坐标 + 缩放
+					InstanceTransforms.Add(GetBlockTransform(X, Y, Z));
+					InstanceCells.Add(Index);
+
+					// 自定义材质数据(0号float存BlockID,材质可按ID解析atlas)
+					CustomData.Add((float)ID);
+					for (int e = 1; e < NumCustomDataFloatsPerInstance; e++)
+						CustomData.Add(0.f);
+
+					// 1号float存DestroyStage：全量重建时保留进行中的挖掘裂纹
+					if (MiningProgress.Num() > 0 && NumCustomDataFloatsPerInstance >= 2)
+						if (const float* Progress = MiningProgress.Find(Index))
+							CustomData[CustomData.Num() - NumCustomDataFloatsPerInstance + 1] = (float)GetDestroyStage(*Progress);
+				}
+	}
 
-				FVector Pos;
-				Pos.X = X * BlockSize;
-				Pos.Y = Y * BlockSize;
-				Pos.Z = Z * BlockSize;
+	//=================== 批量渲染构建 ===================
+	// 一次性提交全部实例：期间关闭自动建树，最后只异步建树一次、只标脏一次渲染状态
+	const bool bPrevAutoRebuild = HISMC->bAutoRebuildTreeOnInstanceChanges;
+	HISMC->bAutoRebuildTreeOnInstanceChanges = false;
 
-				// 实例transform —— 位置 + 坐标 + 缩放
-				FTransform TF(FRotator::ZeroRotator, Pos, FVector(BlockSize / 128.0f));
-				InstanceTransforms.Add(TF);
+	HISMC->ClearInstances(); // 清除历史实例 → 重新提交全部方块
+	HISMC->NumCustomDataFloats = NumCustomDataFloatsPerInstance;
+	HISMC->PerInstanceSMCustomData.Reset();
 
-				// 自定义材质数据(0号float存BlockID,材质可按ID解析atlas)
-				CustomData.Add((float)ID);
-				for (int e = 1; e < NumCustomDataFloatsPerInstance; e++)
-					CustomData.Add(0.f);
-			}
+	InstanceIndices.Init(-1, Blocks.Num()); // cell->instance映射初始化空
+	InstanceToCell.Reset();
+	bInstancesDirty = false;
+	DirtyCells.Reset(); // 全量重建已包含所有变更格
+	DirtyBorderMask = 0; // 边界格的可见性也已按当前相邻区块重新计算
 
-	//=================== 批量渲染构建 ===================
 	if (InstanceTransforms.Num() > 0)
 	{
-		InstanceIndices.Init(-1, Blocks.Num()); // cell->instance映射初始化空
-		InstanceToCell.Reset();
+		// 清空后批量添加，实例序号即为 0..N-1
+		HISMC->AddInstances(InstanceTransforms, false);
 
-		HISMC->NumCustomDataFloats = NumCustomDataFloatsPerInstance;
-		HISMC->PerInstanceSMCustomData.SetNumZeroed(InstanceTransforms.Num() * NumCustomDataFloatsPerInstance);
+		// CustomData 整块拷贝（材质据此获取BlockID）
+		HISMC->PerInstanceSMCustomData.SetNumZeroed(CustomData.Num());
+		FMemory::Memcpy(HISMC->PerInstanceSMCustomData.GetData(), CustomData.GetData(), CustomData.Num() * sizeof(float));
 
-		// 逐个AddInstance并建立 Instance ↔ Block 映射
-		for (int i = 0; i < InstanceTransforms.Num(); i++)
-		{
-			int32 InstID = HISMC->AddInstance(InstanceTransforms[i]);	// 返回实例序号
+		// 建立双向映射：挖掉方块时据此找到实例，补显相邻方块时据此判断是否已有实例
+		InstanceToCell = InstanceCells;
+		for (int32 i = 0; i < InstanceCells.Num(); i++)
+			InstanceIndices[InstanceCells[i]] = i;
+
+		HISMC->BuildTreeIfOutdated(/*Async*/true, /*ForceUpdate*/true);	// HISM构建LOD/层级加速
+	}
+
+	HISMC->bAutoRebuildTreeOnInstanceChanges = bPrevAutoRebuild;
+	HISMC->MarkRenderStateDirty();
+
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::UpdateInstances: chunk (%d,%d) %d instances, %d hidden culled"),
+		ChunkCoordinates.X, ChunkCoordinates.Y, InstanceTransforms.Num(), CulledInstanceCount);
+}
+
+FTransform AChunkActor::GetBlockTransform(int32 X, int32 Y, int32 Z) const
+{
+	//!! 这里调试时需要注意vector是以世界中心为原点还是以chunk原点为原点
+	const FVector Pos(X * BlockSize, Y * BlockSize, Z * BlockSize);
+	return FTransform(FRotator::ZeroRotator, Pos, FVector(BlockSize / 128.f)); // 非统一缩放注意点!!!
+}
+
+// 水平偏移 -> NeighborChunks 下标（与 EChunkFace 的 PosX/NegX/PosY/NegY 一致）
+static int32 GetNeighborSlot(int32 DX, int32 DY)
+{
+	if (DY == 0 && DX == 1)  return 0;
+	if (DY == 0 && DX == -1) return 1;
+	if (DX == 0 && DY == 1)  return 2;
+	if (DX == 0 && DY == -1) return 3;
+	return INDEX_NONE;
+}
+
+bool AChunkActor::IsOpaqueAt(int32 X, int32 Y, int32 Z) const
+{
+	// 世界底部之下永远看不见；顶部之上是空气
+	if (Z < 0) return true;
+	if (Z >= SizeZ) return false;
+
+	if (X >= 0 && X < SizeX && Y >= 0 && Y < SizeY)
+		return Blocks.Get(X, Y, Z) != 0; // 目前所有非空气方块都不透明
+
+	// 越过水平边界：查询相邻区块，未加载时视为空气（边界面保持可见）
+	const int32 Slot = GetNeighborSlot(X < 0 ? -1 : (X >= SizeX ? 1 : 0), Y < 0 ? -1 : (Y >= SizeY ? 1 : 0));
+	const AChunkActor* Neighbor = Slot != INDEX_NONE ? NeighborChunks[Slot].Get() : nullptr;
+	if (!CanCullAgainst(Neighbor))
+		return false; // 降采样的相邻区块与完整数据不一致，不能据此剔除
+
+	const int32 LocalX = (X + SizeX) % SizeX;
+	const int32 LocalY = (Y + SizeY) % SizeY;
+	return Neighbor->Blocks.Get(LocalX, LocalY, Z) != 0;
+}
+
+bool AChunkActor::IsBlockHidden(int32 X, int32 Y, int32 Z) const
+{
+	return IsOpaqueAt(X + 1, Y, Z) && IsOpaqueAt(X - 1, Y, Z)
+		&& IsOpaqueAt(X, Y + 1, Z) && IsOpaqueAt(X, Y - 1, Z)
+		&& IsOpaqueAt(X, Y, Z + 1) && IsOpaqueAt(X, Y, Z - 1);
+}
+
+void AChunkActor::EnsureBlockInstance(int32 X, int32 Y, int32 Z)
+{
+	if (!UsesInstances() || !HISMC || bInstancesDirty)
+		return; // 即将全量重建，届时会重新计算可见性
+
+	if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY || Z < 0 || Z >= SizeZ)
+		return;
 
-			InstanceToCell.Add(i);	// !!! 当前写法并未存储CellIndex（未来可优化
-			// 使用CellIndices数组更稳定，支持移除与更新
+	const int32 Index = ToIndex(X, Y, Z);
+	const int32 ID = Blocks.Get(Index);
+	if (ID == 0 || !InstanceIndices.IsValidIndex(Index) || InstanceIndices[Index] != -1)
+		return;
+
+	AddBlockInstanceAt(Index, ID, GetBlockTransform(X, Y, Z));
+	CulledInstanceCount = FMath::Max(0, CulledInstanceCount - 1);
+}
 
-// CustomData 直接赋值用于材质获取BlockID
-			int Offset = InstID * NumCustomDataFloatsPerInstance;
-			HISMC->PerInstanceSMCustomData[Offset] = CustomData[i * NumCustomDataFloatsPerInstance];
+void AChunkActor::RevealNeighborsOf(int32 X, int32 Y, int32 Z)
+{
+	if (!bCullHiddenBlocks)
+		return;
+
+	static const FIntVector Offsets[6] = {
+		FIntVector(1, 0, 0), FIntVector(-1, 0, 0), FIntVector(0, 1, 0),
+		FIntVector(0, -1, 0), FIntVector(0, 0, 1), FIntVector(0, 0, -1) };
+
+	for (const FIntVector& Offset : Offsets)
+	{
+		const int32 NX = X + Offset.X;
+		const int32 NY = Y + Offset.Y;
+		const int32 NZ = Z + Offset.Z;
+		if (NX >= 0 && NX < SizeX && NY >= 0 && NY < SizeY)
+		{
+			EnsureBlockInstance(NX, NY, NZ);
+			continue;
 		}
 
-		HISMC->BuildTreeIfOutdated(true, false);	// HISM构建LOD/层级加速
-		bInstancesDirty = false;
+		// 边界方块被挖掉：相邻区块贴着边界的方块随之暴露
+		const int32 Slot = GetNeighborSlot(Offset.X, Offset.Y);
+		if (AChunkActor* Neighbor = NeighborChunks[Slot].Get())
+		{
+			Neighbor->EnsureBlockInstance((NX + SizeX) % SizeX, (NY + SizeY) % SizeY, NZ);
+		}
 	}
 }
 
@@ -224,17 +346,7 @@ bool AChunkActor::AddBlockInstanceAt(int32 CellIndex, int32 BlockID, const FTran
 	// 如果格子已经存在实例——直接改材质，而不重新AddInstance（性能更好）
 	// 这个情况一般出现在方块替换时
 	if (InstanceIndices.IsValidIndex(CellIndex) && InstanceIndices[CellIndex] != -1)
-	{
-		int32 InstID = InstanceIndices[CellIndex];
-		int Offset = InstID * NumCustomDataFloatsPerInstance;
-
-		if (HISMC->PerInstanceSMCustomData.IsValidIndex(Offset))
-		{
-			HISMC->PerInstanceSMCustomData[Offset] = (float)BlockID;
-			HISMC->MarkRenderStateDirty(); // 重新触发材质更新
-		}
-		return true;
-	}
+		return RetypeBlockInstanceAt(CellIndex, BlockID);
 
 	// 添加新实例
 	HISMC->NumCustomDataFloats = NumCustomDataFloatsPerInstance;
@@ -254,7 +366,28 @@ bool AChunkActor::AddBlockInstanceAt(int32 CellIndex, int32 BlockID, const FTran
 		InstanceToCell.SetNumZeroed(NewInstID + 1);
 	InstanceToCell[NewInstID] = CellIndex;
 
-	HISMC->MarkRenderStateDirty();
+	if (!bApplyingEditBatch)
+		HISMC->MarkRenderStateDirty();
+	return true;
+}
+
+// RetypeBlockInstanceAt —— 原地换材质：只改该实例的 CustomData[0]
+// 不增删实例，实例下标、变换与空间树都不变；SetCustomDataValue 把修改记入实例更新命令缓冲，
+// 渲染代理只上传这一个实例的数据，而不是重建整个实例缓冲
+bool AChunkActor::RetypeBlockInstanceAt(int32 CellIndex, int32 BlockID)
+{
+	if (!HISMC || !InstanceIndices.IsValidIndex(CellIndex))
+		return false;
+
+	const int32 InstID = InstanceIndices[CellIndex];
+	if (InstID == -1)
+		return false;
+
+	if (!HISMC->SetCustomDataValue(InstID, 0, (float)BlockID, /*bMarkRenderStateDirty*/false))
+		return false;
+
+	// 与 WriteDestroyStage 相同，只把实例数据标脏，不重建渲染代理
+	HISMC->MarkRenderInstancesDirty();
 	return true;
 }
 
@@ -267,9 +400,12 @@ bool AChunkActor::RemoveBlockInstanceAt(int32 CellIndex)
 	if (RemoveID < 0) return false;	// 格子无方块直接返回
 
 	int LastID = HISMC->GetInstanceCount() - 1;
-	int Stride = NumCustomDataFloatsPerInstance;
 
-	// 若删除的不是最后一个，则交换数据保持连续
+	// 调用引擎内部Remove → HISMC 以 RemoveAtSwap 删除：
+	// 最后一个实例（变换与自定义数据一起）被移到 RemoveID，这里只需同步映射
+	bool ok = HISMC->RemoveInstance(RemoveID);
+	if (!ok) return false;
+
 	if (RemoveID != LastID)
 	{
 		int LastCell = InstanceToCell.IsValidIndex(LastID) ? InstanceToCell[LastID] : -1;
@@ -277,47 +413,360 @@ bool AChunkActor::RemoveBlockInstanceAt(int32 CellIndex)
 			InstanceIndices[LastCell] = RemoveID; // 更新cell映射至移位后索引
 			InstanceToCell[RemoveID] = LastCell;
 		}
+	}
 
-		// 交换材质数据 → 保证ID连续不碎裂
-		if (HISMC->PerInstanceSMCustomData.Num() >= (LastID + 1) * Stride)
+	InstanceIndices[CellIndex] = -1;
+	if (InstanceToCell.IsValidIndex(LastID))
+		InstanceToCell.RemoveAt(LastID);
+	if (!bApplyingEditBatch)
+		HISMC->MarkRenderStateDirty();
+	return true;
+}
+
+//=================== 脏区跟踪 ===================
+
+void AChunkActor::MarkSectionDirty(int32 SectionIndex)
+{
+	if (SectionIndex < 0 || SectionIndex >= Blocks.GetNumSections())
+		return;
+	if (DirtySections.Num() != Blocks.GetNumSections())
+		DirtySections.Init(false, Blocks.GetNumSections());
+	DirtySections[SectionIndex] = true;
+}
+
+void AChunkActor::MarkAllSectionsDirty()
+{
+	DirtySections.Init(true, Blocks.GetNumSections());
+}
+
+void AChunkActor::MarkCellDirty(int32 X, int32 Y, int32 Z)
+{
+	// LOD 网格每次整体重建；相邻区块也不会拿降采样的区块做边界遮挡
+	if (LODLevel > 0)
+	{
+		bInstancesDirty = true;
+		return;
+	}
+
+	const int32 Section = Z / FChunkVoxelStorage::SectionHeight;
+	if (UsesInstances())
+	{
+		DirtyCells.Add(ToIndex(X, Y, Z));
+	}
+	else
+	{
+		// 段的顶/底层决定相邻段的底/顶面是否可见
+		const int32 LocalZ = Z - Section * FChunkVoxelStorage::SectionHeight;
+		MarkSectionDirty(Section);
+		if (LocalZ == 0)
+			MarkSectionDirty(Section - 1);
+		if (LocalZ == Blocks.GetSectionSizeZ(Section) - 1)
+			MarkSectionDirty(Section + 1);
+	}
+
+	// 贴着水平边界：相邻区块朝向本区块的面依赖此格
+	if (X == SizeX - 1) InvalidateNeighborSection(0, Section);
+	if (X == 0)         InvalidateNeighborSection(1, Section);
+	if (Y == SizeY - 1) InvalidateNeighborSection(2, Section);
+	if (Y == 0)         InvalidateNeighborSection(3, Section);
+}
+
+void AChunkActor::InvalidateNeighborSection(int32 Slot, int32 SectionIndex)
+{
+	AChunkActor* Neighbor = NeighborChunks[Slot].Get();
+
+	// 实例模式的相邻区块由 RevealNeighborsOf 直接补实例，不需要重建；LOD 网格不读取本区块
+	if (!Neighbor || Neighbor->UsesInstances() || !Neighbor->CanCullAgainst(this))
+		return;
+
+	Neighbor->MarkSectionDirty(SectionIndex);
+	DirtyNeighborMask |= 1 << Slot;
+}
+
+void AChunkActor::FlushDirtyNeighbors()
+{
+	const uint8 Mask = DirtyNeighborMask;
+	DirtyNeighborMask = 0;
+
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(NeighborChunks); Slot++)
+	{
+		if ((Mask & (1 << Slot)) == 0) continue;
+		if (AChunkActor* Neighbor = NeighborChunks[Slot].Get())
+			Neighbor->RefreshRendering();
+	}
+}
+
+// ApplyCellDelta —— 实例模式：关闭自动建树，逐格同步实例，最后统一建树与标脏
+void AChunkActor::ApplyCellDelta()
+{
+	if (!HISMC)
+		return;
+
+	// 相邻区块变化过的边界：只把可见性需要改变的贴边格加入本次增量
+	CollectDirtyBorderCells();
+	if (DirtyCells.Num() == 0)
+		return;
+
+	// 变更过多时逐个增删实例（每次 RemoveInstance 都要搬移数据）比批量重建更慢
+	const int32 RebuildThreshold = FMath::Max(64, FMath::CeilToInt(HISMC->GetInstanceCount() * EditBatchRebuildRatio));
+	if (DirtyCells.Num() > RebuildThreshold)
+	{
+		UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::ApplyCellDelta: %d cells -> full rebuild"), DirtyCells.Num());
+		UpdateInstances();
+		return;
+	}
+
+	const bool bPrevAutoRebuild = HISMC->bAutoRebuildTreeOnInstanceChanges;
+	HISMC->bAutoRebuildTreeOnInstanceChanges = false;
+	bApplyingEditBatch = true;
+
+	// 只有增删过实例才需要重建空间树与渲染状态；全部为原地换材质时实例数据已各自标脏
+	bool bInstancesAddedOrRemoved = false;
+
+	for (const int32 CellIndex : DirtyCells)
+	{
+		const int32 X = CellIndex % SizeX;
+		const int32 Y = (CellIndex / SizeX) % SizeY;
+		const int32 Z = CellIndex / (SizeX * SizeY);
+		const int32 ID = Blocks.Get(CellIndex);
+
+		if (ID == 0)
 		{
-			int src = LastID * Stride, dst = RemoveID * Stride;
-			for (int i = 0; i < Stride; i++)
-				HISMC->PerInstanceSMCustomData[dst + i] = HISMC->PerInstanceSMCustomData[src + i];
+			// 变为空气：删除实例，并显露被剔除的相邻方块
+			bInstancesAddedOrRemoved |= RemoveBlockInstanceAt(CellIndex);
+			const int32 NumBeforeReveal = HISMC->GetInstanceCount();
+			RevealNeighborsOf(X, Y, Z);
+			bInstancesAddedOrRemoved |= HISMC->GetInstanceCount() != NumBeforeReveal;
+		}
+		else if (InstanceIndices[CellIndex] != -1)
+		{
+			if (bCullHiddenBlocks && IsBlockHidden(X, Y, Z))
+			{
+				// 贴边方块被新接上的相邻区块完全遮挡：删除实例
+				bInstancesAddedOrRemoved |= RemoveBlockInstanceAt(CellIndex);
+				CulledInstanceCount++;
+			}
+			else
+			{
+				// 非空 -> 非空：原地换材质，不增删实例
+				RetypeBlockInstanceAt(CellIndex, ID);
+			}
+		}
+		else if (!bCullHiddenBlocks || !IsBlockHidden(X, Y, Z))
+		{
+			bInstancesAddedOrRemoved |= AddBlockInstanceAt(CellIndex, ID, GetBlockTransform(X, Y, Z));
 		}
 	}
 
-	// 调用引擎内部Remove → 完成渲染结构更新
-	bool ok = HISMC->RemoveInstance(RemoveID);
-	if (!ok) return false;
+	bApplyingEditBatch = false;
+	HISMC->bAutoRebuildTreeOnInstanceChanges = bPrevAutoRebuild;
+	if (bInstancesAddedOrRemoved)
+	{
+		HISMC->BuildTreeIfOutdated(/*Async*/true, /*ForceUpdate*/false);
+		HISMC->MarkRenderStateDirty();
+	}
 
-	// 删除custom数据尾部
-	if (HISMC->PerInstanceSMCustomData.Num() >= Stride)
-		HISMC->PerInstanceSMCustomData.RemoveAt(LastID * Stride, Stride, true);
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::ApplyCellDelta: applied %d cell delta"), DirtyCells.Num());
+	DirtyCells.Reset();
+}
 
-	InstanceIndices[CellIndex] = -1;
-	InstanceToCell.RemoveAt(LastID);
-	HISMC->MarkRenderStateDirty();
+// ReplaceVoxelData —— 逐段比较新旧体素，只把变化部分记为脏区
+void AChunkActor::ReplaceVoxelData(const FChunkVoxelStorage& NewData)
+{
+	// 体素被整体替换，进行中的挖掘全部作废
+	ResetMiningProgress();
+
+	// 尚未渲染过、已需要全量重建或处于 LOD（整体重建）：无需比较
+	if (bInstancesDirty || !bHasRendered || LODLevel > 0)
+	{
+		Blocks = NewData;
+		bInstancesDirty = true;
+		return;
+	}
+
+	// 旧数据可能带着未收缩的调色板，先收缩，避免相同内容因编码不同被误判为变化
+	Blocks.Compact();
+
+	int32 ChangedSections = 0;
+	for (int32 Section = 0; Section < Blocks.GetNumSections(); Section++)
+	{
+		if (Blocks.GetSection(Section).IsIdenticalTo(NewData.GetSection(Section)))
+			continue;
+		ChangedSections++;
+
+		if (UsesInstances())
+		{
+			// 逐格比较，只同步真正变化的格子
+			const int32 MinZ = Blocks.GetSectionMinZ(Section);
+			const int32 MaxZ = MinZ + Blocks.GetSectionSizeZ(Section);
+			for (int32 Z = MinZ; Z < MaxZ; Z++)
+				for (int32 Y = 0; Y < SizeY; Y++)
+					for (int32 X = 0; X < SizeX; X++)
+						if (Blocks.Get(X, Y, Z) != NewData.Get(X, Y, Z))
+							DirtyCells.Add(ToIndex(X, Y, Z));
+		}
+		else
+		{
+			MarkSectionDirty(Section - 1);
+			MarkSectionDirty(Section);
+			MarkSectionDirty(Section + 1);
+		}
+
+		for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(NeighborChunks); Slot++)
+			InvalidateNeighborSection(Slot, Section);
+	}
+
+	Blocks = NewData;
+
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::ReplaceVoxelData: chunk (%d,%d) %d/%d sections changed"),
+		ChunkCoordinates.X, ChunkCoordinates.Y, ChangedSections, Blocks.GetNumSections());
+}
+
+//=================== 挖掘进度 ===================
+
+int32 AChunkActor::GetDestroyStage(float Progress) const
+{
+	// 刚开始挖就显示第 1 阶段裂纹，挖完前停在最后一阶段
+	if (Progress <= 0.f)
+		return 0;
+	return FMath::Clamp(FMath::FloorToInt(Progress * NumDestroyStages) + 1, 1, NumDestroyStages);
+}
+
+bool AChunkActor::WriteDestroyStage(int32 CellIndex, int32 Stage, bool bFullRenderStateDirty)
+{
+	// 网格模式没有逐方块实例，不显示裂纹（进度照常记录）
+	if (!UsesInstances() || !HISMC || NumCustomDataFloatsPerInstance < 2
+		|| !InstanceIndices.IsValidIndex(CellIndex))
+		return false;
+
+	const int32 InstID = InstanceIndices[CellIndex];
+	if (InstID == -1)
+		return false; // 被剔除的方块看不见，也就不需要裂纹
+
+	if (!HISMC->SetCustomDataValue(InstID, 1, (float)Stage, bFullRenderStateDirty))
+		return false;
+
+	// 只把实例数据标脏：帧末只提交命令缓冲里这一个实例的自定义数据，渲染代理与空间树保持不变
+	if (!bFullRenderStateDirty)
+		HISMC->MarkRenderInstancesDirty();
 	return true;
 }
 
+void AChunkActor::ResetMiningProgress()
+{
+	for (const TPair<int32, float>& Pair : MiningProgress)
+		WriteDestroyStage(Pair.Key, 0);
+	MiningProgress.Reset();
+}
+
+bool AChunkActor::SetMiningProgress(int32 X, int32 Y, int32 Z, float Progress)
+{
+	if (GetBlock(X, Y, Z) == 0)
+		return false;
+
+	const int32 Index = ToIndex(X, Y, Z);
+	if (Progress <= 0.f)
+	{
+		ClearMiningProgress(X, Y, Z);
+		return true;
+	}
+
+	Progress = FMath::Min(Progress, 1.f);
+	float& Current = MiningProgress.FindOrAdd(Index, 0.f);
+	const int32 OldStage = GetDestroyStage(Current);
+	Current = Progress;
+
+	// 阶段没变（每帧的大多数情况）：不写实例数据
+	const int32 NewStage = GetDestroyStage(Progress);
+	if (NewStage != OldStage)
+		WriteDestroyStage(Index, NewStage);
+	return true;
+}
+
+float AChunkActor::GetMiningProgress(int32 X, int32 Y, int32 Z) const
+{
+	if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY || Z < 0 || Z >= SizeZ)
+		return 0.f;
+	return MiningProgress.FindRef(ToIndex(X, Y, Z));
+}
+
+void AChunkActor::ClearMiningProgress(int32 X, int32 Y, int32 Z)
+{
+	if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY || Z < 0 || Z >= SizeZ)
+		return;
+
+	const int32 Index = ToIndex(X, Y, Z);
+	if (MiningProgress.Remove(Index) > 0)
+		WriteDestroyStage(Index, 0);
+}
+
+bool AChunkActor::TickMining(int32 X, int32 Y, int32 Z, float DeltaSeconds, float MiningSpeed, float& OutProgress)
+{
+	OutProgress = 0.f;
+
+	const int32 ID = GetBlock(X, Y, Z);
+	if (ID == 0)
+		return false;
+
+	// 耐久度来自方块注册表；未注册的方块按 1 秒挖完
+	float Durability = 1.f;
+	if (const UBlockSubsystem* BlockSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UBlockSubsystem>() : nullptr)
+	{
+		if (const UBlockType* BlockType = BlockSubsystem->FindBlockByID(ID))
+		{
+			if (!BlockType->bDestructible)
+				return false;
+			Durability = BlockType->Durability;
+		}
+	}
+
+	OutProgress = GetMiningProgress(X, Y, Z) + DeltaSeconds * MiningSpeed / FMath::Max(Durability, KINDA_SMALL_NUMBER);
+	if (OutProgress >= 1.f)
+	{
+		OutProgress = 1.f;
+		SetBlock(X, Y, Z, 0); // 会一并清除挖掘进度
+		return true;
+	}
+
+	SetMiningProgress(X, Y, Z, OutProgress);
+	return false;
+}
+
+//=================== 批量编辑 ===================
+
+void AChunkActor::BeginEditBatch()
+{
+	EditBatchDepth++;
+}
+
+void AChunkActor::CommitEditBatch()
+{
+	if (EditBatchDepth <= 0)
+		return;
+	if (--EditBatchDepth > 0)
+		return; // 嵌套批次：由最外层提交
+
+	// 批次内累积的脏区一次性同步
+	RefreshRendering();
+}
+
 // IChunkInterface Implementation —— 供 WorldGen 模块调用
-void AChunkActor::SetChunkData(const TArray<int32>& BlockData)
+void AChunkActor::SetChunkData(const FChunkVoxelStorage& BlockData)
 {
 	//=================== 调试日志 ===================
 	UE_LOG(H_LogChunkBlock, Log, TEXT("AChunkActor::SetChunkData: Coords=(%d,%d,%d), DataSize=%d"),
 		ChunkCoordinates.X, ChunkCoordinates.Y, ChunkCoordinates.Z, BlockData.Num());
 
-	// 安全检查：数据长度必须匹配当前区块体积
-	if (BlockData.Num() != SizeX * SizeY * SizeZ)
+	// 安全检查：数据尺寸必须与当前区块一致（下标布局依赖 SizeX/SizeY）
+	if (BlockData.GetSizeX() != SizeX || BlockData.GetSizeY() != SizeY || BlockData.GetSizeZ() != SizeZ)
 	{
 		UE_LOG(H_LogChunkBlock, Warning, TEXT("AChunkActor::SetChunkData: Data size mismatch! Expected %d, got %d"),
 			SizeX * SizeY * SizeZ, BlockData.Num());
 		return;
 	}
 
-	Blocks = BlockData;
-	bInstancesDirty = true; // 标记为脏，但不立即更新（由 RefreshRendering 触发）
+	// 标记脏区，但不立即更新（由 RefreshRendering 触发）；复用中的区块只记录变化的段
+	ReplaceVoxelData(BlockData);
 }
 
 void AChunkActor::SetChunkCoordinates(FIntVector Coords)
@@ -333,31 +782,410 @@ FIntVector AChunkActor::GetChunkCoordinates() const
 void AChunkActor::RefreshRendering()
 {
 	//=================== 调试日志 ===================
-	UE_LOG(H_LogChunkBlock, Log, TEXT("Refreshing rendering for chunk (%d,%d)"),
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("Refreshing rendering for chunk (%d,%d)"),
 		ChunkCoordinates.X, ChunkCoordinates.Y);
 
-	// 如果已标记为脏，或尚未生成实例，则强制重建
-	if (bInstancesDirty || !HISMC || HISMC->GetInstanceCount() == 0)
+	// 批量编辑中：由 CommitEditBatch 统一同步
+	if (EditBatchDepth > 0)
+		return;
+
+	// 如果已标记为脏，或尚未完整渲染过，则强制重建；否则只同步脏区
+	if (bInstancesDirty || !bHasRendered)
+	{
+		RebuildRendering();
+	}
+	else if (UsesInstances())
+	{
+		ApplyCellDelta();
+	}
+	else if (LODLevel == 0 && DirtySections.Find(true) != INDEX_NONE)
+	{
+		UpdateMesh();
+	}
+
+	// 边界修改波及的相邻区块（网格模式）只重建对应段
+	FlushDirtyNeighbors();
+}
+
+void AChunkActor::RebuildRendering()
+{
+	if (UsesInstances())
+	{
+		// 在途的网格构建（例如刚从 LOD 切回）作废，避免其回调清掉新实例
+		++MeshBuildGeneration;
+		if (ChunkMesh) ChunkMesh->ClearAllMeshSections();
+		UpdateInstances();
+	}
+	else
+	{
+		// HISMC 实例保留到新网格提交时再清除（ApplyMeshData），异步构建期间不会出现空洞
+		MarkAllSectionsDirty();
+		UpdateMesh();
+	}
+
+	DirtyCells.Reset();
+	bHasRendered = true;
+}
+
+FChunkMeshContext AChunkActor::MakeMeshContext() const
+{
+	FChunkMeshContext Context;
+	Context.Voxels = &Blocks;
+	Context.BlockSize = BlockSize;
+	Context.Origin = MeshOffset;
+
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(NeighborChunks); Slot++)
+	{
+		const AChunkActor* Neighbor = NeighborChunks[Slot].Get();
+		if (CanCullAgainst(Neighbor))
+			Context.Neighbors[Slot] = &Neighbor->Blocks;
+	}
+	return Context;
+}
+
+// UpdateMesh —— 只输出暴露面，每个 16 高的体素段对应一个网格段，只重建脏段
+// LODLevel > 0 时整体降采样后重建（降采样后的段数更少，边界面全部保留，与相邻级别之间不会漏缝）
+void AChunkActor::UpdateMesh()
+{
+	if (!ChunkMesh || !GetWorld())
+		return;
+
+	const int32 NumSections = Blocks.GetNumSections();
+	const int32 LODFactor = GetLODFactor();
+	const EChunkRenderMode Mode = LODLevel > 0 ? EChunkRenderMode::GreedyMesh : RenderMode;
+	if (DirtySections.Num() != NumSections || DirtySections.Find(true) == INDEX_NONE)
+		MarkAllSectionsDirty(); // 直接调用（蓝图 / 尺寸变化）：重建全部
+	if (PendingMeshSections.Num() != NumSections)
+		PendingMeshSections.Init(false, NumSections);
+
+	TArray<int32> Sections;
+	bool bReplaceAll = true;
+	if (LODLevel > 0)
+	{
+		const int32 NumLODSections = FMath::DivideAndRoundUp(FMath::DivideAndRoundUp(SizeZ, LODFactor), FChunkVoxelStorage::SectionHeight);
+		for (int32 Section = 0; Section < NumLODSections; Section++)
+			Sections.Add(Section);
+		PendingMeshSections.Init(false, NumSections);
+	}
+	else
+	{
+		// 本次构建取代在途构建（其结果回调时会被丢弃），在途的段也要一并重建
+		for (int32 Section = 0; Section < NumSections; Section++)
+		{
+			if (DirtySections[Section] || PendingMeshSections[Section])
+			{
+				PendingMeshSections[Section] = true;
+				Sections.Add(Section);
+			}
+		}
+		bReplaceAll = Sections.Num() == NumSections;
+	}
+	DirtySections.Init(false, NumSections);
+
+	const uint32 Generation = ++MeshBuildGeneration;
+	bInstancesDirty = false; // 快照已包含当前所有修改，之后的修改会重新标脏
+
+	if (!bAsyncMeshing)
+	{
+		TArray<FChunkMeshData> Meshes;
+		BuildMeshData(Mode, MakeMeshContext(), LODFactor, Sections, Meshes);
+		ApplyMeshData(Sections, Meshes, bReplaceAll);
+		PendingMeshSections.Init(false, NumSections);
+		return;
+	}
+
+	//=================== 工作线程构建 ===================
+	// 体素快照按值拷贝（调色板压缩后通常只有几 KB），相邻区块一并拷贝用于边界面剔除；任务不访问任何 UObject
+	FChunkMeshContext LiveContext = MakeMeshContext();
+	TArray<FChunkVoxelStorage> NeighborSnapshots;
+	NeighborSnapshots.SetNum(UE_ARRAY_COUNT(LiveContext.Neighbors));
+	uint8 NeighborMask = 0;
+	for (int32 Slot = 0; Slot < NeighborSnapshots.Num(); Slot++)
 	{
-		UpdateInstances(); // 调用你已有的全量更新函数
+		if (LiveContext.Neighbors[Slot])
+		{
+			NeighborSnapshots[Slot] = *LiveContext.Neighbors[Slot];
+			NeighborMask |= 1 << Slot;
+		}
+	}
+
+	TWeakObjectPtr<AChunkActor> WeakChunk(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+		[WeakChunk, Generation, Mode, LODFactor, bReplaceAll, Snapshot = Blocks, NeighborSnapshots = MoveTemp(NeighborSnapshots),
+		NeighborMask, InBlockSize = BlockSize, Offset = MeshOffset, Sections = MoveTemp(Sections)]()
+		{
+			FChunkMeshContext Context;
+			Context.Voxels = &Snapshot;
+			Context.BlockSize = InBlockSize;
+			Context.Origin = Offset;
+			for (int32 Slot = 0; Slot < NeighborSnapshots.Num(); Slot++)
+				if (NeighborMask & (1 << Slot))
+					Context.Neighbors[Slot] = &NeighborSnapshots[Slot];
+
+			TArray<FChunkMeshData> BuiltMeshes;
+			BuildMeshData(Mode, Context, LODFactor, Sections, BuiltMeshes);
+
+			AsyncTask(ENamedThreads::GameThread,
+				[WeakChunk, Generation, bReplaceAll, Sections, BuiltMeshes = MoveTemp(BuiltMeshes)]()
+				{
+					// 区块已销毁、被回收复用，或已发起更新的构建：丢弃
+					AChunkActor* Chunk = WeakChunk.Get();
+					if (!Chunk || Generation != Chunk->MeshBuildGeneration)
+						return;
+
+					Chunk->ApplyMeshData(Sections, BuiltMeshes, bReplaceAll);
+					Chunk->PendingMeshSections.Init(false, Chunk->Blocks.GetNumSections());
+				});
+		});
+}
+
+void AChunkActor::BuildMeshData(EChunkRenderMode Mode, const FChunkMeshContext& Context, int32 LODFactor,
+	const TArray<int32>& Sections, TArray<FChunkMeshData>& OutMeshes)
+{
+	// LOD：降采样后按放大的方块尺寸构建，相邻区块的完整数据与之不对应，不参与剔除
+	FChunkVoxelStorage LODVoxels;
+	FChunkMeshContext LODContext;
+	const FChunkMeshContext* BuildContext = &Context;
+	if (LODFactor > 1)
+	{
+		FChunkVoxelStorage::Downsample(*Context.Voxels, LODFactor, LODVoxels);
+		LODContext.Voxels = &LODVoxels;
+		LODContext.BlockSize = Context.BlockSize * LODFactor;
+		LODContext.Origin = Context.Origin;
+		BuildContext = &LODContext;
+	}
+
+	OutMeshes.SetNum(Sections.Num());
+	for (int32 i = 0; i < Sections.Num(); i++)
+	{
+		if (Mode == EChunkRenderMode::GreedyMesh)
+			FChunkMesher::BuildGreedyMesh(*BuildContext, Sections[i], OutMeshes[i]);
+		else
+			FChunkMesher::BuildCulledMesh(*BuildContext, Sections[i], OutMeshes[i]);
+	}
+}
+
+void AChunkActor::ApplyMeshData(const TArray<int32>& Sections, const TArray<FChunkMeshData>& Meshes, bool bReplaceAll)
+{
+	if (!ChunkMesh)
+		return;
+
+	// 整体替换：旧的网格段（段数可能随 LOD 变化）与实例在新网格就绪的同一帧清除
+	if (bReplaceAll)
+	{
+		ChunkMesh->ClearAllMeshSections();
+		SectionTriangleCounts.Reset();
+		if (HISMC && HISMC->GetInstanceCount() > 0)
+			HISMC->ClearInstances();
+	}
+	for (const int32 Section : Sections)
+	{
+		if (Section >= SectionTriangleCounts.Num())
+			SectionTriangleCounts.SetNumZeroed(Section + 1);
+	}
+
+	UMaterialInterface* Material = MeshAtlasMaterial ? MeshAtlasMaterial : AtlasMaterial;
+	for (int32 i = 0; i < Sections.Num(); i++)
+	{
+		const int32 Section = Sections[i];
+		const FChunkMeshData& Mesh = Meshes[i];
+
+		// 只替换本次重建的网格段，其余段保持不变
+		if (Mesh.IsEmpty())
+		{
+			ChunkMesh->ClearMeshSection(Section);
+		}
+		else
+		{
+			ChunkMesh->CreateMeshSection(Section, Mesh.Vertices, Mesh.Triangles, Mesh.Normals,
+				Mesh.UV0, Mesh.UV1, TArray<FVector2D>(), TArray<FVector2D>(),
+				TArray<FColor>(), TArray<FProcMeshTangent>(), false);
+
+			if (Material)
+				ChunkMesh->SetMaterial(Section, Material);
+		}
+		SectionTriangleCounts[Section] = Mesh.GetNumTriangles();
+	}
+
+	MeshTriangleCount = 0;
+	for (const int32 Count : SectionTriangleCounts)
+		MeshTriangleCount += Count;
+
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::ApplyMeshData: chunk (%d,%d) rebuilt %d sections, %d triangles"),
+		ChunkCoordinates.X, ChunkCoordinates.Y, Sections.Num(), MeshTriangleCount);
+}
+
+int32 AChunkActor::GetRenderedTriangleCount() const
+{
+	if (!UsesInstances())
+		return MeshTriangleCount;
+
+	if (!HISMC || !HISMC->GetStaticMesh())
+		return 0;
+	return HISMC->GetInstanceCount() * HISMC->GetStaticMesh()->GetNumTriangles(0);
+}
+
+void AChunkActor::OnReleasedToPool()
+{
+	//=================== 回收到对象池 ===================
+	// 只隐藏，不释放 Blocks / 实例映射 / HISMC，下次复用时沿用已有分配
+	SetActorHiddenInGame(true);
+
+	// 复用时会写入新数据，强制下一次 RefreshRendering 全量重建
+	bInstancesDirty = true;
+
+	// 未提交的批量编辑、脏区与挖掘进度已无意义
+	EditBatchDepth = 0;
+	MiningProgress.Reset();
+	bHasRendered = false;
+	DirtyCells.Reset();
+	DirtySections.Init(false, Blocks.GetNumSections());
+	PendingMeshSections.Init(false, Blocks.GetNumSections());
+	SectionTriangleCounts.Init(0, Blocks.GetNumSections());
+	MeshTriangleCount = 0;
+	DirtyNeighborMask = 0;
+	DirtyBorderMask = 0;
+
+	// 相邻关系由管理器在卸载时解除，这里兜底清空
+	for (TWeakObjectPtr<AChunkActor>& Neighbor : NeighborChunks)
+		Neighbor.Reset();
+
+	// 在途的网格构建基于旧数据，回调时丢弃
+	++MeshBuildGeneration;
+
+	// 网格异步重建期间不能在新位置显示旧网格
+	if (ChunkMesh && !UsesInstances())
+		ChunkMesh->ClearAllMeshSections();
+
+	// 复用时由管理器按新位置重新设置
+	LODLevel = 0;
+}
+
+void AChunkActor::OnAcquiredFromPool()
+{
+	SetActorHiddenInGame(false);
+}
+
+void AChunkActor::SetNeighborChunk(const FIntPoint& Offset, AActor* Neighbor)
+{
+	const int32 Slot = GetNeighborSlot(Offset.X, Offset.Y);
+	if (Slot == INDEX_NONE)
+		return;
+
+	AChunkActor* NeighborChunk = Cast<AChunkActor>(Neighbor);
+	if (NeighborChunks[Slot].Get() == NeighborChunk)
+		return;
+
+	NeighborChunks[Slot] = NeighborChunk;
+	InvalidateBorder(Slot);
+}
+
+void AChunkActor::InvalidateBorder(int32 Slot)
+{
+	// LOD 网格不读取相邻区块
+	if (LODLevel > 0)
+		return;
+
+	// 边界方块的可见性随之改变：实例模式只记下这一侧，刷新时逐格判断；网格模式重建所有非空段（边界面剔除依赖相邻区块）
+	if (UsesInstances())
+	{
+		if (bCullHiddenBlocks)
+			DirtyBorderMask |= 1 << Slot;
+	}
+	else
+	{
+		for (int32 Section = 0; Section < Blocks.GetNumSections(); Section++)
+			if (!Blocks.IsSectionEmpty(Section))
+				MarkSectionDirty(Section);
+	}
+}
+
+void AChunkActor::CollectDirtyBorderCells()
+{
+	const uint8 Mask = DirtyBorderMask;
+	DirtyBorderMask = 0;
+	if (Mask == 0 || !bCullHiddenBlocks)
+		return;
+
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(NeighborChunks); Slot++)
+	{
+		if ((Mask & (1 << Slot)) == 0) continue;
+
+		// 槽位 0/1 为 X 方向的边界列（沿 Y 排布），2/3 为 Y 方向的边界行（沿 X 排布）
+		const bool bAlongY = Slot < 2;
+		const int32 BorderX = Slot == 0 ? SizeX - 1 : 0;
+		const int32 BorderY = Slot == 2 ? SizeY - 1 : 0;
+		const int32 Length = bAlongY ? SizeY : SizeX;
+
+		for (int32 Section = 0; Section < Blocks.GetNumSections(); Section++)
+		{
+			if (Blocks.IsSectionEmpty(Section)) continue;
+
+			const int32 MinZ = Blocks.GetSectionMinZ(Section);
+			const int32 MaxZ = MinZ + Blocks.GetSectionSizeZ(Section);
+			for (int32 Z = MinZ; Z < MaxZ; Z++)
+				for (int32 i = 0; i < Length; i++)
+				{
+					const int32 X = bAlongY ? BorderX : i;
+					const int32 Y = bAlongY ? i : BorderY;
+					const int32 Index = ToIndex(X, Y, Z);
+					if (Blocks.Get(Index) == 0) continue;
+
+					// 有实例却被遮挡，或可见却没有实例
+					const bool bHasInstance = InstanceIndices[Index] != -1;
+					if (bHasInstance == IsBlockHidden(X, Y, Z))
+						DirtyCells.Add(Index);
+				}
+		}
+	}
+}
+
+bool AChunkActor::CanCullAgainst(const AChunkActor* Neighbor) const
+{
+	return Neighbor && LODLevel == 0 && Neighbor->LODLevel == 0
+		&& Neighbor->SizeX == SizeX && Neighbor->SizeY == SizeY && Neighbor->SizeZ == SizeZ;
+}
+
+void AChunkActor::SetLODLevel(int32 Level)
+{
+	Level = FMath::Clamp(Level, 0, MaxLODLevel);
+	if (Level == LODLevel)
+		return;
+
+	UE_LOG(H_LogChunkBlock, Verbose, TEXT("AChunkActor::SetLODLevel: chunk (%d,%d) LOD %d -> %d"),
+		ChunkCoordinates.X, ChunkCoordinates.Y, LODLevel, Level);
+
+	// 换级别：下一次刷新整体重建；旧的实例/网格保留到新网格提交时才替换
+	LODLevel = Level;
+	bInstancesDirty = true;
+	DirtyCells.Reset();
+
+	// 相邻区块能否拿本区块做边界遮挡随之改变，随本区块的刷新一起刷新
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(NeighborChunks); Slot++)
+	{
+		if (AChunkActor* Neighbor = NeighborChunks[Slot].Get())
+		{
+			// 本区块位于相邻区块的对侧槽位（0/1、2/3 互为对侧）
+			Neighbor->InvalidateBorder(Slot ^ 1);
+			DirtyNeighborMask |= 1 << Slot;
+		}
 	}
 }
 
-void AChunkActor::SetChunkVoxelData(const TArray<int32>& InVoxelData)
+void AChunkActor::SetChunkVoxelData(const FChunkVoxelStorage& InVoxelData)
 {
-	// 安全检查：长度必须匹配
-	if (InVoxelData.Num() != SizeX * SizeY * SizeZ)
+	// 安全检查：尺寸必须匹配
+	if (InVoxelData.GetSizeX() != SizeX || InVoxelData.GetSizeY() != SizeY || InVoxelData.GetSizeZ() != SizeZ)
 	{
 		UE_LOG(H_LogChunkBlock, Error, TEXT("SetChunkVoxelData: Data size mismatch! Expected %d, got %d"),
 			SizeX * SizeY * SizeZ, InVoxelData.Num());
 		return;
 	}
 
-	Blocks = InVoxelData;
-	bInstancesDirty = true; // 标记为脏，下次 RefreshRendering 会更新渲染
+	ReplaceVoxelData(InVoxelData); // 只标记变化的段，下次 RefreshRendering 会更新渲染
 }
 
-const TArray<int32>& AChunkActor::GetChunkVoxelData() const
+const FChunkVoxelStorage& AChunkActor::GetChunkVoxelData() const
 {
 	return Blocks;
 }
\ No newline at end of file
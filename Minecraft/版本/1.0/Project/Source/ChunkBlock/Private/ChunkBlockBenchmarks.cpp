@@ -0,0 +1,191 @@
+﻿#include "ChunkActor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Containers/Ticker.h"
+
+/**
+ * ChunkBlock 基准测试（PIE / 开发版中在控制台输入，或蓝图调用对应函数）
+ * 同步测试只测游戏线程调用耗时；跨帧测试测整帧耗时，渲染线程细节需配合 stat gpu / Unreal Insights 观察。
+ * 测试结束后恢复区块原状。
+ */
+
+//------------------------------------ 原地换材质 ------------------------------------
+// 对比方块原地换类型的两种方式：
+//  - InPlace：RetypeBlockInstanceAt，只改该实例的 CustomData[0]
+//  - RemoveAdd：RemoveBlockInstanceAt + AddBlockInstanceAt（旧做法，实例交换下标、搬移自定义数据）
+bool AChunkActor::BenchmarkRetype(int32 Iterations)
+{
+	if (!UsesInstances() || !HISMC || InstanceToCell.Num() == 0 || NumCustomDataFloatsPerInstance < 1)
+		return false;
+
+	Iterations = FMath::Max(1, Iterations);
+
+	// 取前若干个有实例的格子轮流修改，记录原 ID 以便恢复
+	const int32 NumCells = FMath::Min(64, InstanceToCell.Num());
+	TArray<int32> Cells;
+	TArray<int32> OriginalIDs;
+	for (int32 i = 0; i < NumCells; i++)
+	{
+		Cells.Add(InstanceToCell[i]);
+		OriginalIDs.Add(Blocks.Get(InstanceToCell[i]));
+	}
+
+	// 每轮交替写入另一个 ID 与原 ID，保证每次都是真实修改
+	auto GetTestID = [&OriginalIDs, NumCells](int32 Iteration)
+	{
+		const int32 Slot = Iteration % NumCells;
+		return (Iteration / NumCells) % 2 == 0 ? OriginalIDs[Slot] % 255 + 1 : OriginalIDs[Slot];
+	};
+
+	//=================== 原地换材质 ===================
+	double Start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		RetypeBlockInstanceAt(Cells[i % NumCells], GetTestID(i));
+	}
+	const double InPlaceSeconds = FPlatformTime::Seconds() - Start;
+
+	//=================== 删除再添加 ===================
+	Start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		const int32 CellIndex = Cells[i % NumCells];
+
+		FTransform Transform;
+		HISMC->GetInstanceTransform(InstanceIndices[CellIndex], Transform, /*bWorldSpace*/false);
+		RemoveBlockInstanceAt(CellIndex);
+		AddBlockInstanceAt(CellIndex, GetTestID(i), Transform);
+	}
+	const double RemoveAddSeconds = FPlatformTime::Seconds() - Start;
+
+	// 恢复原 ID（删除再添加已改变实例顺序，但映射保持一致）
+	for (int32 Slot = 0; Slot < NumCells; Slot++)
+		RetypeBlockInstanceAt(Cells[Slot], OriginalIDs[Slot]);
+
+	UE_LOG(H_LogChunkBlock, Display,
+		TEXT("BenchmarkRetype: chunk (%d,%d), %d instances, %d iterations\n")
+		TEXT("  InPlace   : %8.3f ms (%6.3f us/op)\n")
+		TEXT("  RemoveAdd : %8.3f ms (%6.3f us/op)  x%.1f"),
+		ChunkCoordinates.X, ChunkCoordinates.Y, HISMC->GetInstanceCount(), Iterations,
+		InPlaceSeconds * 1000.0, InPlaceSeconds * 1e6 / Iterations,
+		RemoveAddSeconds * 1000.0, RemoveAddSeconds * 1e6 / Iterations,
+		InPlaceSeconds > 0.0 ? RemoveAddSeconds / InPlaceSeconds : 0.0);
+	return true;
+}
+
+//------------------------------------ 挖掘裂纹 ------------------------------------
+// 模拟 Players 个玩家同时挖掘，逐帧给每个方块写一个新的 DestroyStage（最坏情况：每帧阶段都变化）
+// 第 0 轮：SetCustomDataValue + MarkRenderInstancesDirty（只提交变化的实例数据）
+// 第 1 轮：SetCustomDataValue + MarkRenderStateDirty（旧做法：每帧重建整个组件的渲染状态）
+// 由核心 Ticker 驱动跨真实帧运行，帧耗时包含帧末的渲染状态更新；建议先 t.MaxFPS 0 并关闭垂直同步
+bool AChunkActor::BenchmarkMining(int32 Players, int32 Frames)
+{
+	if (!UsesInstances() || !HISMC || InstanceToCell.Num() == 0 || NumCustomDataFloatsPerInstance < 2)
+		return false;
+
+	struct FMiningBenchmarkState
+	{
+		TWeakObjectPtr<AChunkActor> Chunk;
+		TArray<int32> Cells;
+		int32 Frames = 0;
+		int32 Frame = 0;
+		int32 Pass = 0;
+		double LastFrameTime = 0.0;
+		double UpdateSeconds[2] = { 0.0, 0.0 };
+		double FrameSeconds[2] = { 0.0, 0.0 };
+		double MaxFrameSeconds[2] = { 0.0, 0.0 };
+	};
+
+	TSharedRef<FMiningBenchmarkState> State = MakeShared<FMiningBenchmarkState>();
+	State->Chunk = this;
+	State->Frames = FMath::Max(2, Frames);
+
+	// 被挖的方块均匀取自现有实例
+	Players = FMath::Clamp(Players, 1, InstanceToCell.Num());
+	const int32 Step = InstanceToCell.Num() / Players;
+	for (int32 i = 0; i < Players; i++)
+		State->Cells.Add(InstanceToCell[i * Step]);
+
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([State](float) -> bool
+		{
+			AChunkActor* Chunk = State->Chunk.Get();
+			if (!Chunk || !Chunk->HISMC)
+				return false; // 区块已销毁/回收：放弃
+
+			// 上一帧的完整耗时（含帧末渲染状态/实例数据提交）
+			const double Now = FPlatformTime::Seconds();
+			if (State->Frame > 0)
+			{
+				const double FrameTime = Now - State->LastFrameTime;
+				State->FrameSeconds[State->Pass] += FrameTime;
+				State->MaxFrameSeconds[State->Pass] = FMath::Max(State->MaxFrameSeconds[State->Pass], FrameTime);
+			}
+			State->LastFrameTime = Now;
+
+			if (State->Frame == State->Frames)
+			{
+				// 本轮结束：恢复裂纹为实际挖掘进度
+				for (const int32 CellIndex : State->Cells)
+					Chunk->WriteDestroyStage(CellIndex, Chunk->GetDestroyStage(Chunk->MiningProgress.FindRef(CellIndex)));
+
+				State->Frame = 0;
+				if (++State->Pass < 2)
+					return true;
+
+				// 每轮第 0 帧之后的 Frames 帧都有完整计时
+				const int32 Measured = State->Frames;
+				UE_LOG(H_LogChunkBlock, Display,
+					TEXT("BenchmarkMining: chunk (%d,%d), %d instances, %d miners, %d frames per pass\n")
+					TEXT("  InstanceData     : update %7.3f us/frame, frame avg %7.3f ms, max %7.3f ms\n")
+					TEXT("  FullRenderState  : update %7.3f us/frame, frame avg %7.3f ms, max %7.3f ms"),
+					Chunk->ChunkCoordinates.X, Chunk->ChunkCoordinates.Y, Chunk->HISMC->GetInstanceCount(),
+					State->Cells.Num(), State->Frames,
+					State->UpdateSeconds[0] * 1e6 / State->Frames, State->FrameSeconds[0] * 1000.0 / Measured, State->MaxFrameSeconds[0] * 1000.0,
+					State->UpdateSeconds[1] * 1e6 / State->Frames, State->FrameSeconds[1] * 1000.0 / Measured, State->MaxFrameSeconds[1] * 1000.0);
+				return false;
+			}
+
+			// 每帧每个方块写一个不同的阶段
+			const int32 Stage = 1 + State->Frame % Chunk->NumDestroyStages;
+			const bool bFullRenderStateDirty = State->Pass == 1;
+			const double Start = FPlatformTime::Seconds();
+			for (const int32 CellIndex : State->Cells)
+				Chunk->WriteDestroyStage(CellIndex, Stage, bFullRenderStateDirty);
+			State->UpdateSeconds[State->Pass] += FPlatformTime::Seconds() - Start;
+
+			State->Frame++;
+			return true;
+		}));
+	return true;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GChunkBenchmarkRetypeCommand(
+	TEXT("Chunk.Benchmark.Retype"),
+	TEXT("Compare in-place block retype (custom data update) against remove + add on the first instanced chunk. Usage: Chunk.Benchmark.Retype [Iterations=10000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const int32 Iterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+			for (TActorIterator<AChunkActor> It(World); It; ++It)
+			{
+				if (It->BenchmarkRetype(Iterations))
+					return;
+			}
+			UE_LOG(H_LogChunkBlock, Warning, TEXT("Chunk.Benchmark.Retype: no instanced chunk with instances in world"));
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs GChunkBenchmarkMiningCommand(
+	TEXT("Chunk.Benchmark.Mining"),
+	TEXT("Simulate several players mining at once and compare per-frame cost of instance-data updates against full render-state rebuilds. Usage: Chunk.Benchmark.Mining [Players=8] [Frames=240]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const int32 Players = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 8;
+			const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 240;
+			for (TActorIterator<AChunkActor> It(World); It; ++It)
+			{
+				if (It->BenchmarkMining(Players, Frames))
+					return;
+			}
+			UE_LOG(H_LogChunkBlock, Warning, TEXT("Chunk.Benchmark.Mining: no instanced chunk with instances in world"));
+		}));
@@ -0,0 +1,239 @@
+﻿#include "ChunkMesher.h"
+
+//------------------------------------ FChunkMeshData ------------------------------------
+
+void FChunkMeshData::Reset()
+{
+	Vertices.Reset();
+	Triangles.Reset();
+	Normals.Reset();
+	UV0.Reset();
+	UV1.Reset();
+}
+
+//------------------------------------ FChunkMeshContext ------------------------------------
+
+bool FChunkMeshContext::IsOpaque(int32 X, int32 Y, int32 Z) const
+{
+	// 世界底部之下永远看不见；顶部之上是空气
+	if (Z < 0) return true;
+	if (Z >= Voxels->GetSizeZ()) return false;
+
+	const int32 SizeX = Voxels->GetSizeX();
+	const int32 SizeY = Voxels->GetSizeY();
+	if (X >= 0 && X < SizeX && Y >= 0 && Y < SizeY)
+		return Voxels->Get(X, Y, Z) != 0; // 目前所有非空气方块都不透明
+
+	// 越过水平边界：查询对应方向的相邻区块（PosX/NegX/PosY/NegY）
+	int32 Slot = INDEX_NONE;
+	if (Y >= 0 && Y < SizeY)
+		Slot = X >= SizeX ? 0 : 1;
+	else if (X >= 0 && X < SizeX)
+		Slot = Y >= SizeY ? 2 : 3;
+
+	const FChunkVoxelStorage* Neighbor = Slot != INDEX_NONE ? Neighbors[Slot] : nullptr;
+	if (!Neighbor)
+		return false;
+
+	return Neighbor->Get((X + SizeX) % SizeX, (Y + SizeY) % SizeY, Z) != 0;
+}
+
+//------------------------------------ FChunkMesher ------------------------------------
+
+FIntVector FChunkMesher::GetFaceOffset(EChunkFace Face)
+{
+	switch (Face)
+	{
+	case EChunkFace::PosX: return FIntVector(1, 0, 0);
+	case EChunkFace::NegX: return FIntVector(-1, 0, 0);
+	case EChunkFace::PosY: return FIntVector(0, 1, 0);
+	case EChunkFace::NegY: return FIntVector(0, -1, 0);
+	case EChunkFace::PosZ: return FIntVector(0, 0, 1);
+	case EChunkFace::NegZ: return FIntVector(0, 0, -1);
+	default: return FIntVector::ZeroValue;
+	}
+}
+
+void FChunkMesher::AddFace(FChunkMeshData& OutMesh, EChunkFace Face, const FIntVector& Cell, int32 SizeU, int32 SizeV,
+	int32 BlockID, float BlockSize, const FVector& Origin)
+{
+	// 法线轴与两条切向轴：U x V = 法线轴正方向（X x Y = Z，Y x Z = X，Z x X = Y）
+	const int32 Axis = static_cast<int32>(Face) / 2;
+	const bool bPositive = (static_cast<int32>(Face) % 2) == 0;
+	const int32 AxisU = (Axis + 1) % 3;
+	const int32 AxisV = (Axis + 2) % 3;
+
+	// 起始角（方块单位）：正向面位于方块的远端平面
+	FVector Corner(Cell.X, Cell.Y, Cell.Z);
+	if (bPositive)
+	{
+		Corner[Axis] += 1.0;
+	}
+
+	FVector EdgeU = FVector::ZeroVector;
+	FVector EdgeV = FVector::ZeroVector;
+	EdgeU[AxisU] = SizeU;
+	EdgeV[AxisV] = SizeV;
+
+	const FVector Corners[4] = { Corner, Corner + EdgeU, Corner + EdgeU + EdgeV, Corner + EdgeV };
+	const float DU[4] = { 0.f, (float)SizeU, (float)SizeU, 0.f };
+	const float DV[4] = { 0.f, 0.f, (float)SizeV, (float)SizeV };
+
+	const FVector Normal(GetFaceOffset(Face));
+	const FVector2D AtlasInfo((float)BlockID, (float)static_cast<int32>(Face));
+	const int32 BaseIndex = OutMesh.Vertices.Num();
+
+	for (int32 i = 0; i < 4; i++)
+	{
+		OutMesh.Vertices.Add(Origin + Corners[i] * BlockSize);
+		OutMesh.Normals.Add(Normal);
+		OutMesh.UV1.Add(AtlasInfo);
+
+		// 侧面让 V 沿 -Z 方向，贴图不会横躺或倒置；顶/底面直接用 XY
+		switch (Axis)
+		{
+		case 0:  OutMesh.UV0.Add(FVector2D(DU[i], SizeV - DV[i])); break;	// U=Y, V=Z
+		case 1:  OutMesh.UV0.Add(FVector2D(DV[i], SizeU - DU[i])); break;	// U=Z, V=X
+		default: OutMesh.UV0.Add(FVector2D(DU[i], DV[i])); break;			// U=X, V=Y
+		}
+	}
+
+	// UE 按 (P1-P2) x (P0-P2) 计算正面法线，正向面需逆序
+	if (bPositive)
+	{
+		OutMesh.Triangles.Append({ BaseIndex, BaseIndex + 2, BaseIndex + 1, BaseIndex, BaseIndex + 3, BaseIndex + 2 });
+	}
+	else
+	{
+		OutMesh.Triangles.Append({ BaseIndex, BaseIndex + 1, BaseIndex + 2, BaseIndex, BaseIndex + 2, BaseIndex + 3 });
+	}
+}
+
+void FChunkMesher::BuildGreedyMesh(const FChunkMeshContext& Context, int32 SectionIndex, FChunkMeshData& OutMesh)
+{
+	OutMesh.Reset();
+
+	const FChunkVoxelStorage& Voxels = *Context.Voxels;
+	if (Voxels.IsSectionEmpty(SectionIndex))
+		return; // 整段空气没有任何面
+
+	// 本段的体素范围 [Lo, Hi)
+	const int32 MinZ = Voxels.GetSectionMinZ(SectionIndex);
+	const int32 Lo[3] = { 0, 0, MinZ };
+	const int32 Hi[3] = { Voxels.GetSizeX(), Voxels.GetSizeY(), MinZ + Voxels.GetSectionSizeZ(SectionIndex) };
+
+	// 切片遮罩：暴露面的 BlockID（0 = 无面），按 U + V * DimU 存储
+	TArray<int32> Mask;
+
+	for (int32 FaceIndex = 0; FaceIndex < static_cast<int32>(EChunkFace::Count); FaceIndex++)
+	{
+		const EChunkFace Face = static_cast<EChunkFace>(FaceIndex);
+		const FIntVector Offset = GetFaceOffset(Face);
+		const int32 Axis = FaceIndex / 2;
+		const int32 AxisU = (Axis + 1) % 3;
+		const int32 AxisV = (Axis + 2) % 3;
+		const int32 DimU = Hi[AxisU] - Lo[AxisU];
+		const int32 DimV = Hi[AxisV] - Lo[AxisV];
+
+		Mask.SetNumUninitialized(DimU * DimV);
+
+		for (int32 Slice = Lo[Axis]; Slice < Hi[Axis]; Slice++)
+		{
+			//------ 构建遮罩 ------
+			bool bAnyFace = false;
+			FIntVector Cell;
+			Cell[Axis] = Slice;
+			for (int32 V = 0; V < DimV; V++)
+			{
+				Cell[AxisV] = Lo[AxisV] + V;
+				for (int32 U = 0; U < DimU; U++)
+				{
+					Cell[AxisU] = Lo[AxisU] + U;
+					int32& MaskID = Mask[U + V * DimU];
+					MaskID = 0;
+
+					const int32 ID = Voxels.Get(Cell.X, Cell.Y, Cell.Z);
+					if (ID != 0 && !Context.IsOpaque(Cell.X + Offset.X, Cell.Y + Offset.Y, Cell.Z + Offset.Z))
+					{
+						MaskID = ID;
+						bAnyFace = true;
+					}
+				}
+			}
+			if (!bAnyFace) continue;
+
+			//------ 贪心合并：先沿 U 延伸宽度，再沿 V 延伸整行 ------
+			for (int32 V = 0; V < DimV; V++)
+			{
+				for (int32 U = 0; U < DimU; )
+				{
+					const int32 ID = Mask[U + V * DimU];
+					if (ID == 0)
+					{
+						U++;
+						continue;
+					}
+
+					int32 Width = 1;
+					while (U + Width < DimU && Mask[U + Width + V * DimU] == ID)
+						Width++;
+
+					int32 Height = 1;
+					for (; V + Height < DimV; Height++)
+					{
+						bool bRowMatches = true;
+						for (int32 K = 0; K < Width; K++)
+						{
+							if (Mask[U + K + (V + Height) * DimU] != ID)
+							{
+								bRowMatches = false;
+								break;
+							}
+						}
+						if (!bRowMatches) break;
+					}
+
+					Cell[AxisU] = Lo[AxisU] + U;
+					Cell[AxisV] = Lo[AxisV] + V;
+					AddFace(OutMesh, Face, Cell, Width, Height, ID, Context.BlockSize, Context.Origin);
+
+					// 清除已输出的区域
+					for (int32 H = 0; H < Height; H++)
+						for (int32 K = 0; K < Width; K++)
+							Mask[U + K + (V + H) * DimU] = 0;
+
+					U += Width;
+				}
+			}
+		}
+	}
+}
+
+void FChunkMesher::BuildCulledMesh(const FChunkMeshContext& Context, int32 SectionIndex, FChunkMeshData& OutMesh)
+{
+	OutMesh.Reset();
+
+	const FChunkVoxelStorage& Voxels = *Context.Voxels;
+	if (Voxels.IsSectionEmpty(SectionIndex))
+		return; // 整段空气没有任何面
+
+	const int32 MinZ = Voxels.GetSectionMinZ(SectionIndex);
+	const int32 MaxZ = MinZ + Voxels.GetSectionSizeZ(SectionIndex);
+	for (int32 Z = MinZ; Z < MaxZ; Z++)
+		for (int32 Y = 0; Y < Voxels.GetSizeY(); Y++)
+			for (int32 X = 0; X < Voxels.GetSizeX(); X++)
+			{
+				const int32 ID = Voxels.Get(X, Y, Z);
+				if (ID == 0) continue;
+
+				const FIntVector Cell(X, Y, Z);
+				for (int32 FaceIndex = 0; FaceIndex < static_cast<int32>(EChunkFace::Count); FaceIndex++)
+				{
+					const EChunkFace Face = static_cast<EChunkFace>(FaceIndex);
+					const FIntVector Offset = GetFaceOffset(Face);
+					if (Context.IsOpaque(X + Offset.X, Y + Offset.Y, Z + Offset.Z)) continue; // 被相邻方块遮挡
+
+					AddFace(OutMesh, Face, Cell, 1, 1, ID, Context.BlockSize, Context.Origin);
+				}
+			}
+}
@@ -0,0 +1,520 @@
+﻿#include "ChunkVoxelStorage.h"
+
+//------------------------------------ FPalettedVoxelArray ------------------------------------
+
+uint8 FPalettedVoxelArray::GetRequiredBits(int32 PaletteNum)
+{
+	if (PaletteNum <= 1) return 0;
+	if (PaletteNum <= 2) return 1;
+	if (PaletteNum <= 4) return 2;
+	if (PaletteNum <= 16) return 4;
+	if (PaletteNum <= 256) return 8;
+	return 16;
+}
+
+void FPalettedVoxelArray::Init(int32 InNum, int32 FillID)
+{
+	NumVoxels = FMath::Max(0, InNum);
+	BitsPerIndex = 0;
+	Words.Reset();
+	Palette.Reset();
+	Palette.Add(static_cast<uint16>(FMath::Clamp(FillID, 0, (int32)MAX_uint16)));
+}
+
+void FPalettedVoxelArray::Set(int32 Index, int32 BlockID)
+{
+	const uint16 Value = static_cast<uint16>(FMath::Clamp(BlockID, 0, (int32)MAX_uint16));
+
+	int32 PaletteIndex = Palette.Find(Value);
+	if (PaletteIndex == INDEX_NONE)
+	{
+		// 新 ID：加入调色板，超出当前位宽可表示的范围时扩大位宽
+		PaletteIndex = Palette.Add(Value);
+		const uint8 RequiredBits = GetRequiredBits(Palette.Num());
+		if (RequiredBits > BitsPerIndex)
+		{
+			Repack(RequiredBits);
+		}
+	}
+
+	// 单一 ID 且写入的就是该 ID
+	if (BitsPerIndex == 0)
+		return;
+
+	WriteIndex(Index, static_cast<uint32>(PaletteIndex));
+}
+
+void FPalettedVoxelArray::Repack(uint8 NewBits, const TArray<int32>* Remap)
+{
+	TArray<uint32> NewWords;
+	if (NewBits > 0)
+	{
+		const int64 TotalBits = static_cast<int64>(NumVoxels) * NewBits;
+		NewWords.SetNumZeroed(static_cast<int32>((TotalBits + 31) / 32));
+
+		const uint32 OldMask = BitsPerIndex > 0 ? (1u << BitsPerIndex) - 1u : 0u;
+		for (int32 Index = 0; Index < NumVoxels; Index++)
+		{
+			uint32 PaletteIndex = 0;
+			if (BitsPerIndex > 0)
+			{
+				const uint32 OldOffset = static_cast<uint32>(Index) * BitsPerIndex;
+				PaletteIndex = (Words[OldOffset >> 5] >> (OldOffset & 31u)) & OldMask;
+			}
+			if (Remap)
+			{
+				PaletteIndex = static_cast<uint32>((*Remap)[PaletteIndex]);
+			}
+
+			const uint32 NewOffset = static_cast<uint32>(Index) * NewBits;
+			NewWords[NewOffset >> 5] |= PaletteIndex << (NewOffset & 31u);
+		}
+	}
+
+	Words = MoveTemp(NewWords);
+	BitsPerIndex = NewBits;
+}
+
+void FPalettedVoxelArray::SetFromArray(const int32* Data, int32 InNum)
+{
+	NumVoxels = FMath::Max(0, InNum);
+	Palette.Reset();
+	Words.Reset();
+	BitsPerIndex = 0;
+
+	if (NumVoxels == 0)
+	{
+		Palette.Add(0);
+		return;
+	}
+
+	// 第一遍：收集调色板（相邻体素通常相同，缓存上一次命中）
+	uint16 LastValue = 0;
+	int32 LastIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < NumVoxels; Index++)
+	{
+		const uint16 Value = static_cast<uint16>(FMath::Clamp(Data[Index], 0, (int32)MAX_uint16));
+		if (LastIndex != INDEX_NONE && Value == LastValue)
+			continue;
+
+		LastValue = Value;
+		LastIndex = Palette.AddUnique(Value);
+	}
+
+	// 第二遍：按最终位宽直接写入下标
+	BitsPerIndex = GetRequiredBits(Palette.Num());
+	if (BitsPerIndex == 0)
+		return;
+
+	const int64 TotalBits = static_cast<int64>(NumVoxels) * BitsPerIndex;
+	Words.SetNumZeroed(static_cast<int32>((TotalBits + 31) / 32));
+
+	LastIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < NumVoxels; Index++)
+	{
+		const uint16 Value = static_cast<uint16>(FMath::Clamp(Data[Index], 0, (int32)MAX_uint16));
+		if (LastIndex == INDEX_NONE || Value != LastValue)
+		{
+			LastValue = Value;
+			LastIndex = Palette.Find(Value);
+		}
+
+		const uint32 BitOffset = static_cast<uint32>(Index) * BitsPerIndex;
+		Words[BitOffset >> 5] |= static_cast<uint32>(LastIndex) << (BitOffset & 31u);
+	}
+}
+
+bool FPalettedVoxelArray::SetPacked(int32 InNum, int32 InBits, TArray<uint16>&& InPalette, TArray<uint32>&& InWords)
+{
+	// 只接受 GetRequiredBits 可能产生的位宽，保证下标不跨字
+	const bool bValidBits = InBits == 0 || InBits == 1 || InBits == 2 || InBits == 4 || InBits == 8 || InBits == 16;
+	if (InNum < 0 || !bValidBits || InPalette.Num() == 0 || InPalette.Num() > (1 << InBits)
+		|| InWords.Num() != GetNumWords(InNum, InBits))
+	{
+		return false;
+	}
+
+	// 调色板未占满位宽时，下标可能越界（数据损坏）：逐个检查
+	if (InBits > 0 && InPalette.Num() < (1 << InBits))
+	{
+		const uint32 Mask = (1u << InBits) - 1u;
+		for (int32 Index = 0; Index < InNum; Index++)
+		{
+			const uint32 BitOffset = static_cast<uint32>(Index) * InBits;
+			if (static_cast<int32>((InWords[BitOffset >> 5] >> (BitOffset & 31u)) & Mask) >= InPalette.Num())
+				return false;
+		}
+	}
+
+	NumVoxels = InNum;
+	BitsPerIndex = static_cast<uint8>(InBits);
+	Palette = MoveTemp(InPalette);
+	Words = MoveTemp(InWords);
+	return true;
+}
+
+void FPalettedVoxelArray::ToArray(int32* OutData) const
+{
+	for (int32 Index = 0; Index < NumVoxels; Index++)
+	{
+		OutData[Index] = Get(Index);
+	}
+}
+
+void FPalettedVoxelArray::Compact()
+{
+	if (BitsPerIndex == 0)
+		return;
+
+	// 统计实际使用的调色板项
+	TArray<bool> Used;
+	Used.SetNumZeroed(Palette.Num());
+	const uint32 Mask = (1u << BitsPerIndex) - 1u;
+	for (int32 Index = 0; Index < NumVoxels; Index++)
+	{
+		const uint32 BitOffset = static_cast<uint32>(Index) * BitsPerIndex;
+		Used[(Words[BitOffset >> 5] >> (BitOffset & 31u)) & Mask] = true;
+	}
+
+	// 旧下标 -> 新下标
+	TArray<int32> Remap;
+	Remap.Init(0, Palette.Num());
+	TArray<uint16> NewPalette;
+	for (int32 PaletteIndex = 0; PaletteIndex < Palette.Num(); PaletteIndex++)
+	{
+		if (Used[PaletteIndex])
+		{
+			Remap[PaletteIndex] = NewPalette.Add(Palette[PaletteIndex]);
+		}
+	}
+
+	if (NewPalette.Num() == Palette.Num() && GetRequiredBits(NewPalette.Num()) == BitsPerIndex)
+		return;
+
+	Repack(GetRequiredBits(NewPalette.Num()), &Remap);
+	Palette = MoveTemp(NewPalette);
+	Palette.Shrink();
+	Words.Shrink();
+}
+
+//------------------------------------ FChunkVoxelStorage ------------------------------------
+
+void FChunkVoxelStorage::Init(int32 InSizeX, int32 InSizeY, int32 InSizeZ, int32 FillID)
+{
+	SizeX = FMath::Max(0, InSizeX);
+	SizeY = FMath::Max(0, InSizeY);
+	SizeZ = FMath::Max(0, InSizeZ);
+
+	const int32 NumSections = SizeX * SizeY > 0 ? (SizeZ + SectionHeight - 1) / SectionHeight : 0;
+	Sections.SetNum(NumSections);
+	for (int32 SectionIndex = 0; SectionIndex < NumSections; SectionIndex++)
+	{
+		Sections[SectionIndex].Init(SizeX * SizeY * GetSectionSizeZ(SectionIndex), FillID);
+	}
+}
+
+bool FChunkVoxelStorage::SetFromArray(const TArray<int32>& Data, int32 InSizeX, int32 InSizeY, int32 InSizeZ)
+{
+	if (InSizeX < 0 || InSizeY < 0 || InSizeZ < 0 || Data.Num() != InSizeX * InSizeY * InSizeZ)
+		return false;
+
+	Init(InSizeX, InSizeY, InSizeZ, 0);
+
+	// 每段在一维数组中是连续区间，逐段构建
+	const int32 SectionVolume = GetSectionVolume();
+	for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+	{
+		FPalettedVoxelArray& Section = Sections[SectionIndex];
+		Section.SetFromArray(Data.GetData() + SectionIndex * SectionVolume, Section.Num());
+	}
+	return true;
+}
+
+void FChunkVoxelStorage::ToArray(TArray<int32>& OutData) const
+{
+	OutData.SetNumUninitialized(Num());
+
+	const int32 SectionVolume = GetSectionVolume();
+	for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+	{
+		Sections[SectionIndex].ToArray(OutData.GetData() + SectionIndex * SectionVolume);
+	}
+}
+
+void FChunkVoxelStorage::Compact()
+{
+	for (FPalettedVoxelArray& Section : Sections)
+	{
+		Section.Compact();
+	}
+}
+
+SIZE_T FChunkVoxelStorage::GetAllocatedSize() const
+{
+	SIZE_T Size = Sections.GetAllocatedSize();
+	for (const FPalettedVoxelArray& Section : Sections)
+	{
+		Size += Section.GetAllocatedSize();
+	}
+	return Size;
+}
+
+bool FChunkVoxelStorage::IsSectionUniform(int32 SectionIndex, int32* OutBlockID) const
+{
+	const FPalettedVoxelArray& Section = Sections[SectionIndex];
+	if (!Section.IsUniform())
+		return false;
+
+	if (OutBlockID)
+	{
+		*OutBlockID = Section.Get(0);
+	}
+	return true;
+}
+
+void FChunkVoxelStorage::SetSectionUniform(int32 SectionIndex, int32 BlockID)
+{
+	FPalettedVoxelArray& Section = Sections[SectionIndex];
+	Section.Init(Section.Num(), BlockID);
+}
+
+bool FChunkVoxelStorage::SetSectionFromArray(int32 SectionIndex, const int32* Data, int32 InNum)
+{
+	FPalettedVoxelArray& Section = Sections[SectionIndex];
+	if (InNum != Section.Num())
+		return false;
+
+	Section.SetFromArray(Data, InNum);
+	return true;
+}
+
+bool FChunkVoxelStorage::SetSectionPacked(int32 SectionIndex, int32 Bits, TArray<uint16>&& InPalette, TArray<uint32>&& InWords)
+{
+	FPalettedVoxelArray& Section = Sections[SectionIndex];
+	return Section.SetPacked(Section.Num(), Bits, MoveTemp(InPalette), MoveTemp(InWords));
+}
+
+void FChunkVoxelStorage::ToColumnRuns(TArray<FVoxelColumnRun>& OutRuns) const
+{
+	const int32 LayerVolume = SizeX * SizeY;
+	for (int32 Column = 0; Column < LayerVolume; Column++)
+	{
+		int32 RunID = INDEX_NONE;
+		int32 RunLength = 0;
+		auto FlushRun = [&OutRuns, &RunID, &RunLength]()
+		{
+			for (; RunLength > 0; RunLength -= MAX_uint16)
+			{
+				OutRuns.Add({ static_cast<uint16>(RunID), static_cast<uint16>(FMath::Min(RunLength, (int32)MAX_uint16)) });
+			}
+			RunLength = 0;
+		};
+
+		for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+		{
+			const FPalettedVoxelArray& Section = Sections[SectionIndex];
+			const int32 SectionSizeZ = GetSectionSizeZ(SectionIndex);
+
+			// 整段同一 ID：直接延长游程
+			if (Section.IsUniform())
+			{
+				const int32 ID = Section.Get(0);
+				if (ID != RunID)
+				{
+					FlushRun();
+					RunID = ID;
+				}
+				RunLength += SectionSizeZ;
+				continue;
+			}
+
+			for (int32 Index = Column; Index < SectionSizeZ * LayerVolume; Index += LayerVolume)
+			{
+				const int32 ID = Section.Get(Index);
+				if (ID != RunID)
+				{
+					FlushRun();
+					RunID = ID;
+				}
+				RunLength++;
+			}
+		}
+		FlushRun();
+	}
+}
+
+bool FChunkVoxelStorage::SetFromColumnRuns(const FVoxelColumnRun* Runs, int32 NumRuns, int32 InSizeX, int32 InSizeY, int32 InSizeZ)
+{
+	if (InSizeX < 0 || InSizeY < 0 || InSizeZ < 0 || NumRuns < 0)
+		return false;
+
+	// 先校验：记录每列的第一个游程，保证后面的填充不会越界
+	const int32 LayerVolume = InSizeX * InSizeY;
+	TArray<int32> ColumnRun;
+	ColumnRun.SetNumUninitialized(LayerVolume);
+
+	int32 RunIndex = 0;
+	for (int32 Column = 0; Column < LayerVolume; Column++)
+	{
+		ColumnRun[Column] = RunIndex;
+		for (int32 Height = 0; Height < InSizeZ; RunIndex++)
+		{
+			if (RunIndex >= NumRuns || Runs[RunIndex].Length == 0)
+				return false;
+			Height += Runs[RunIndex].Length;
+			if (Height > InSizeZ)
+				return false;
+		}
+	}
+	if (RunIndex != NumRuns)
+		return false;
+
+	Init(InSizeX, InSizeY, InSizeZ, 0);
+
+	// 逐段展开：每列记录当前游程与其剩余长度，只在段内缓冲区中展开一段
+	TArray<int32> ColumnRemaining;
+	ColumnRemaining.SetNumUninitialized(LayerVolume);
+	for (int32 Column = 0; Column < LayerVolume; Column++)
+	{
+		ColumnRemaining[Column] = LayerVolume > 0 && NumRuns > 0 ? Runs[ColumnRun[Column]].Length : 0;
+	}
+
+	TArray<int32> SectionData;
+	for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+	{
+		const int32 SectionSizeZ = GetSectionSizeZ(SectionIndex);
+		SectionData.SetNumUninitialized(SectionSizeZ * LayerVolume);
+
+		bool bUniform = true;
+		int32 FirstID = INDEX_NONE;
+		for (int32 Column = 0; Column < LayerVolume; Column++)
+		{
+			int32& Run = ColumnRun[Column];
+			int32& Remaining = ColumnRemaining[Column];
+			for (int32 LocalZ = 0; LocalZ < SectionSizeZ; )
+			{
+				if (Remaining == 0)
+					Remaining = Runs[++Run].Length;
+
+				const int32 ID = Runs[Run].BlockID;
+				const int32 Span = FMath::Min(Remaining, SectionSizeZ - LocalZ);
+				if (FirstID == INDEX_NONE)
+					FirstID = ID;
+				bUniform &= ID == FirstID;
+				for (int32 End = LocalZ + Span; LocalZ < End; LocalZ++)
+				{
+					SectionData[Column + LocalZ * LayerVolume] = ID;
+				}
+				Remaining -= Span;
+			}
+		}
+
+		// 整段同一 ID（深层石头、地表以上的空气）不经过调色板构建
+		if (bUniform)
+			SetSectionUniform(SectionIndex, FirstID);
+		else
+			Sections[SectionIndex].SetFromArray(SectionData.GetData(), SectionData.Num());
+	}
+	return true;
+}
+
+void FChunkVoxelStorage::Downsample(const FChunkVoxelStorage& Source, int32 Factor, FChunkVoxelStorage& Out)
+{
+	Factor = FMath::Max(1, Factor);
+	if (Factor == 1)
+	{
+		Out = Source;
+		return;
+	}
+
+	const int32 OutSizeX = FMath::DivideAndRoundUp(Source.SizeX, Factor);
+	const int32 OutSizeY = FMath::DivideAndRoundUp(Source.SizeY, Factor);
+	const int32 OutSizeZ = FMath::DivideAndRoundUp(Source.SizeZ, Factor);
+	Out.Init(OutSizeX, OutSizeY, OutSizeZ, 0);
+
+	const int32 SurfaceWeight = Factor * Factor * Factor;
+	TArray<int32> SectionData;
+	TArray<TPair<int32, int32>, TInlineAllocator<8>> Candidates; // (ID, 权重)
+
+	for (int32 OutSection = 0; OutSection < Out.GetNumSections(); OutSection++)
+	{
+		const int32 OutMinZ = Out.GetSectionMinZ(OutSection);
+		const int32 OutSectionSizeZ = Out.GetSectionSizeZ(OutSection);
+
+		// 覆盖的源数据全是同一 ID 的均匀段：整段直接得出结果
+		const int32 SourceMinZ = OutMinZ * Factor;
+		const int32 SourceMaxZ = FMath::Min((OutMinZ + OutSectionSizeZ) * Factor, Source.SizeZ); // 不含
+		int32 UniformID = INDEX_NONE;
+		bool bUniform = true;
+		for (int32 S = SourceMinZ / SectionHeight; S <= (SourceMaxZ - 1) / SectionHeight && bUniform; S++)
+		{
+			int32 SectionID = 0;
+			bUniform = Source.IsSectionUniform(S, &SectionID) && (UniformID == INDEX_NONE || UniformID == SectionID);
+			UniformID = SectionID;
+		}
+		if (bUniform)
+		{
+			Out.SetSectionUniform(OutSection, UniformID);
+			continue;
+		}
+
+		SectionData.SetNumUninitialized(OutSizeX * OutSizeY * OutSectionSizeZ);
+		for (int32 OZ = 0; OZ < OutSectionSizeZ; OZ++)
+		{
+			const int32 Z0 = (OutMinZ + OZ) * Factor;
+			const int32 Z1 = FMath::Min(Z0 + Factor, Source.SizeZ);
+			for (int32 OY = 0; OY < OutSizeY; OY++)
+			{
+				const int32 Y0 = OY * Factor;
+				const int32 Y1 = FMath::Min(Y0 + Factor, Source.SizeY);
+				for (int32 OX = 0; OX < OutSizeX; OX++)
+				{
+					const int32 X0 = OX * Factor;
+					const int32 X1 = FMath::Min(X0 + Factor, Source.SizeX);
+
+					int32 NumAir = 0;
+					int32 NumVoxels = 0;
+					Candidates.Reset();
+					for (int32 Z = Z0; Z < Z1; Z++)
+						for (int32 Y = Y0; Y < Y1; Y++)
+							for (int32 X = X0; X < X1; X++)
+							{
+								NumVoxels++;
+								const int32 ID = Source.Get(X, Y, Z);
+								if (ID == 0)
+								{
+									NumAir++;
+									continue;
+								}
+
+								// 上方是空气（或世界顶部）的方块是地表，远看时能看到的就是它
+								const bool bSurface = Z + 1 >= Source.SizeZ || Source.Get(X, Y, Z + 1) == 0;
+								const int32 Weight = bSurface ? SurfaceWeight : 1;
+
+								TPair<int32, int32>* Found = Candidates.FindByPredicate([ID](const TPair<int32, int32>& C) { return C.Key == ID; });
+								if (Found)
+									Found->Value += Weight;
+								else
+									Candidates.Emplace(ID, Weight);
+							}
+
+					int32 BestID = 0;
+					if (NumAir * 2 <= NumVoxels)
+					{
+						int32 BestWeight = 0;
+						for (const TPair<int32, int32>& C : Candidates)
+						{
+							if (C.Value > BestWeight)
+							{
+								BestWeight = C.Value;
+								BestID = C.Key;
+							}
+						}
+					}
+					SectionData[OX + OY * OutSizeX + OZ * OutSizeX * OutSizeY] = BestID;
+				}
+			}
+		}
+		Out.SetSectionFromArray(OutSection, SectionData.GetData(), SectionData.Num());
+	}
+}
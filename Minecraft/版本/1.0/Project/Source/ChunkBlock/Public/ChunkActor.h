@@ -4,16 +4,35 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "IChunkInterface.h" 
+#include "ChunkVoxelStorage.h"
+#include "ChunkMesher.h"
 #include "ChunkActor.generated.h"
 DECLARE_LOG_CATEGORY_EXTERN(H_LogChunkBlock, Log, All);
 class UHierarchicalInstancedStaticMeshComponent;
+class UProceduralMeshComponent;
 class UMaterialInterface;
 
+/** 区块渲染方式 */
+UENUM(BlueprintType)
+enum class EChunkRenderMode : uint8
+{
+	// 每个非空方块一个 HISMC 实例（材质读取 PerInstanceCustomData）
+	Instanced	UMETA(DisplayName = "HISM Instances"),
+
+	// 只输出暴露面，合成一个 ProceduralMesh（材质读取 UV0/UV1）
+	CulledMesh	UMETA(DisplayName = "Face-Culled Mesh"),
+
+	// 面剔除 + 同平面同 ID 面合并为大矩形（UV0 平铺），顶点数最少
+	GreedyMesh	UMETA(DisplayName = "Greedy Mesh"),
+};
+
 /**
- * AChunkActor 责任是维护一个 SizeXSizeYSizeZ 的格子数组（Blocks），
+ * AChunkActor 责任是维护一个 SizeXSizeYSizeZ 的格子数组（Blocks，调色板压缩存储），
  * 用单个 UHierarchicalInstancedStaticMeshComponent(HISMC) 渲染非空方块。
  * 不同方块材质问题使用Atlas图集＋每实例自定义数据解决。
  * 渲染可通过全量重建或增量增删实例完成，代码两种策略都有体现。
+ * RenderMode = CulledMesh 时改用 ProceduralMeshComponent，只渲染与空气相邻的面。
+ * 远处区块按 LODLevel 降采样体素，改用贪心网格渲染。
  */
 
 UCLASS()
@@ -35,18 +54,84 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Chunk")
 	int32 GetBlock(int32 X, int32 Y, int32 Z) const;
 
+	// 批量编辑（爆炸、填充、放置建筑）：Begin 之后的 SetBlock 只修改数据并记录脏区，
+	// Commit 时作为一次增量同步（实例模式一次建树、一次渲染标脏；网格模式只重建脏段），变更过多时自动改为全量重建。可嵌套。
+	UFUNCTION(BlueprintCallable, Category = "Chunk")
+	void BeginEditBatch();
+
+	UFUNCTION(BlueprintCallable, Category = "Chunk")
+	void CommitEditBatch();
+
+	UFUNCTION(BlueprintPure, Category = "Chunk")
+	bool IsInEditBatch() const { return EditBatchDepth > 0; }
+
 	// 重新生成 HISMC 实例（全量重建）
 	UFUNCTION(BlueprintCallable, Category = "Chunk")
 	void UpdateInstances();
 
+	// 重新生成网格（CulledMesh / GreedyMesh 模式；bAsyncMeshing 时在工作线程构建）
+	// 只重建 DirtySections 中的段；没有脏段时重建全部
+	UFUNCTION(BlueprintCallable, Category = "Chunk")
+	void UpdateMesh();
+
+	// 当前渲染的三角形数量（实例模式 = 实例数 x 方块网格三角形数）
+	UFUNCTION(BlueprintPure, Category = "Chunk")
+	int32 GetRenderedTriangleCount() const;
+
+	// 上次全量重建时因被完全包围而跳过的实例数量
+	UFUNCTION(BlueprintPure, Category = "Chunk")
+	int32 GetCulledInstanceCount() const { return CulledInstanceCount; }
+
+	//------ 挖掘进度（DestroyStage） ------
+	// 设置挖掘进度（0..1）：量化为 0..NumDestroyStages 的裂纹阶段写入该方块实例的 CustomData[1]，
+	// 阶段变化时只提交这一个实例的数据，不重建整个组件的渲染状态。裂纹仅实例模式可见；空气返回 false
+	UFUNCTION(BlueprintCallable, Category = "Chunk|Mining")
+	bool SetMiningProgress(int32 X, int32 Y, int32 Z, float Progress);
+
+	UFUNCTION(BlueprintPure, Category = "Chunk|Mining")
+	float GetMiningProgress(int32 X, int32 Y, int32 Z) const;
+
+	// 停止挖掘：进度清零，裂纹消失
+	UFUNCTION(BlueprintCallable, Category = "Chunk|Mining")
+	void ClearMiningProgress(int32 X, int32 Y, int32 Z);
+
+	// 每帧推进挖掘：UBlockType::Durability 秒挖完（再除以 MiningSpeed），不可破坏的方块不推进。
+	// 挖完时移除方块并返回 true
+	UFUNCTION(BlueprintCallable, Category = "Chunk|Mining")
+	bool TickMining(int32 X, int32 Y, int32 Z, float DeltaSeconds, float MiningSpeed, float& OutProgress);
+
+	// 基准测试：原地换材质 vs 删除再添加（控制台 Chunk.Benchmark.Retype）；区块无实例时返回 false。结束后恢复原状
+	UFUNCTION(BlueprintCallable, Category = "Chunk|Debug")
+	bool BenchmarkRetype(int32 Iterations = 10000);
+
+	// 基准测试：Players 个方块同时被挖，逐帧写 DestroyStage，分别用实例数据更新 / 整组件重建渲染状态各跑 Frames 帧，
+	// 比较帧耗时（控制台 Chunk.Benchmark.Mining）；区块无实例时返回 false
+	UFUNCTION(BlueprintCallable, Category = "Chunk|Debug")
+	bool BenchmarkMining(int32 Players = 8, int32 Frames = 240);
+
 	// 体素数据接口实现
-	virtual void SetChunkVoxelData(const TArray<int32>& InVoxelData) override;
-	virtual const TArray<int32>& GetChunkVoxelData() const override;
+	virtual void SetChunkVoxelData(const FChunkVoxelStorage& InVoxelData) override;
+	virtual const FChunkVoxelStorage& GetChunkVoxelData() const override;
 protected:
 	virtual void BeginPlay() override;
 
 	FORCEINLINE int32 ToIndex(int32 X, int32 Y, int32 Z) const { return X + Y * SizeX + Z * SizeX * SizeY; }
 
+	// 按 RenderMode 全量重建渲染数据
+	void RebuildRendering();
+
+	// 网格构建输入：指向本区块与可参与遮挡判断的相邻区块的体素（仅在游戏线程、同步构建时使用）
+	FChunkMeshContext MakeMeshContext() const;
+
+	// 按网格模式构建指定的段（纯数据，可在工作线程调用）；OutMeshes 与 Sections 一一对应
+	// LODFactor > 1 时先把 Context.Voxels 降采样，Sections 为降采样后的段（此时不使用相邻区块）
+	static void BuildMeshData(EChunkRenderMode Mode, const FChunkMeshContext& Context, int32 LODFactor,
+		const TArray<int32>& Sections, TArray<FChunkMeshData>& OutMeshes);
+
+	// 把构建好的段提交到 ChunkMesh（游戏线程）；空网格清除对应段
+	// bReplaceAll：整体重建（LOD 切换、全量重建），先清除全部旧段与 HISMC 实例，新旧表示在同一帧交接
+	void ApplyMeshData(const TArray<int32>& Sections, const TArray<FChunkMeshData>& Meshes, bool bReplaceAll);
+
 	// 区块格子尺寸
 	UPROPERTY(EditAnywhere, Category = "Chunk")
 	int32 SizeX = 16;
@@ -60,9 +145,9 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Chunk")
 	float BlockSize = 128.0f;
 
-	// 存储 BlockID（1D）
+	// 存储 BlockID（1D 下标布局，按 16 高分段调色板压缩；整段空气/石头不分配数组）
 	UPROPERTY()
-	TArray<int32> Blocks;
+	FChunkVoxelStorage Blocks;
 
 	// 延迟同步标志：当批量修改 Blocks（bUpdateMesh == false）时设为 true，
 	// 后续调用 UpdateInstances() 会把渲染实例与 Blocks 同步并清除此标志。
@@ -82,6 +167,118 @@ protected:
 	bool AddBlockInstanceAt(int32 CellIndex, int32 BlockID, const FTransform& Transform);
 	bool RemoveBlockInstanceAt(int32 CellIndex);
 
+	// 已有实例的格子换成另一种非空方块：只更新该实例的自定义数据（无实例时返回 false）
+	bool RetypeBlockInstanceAt(int32 CellIndex, int32 BlockID);
+
+	//------ 挖掘进度 ------
+	// 进行中的挖掘：格子下标 -> 进度（0..1）
+	TMap<int32, float> MiningProgress;
+
+	// 进度 -> 裂纹阶段（0 = 完好）
+	int32 GetDestroyStage(float Progress) const;
+
+	// 把裂纹阶段写入该格实例的 CustomData[1]；bFullRenderStateDirty 仅供基准测试对比旧做法
+	bool WriteDestroyStage(int32 CellIndex, int32 Stage, bool bFullRenderStateDirty = false);
+
+	// 清除全部挖掘进度（整块数据替换时）
+	void ResetMiningProgress();
+
+	// 方块实例的局部变换
+	FTransform GetBlockTransform(int32 X, int32 Y, int32 Z) const;
+
+	//------ 隐藏方块剔除（实例模式） ------
+	// 该格是否不透明；X/Y 越界时查询相邻区块，Z 越界：下方视为不透明（世界底部不可见），上方视为空气
+	bool IsOpaqueAt(int32 X, int32 Y, int32 Z) const;
+
+	// 六个方向都被不透明方块包围
+	bool IsBlockHidden(int32 X, int32 Y, int32 Z) const;
+
+	// 之前被剔除的非空方块若尚无实例则补上（相邻方块被挖掉后调用）
+	void EnsureBlockInstance(int32 X, int32 Y, int32 Z);
+
+	// 挖掉 (X,Y,Z) 后显露出六个相邻方块（含相邻区块的边界方块）
+	void RevealNeighborsOf(int32 X, int32 Y, int32 Z);
+
+	// 水平相邻区块：下标与 EChunkFace 的 PosX/NegX/PosY/NegY 一致
+	TWeakObjectPtr<AChunkActor> NeighborChunks[4];
+
+	// 相邻区块变化（登记/解除/LOD 切换）后重新判断本区块朝向 Slot 一侧的边界方块与边界面
+	void InvalidateBorder(int32 Slot);
+
+	// 实例模式：DirtyBorderMask 中各侧实例有无与可见性不符的贴边格并入 DirtyCells
+	void CollectDirtyBorderCells();
+
+	// 相邻区块可用于边界遮挡判断：尺寸一致且同为完整精度
+	bool CanCullAgainst(const AChunkActor* Neighbor) const;
+
+	//------ 距离 LOD ------
+	// 当前细节级别：0 = 完整精度；N > 0 时按 2^N 倍降采样，用贪心网格渲染（不使用 HISMC 实例）
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "Chunk|LOD")
+	int32 LODLevel = 0;
+
+	// 最大 LOD 级别（3 = 8 倍降采样）
+	static constexpr int32 MaxLODLevel = 3;
+
+	FORCEINLINE int32 GetLODFactor() const { return 1 << LODLevel; }
+
+	// 当前是否用 HISMC 实例渲染（实例模式且为完整精度）
+	FORCEINLINE bool UsesInstances() const { return RenderMode == EChunkRenderMode::Instanced && LODLevel == 0; }
+
+	//------ 脏区跟踪 ------
+	// 实例模式：待同步的变更格下标（由 ApplyCellDelta 逐格增删实例）
+	TSet<int32> DirtyCells;
+
+	// 网格模式：待重建的段（下标 = 体素段，对应 ChunkMesh 的同号网格段）
+	TBitArray<> DirtySections;
+
+	// 已发起但结果尚未提交的段：新构建会取代在途构建，需把这些段一并带上
+	TBitArray<> PendingMeshSections;
+
+	// 本次编辑波及、需要刷新的相邻区块（位下标与 NeighborChunks 一致）
+	uint8 DirtyNeighborMask = 0;
+
+	// 实例模式：相邻区块变化后待重新判断可见性的边界（位下标与 NeighborChunks 一致），刷新时才逐格检查
+	uint8 DirtyBorderMask = 0;
+
+	// 已完成过一次全量重建（之后才能走增量路径）
+	bool bHasRendered = false;
+
+	// 记录 (X,Y,Z) 的修改：变更格、所在段及共享边界的上下段、贴边时相邻区块的同号段
+	void MarkCellDirty(int32 X, int32 Y, int32 Z);
+
+	void MarkSectionDirty(int32 SectionIndex);
+	void MarkAllSectionsDirty();
+
+	// 相邻区块（网格模式）的同号段依赖本区块边界，标脏并记入 DirtyNeighborMask
+	void InvalidateNeighborSection(int32 Slot, int32 SectionIndex);
+
+	// 刷新 DirtyNeighborMask 中的相邻区块
+	void FlushDirtyNeighbors();
+
+	// 实例模式：把 DirtyCells 同步到 HISMC，变更过多时改为全量重建
+	void ApplyCellDelta();
+
+	// 整块替换体素：逐段比较编码，只把变化的段（或格）记为脏区，而不是整块重建
+	void ReplaceVoxelData(const FChunkVoxelStorage& NewData);
+
+	//------ 批量编辑 ------
+	int32 EditBatchDepth = 0;
+
+	// 正在提交批次：单格增删不各自标脏渲染状态
+	bool bApplyingEditBatch = false;
+
+	// 变更格数超过 当前实例数 x 该比例（至少 64）时改为全量重建
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float EditBatchRebuildRatio = 0.25f;
+
+	// 跳过六面都被遮挡的方块（仅实例模式；网格模式本身只输出暴露面）
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
+	bool bCullHiddenBlocks = true;
+
+	// 上次全量重建时被剔除的实例数
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "Chunk|Stats")
+	int32 CulledInstanceCount = 0;
+
 	// 单个 HISMC 用于所有方块实例化渲染
 	UPROPERTY(VisibleAnywhere, Category = "Chunk")
 	UHierarchicalInstancedStaticMeshComponent* HISMC = nullptr;
@@ -98,11 +295,50 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
 	int32 NumCustomDataFloatsPerInstance = 2;
 
+	// 裂纹阶段数：CustomData[1] 取 0（完好）..NumDestroyStages
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering", meta = (ClampMin = "1"))
+	int32 NumDestroyStages = 10;
+
+	// 渲染方式：HISMC 实例 或 面剔除网格
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
+	EChunkRenderMode RenderMode = EChunkRenderMode::Instanced;
+
+	// 网格模式使用的组件
+	UPROPERTY(VisibleAnywhere, Category = "Chunk")
+	UProceduralMeshComponent* ChunkMesh = nullptr;
+
+	// 网格模式（以及 LOD 网格）的图集材质：frac(UV0) 为格子内坐标，UV1.x = BlockID，UV1.y = 面方向；未设置时使用 AtlasMaterial
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
+	UMaterialInterface* MeshAtlasMaterial = nullptr;
+
+	// 网格模式下方块 (X,Y,Z) 占据 [X,X+1]*BlockSize；若 DefaultMesh 轴心在中心，设为 -BlockSize/2 与实例模式对齐
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
+	FVector MeshOffset = FVector::ZeroVector;
+
+	// 网格在工作线程构建：拷贝 Blocks 快照，完成后回到游戏线程提交
+	UPROPERTY(EditAnywhere, Category = "Chunk|Rendering")
+	bool bAsyncMeshing = true;
+
+	// 网格构建代数：每次发起构建 +1，回收到对象池时 +1；回调代数不一致说明结果已过期
+	uint32 MeshBuildGeneration = 0;
+
+	// 各网格段的三角形数
+	TArray<int32> SectionTriangleCounts;
+
+	// 当前网格的三角形数（各段之和）
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "Chunk|Stats")
+	int32 MeshTriangleCount = 0;
+
 	// ———————— IChunkInterface 实现 ————————
-	virtual void SetChunkData(const TArray<int32>& BlockData) override;
+	virtual void SetChunkData(const FChunkVoxelStorage& BlockData) override;
 	virtual void SetChunkCoordinates(FIntVector Coords) override;
 	virtual FIntVector GetChunkCoordinates() const override;
 	virtual void RefreshRendering() override;
+	virtual void OnReleasedToPool() override;
+	virtual void OnAcquiredFromPool() override;
+	virtual void SetNeighborChunk(const FIntPoint& Offset, AActor* Neighbor) override;
+	virtual void SetLODLevel(int32 Level) override;
+	virtual int32 GetLODLevel() const override { return LODLevel; }
 
 	FIntVector ChunkCoordinates = FIntVector::ZeroValue;
 
@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "ChunkVoxelStorage.h"
+
+/**
+ * FChunkMeshData - 区块网格数据（可在任意线程构建，再交给 ProceduralMeshComponent）
+ * 每个面 4 个独立顶点（法线不共享），两个三角形。
+ * UV0：面内平铺坐标，单位为方块（材质中 frac(UV0) 得到图集格子内坐标）
+ * UV1：X = BlockID（与 HISMC 路径 PerInstanceCustomData[0] 相同的图集索引），Y = 面方向（EChunkFace）
+ */
+struct CHUNKBLOCK_API FChunkMeshData
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UV0;
+	TArray<FVector2D> UV1;
+
+	// 清空但保留已分配内存（区块复用时避免反复分配）
+	void Reset();
+
+	FORCEINLINE int32 GetNumTriangles() const { return Triangles.Num() / 3; }
+	FORCEINLINE bool IsEmpty() const { return Triangles.Num() == 0; }
+};
+
+/** 方块面方向：与 UV1.Y 对应，材质可据此区分顶面/侧面贴图 */
+enum class EChunkFace : uint8
+{
+	PosX = 0,
+	NegX,
+	PosY,
+	NegY,
+	PosZ,	// 顶面
+	NegZ,	// 底面
+	Count
+};
+
+/**
+ * FChunkMeshContext - 网格构建输入：本区块体素 + 四个水平相邻区块（只读）
+ * 相邻区块用于判断边界面是否被遮挡；未加载的相邻区块视为空气（边界面保持输出）。
+ * 世界底部之下视为不透明（底面永远看不见），顶部之上为空气。
+ */
+struct CHUNKBLOCK_API FChunkMeshContext
+{
+	const FChunkVoxelStorage* Voxels = nullptr;
+
+	// 下标与 EChunkFace 的 PosX/NegX/PosY/NegY 一致；尺寸须与 Voxels 相同
+	const FChunkVoxelStorage* Neighbors[4] = { nullptr, nullptr, nullptr, nullptr };
+
+	float BlockSize = 100.f;
+	FVector Origin = FVector::ZeroVector;
+
+	// 该格是否不透明（X/Y 可越出本区块一格）
+	bool IsOpaque(int32 X, int32 Y, int32 Z) const;
+};
+
+/**
+ * FChunkMesher - 区块网格构建
+ * 只输出与空气相邻的方块面，被完全包围的方块不产生任何几何体。
+ * 方块 (X,Y,Z) 占据 [X,X+1] x [Y,Y+1] x [Z,Z+1]（乘以 BlockSize，再加 Origin）。
+ * 以 16 高的体素段为单位构建，修改方块后只需重建所在段。
+ * 纯数据函数，不访问 UObject，可在工作线程调用。
+ */
+class CHUNKBLOCK_API FChunkMesher
+{
+public:
+	// 面剔除网格：段内每个暴露面一个四边形
+	static void BuildCulledMesh(const FChunkMeshContext& Context, int32 SectionIndex, FChunkMeshData& OutMesh);
+
+	// 贪心网格：在面剔除基础上，把同一平面、同一 ID 的相邻面合并为尽量大的矩形（UV0 随尺寸平铺）
+	static void BuildGreedyMesh(const FChunkMeshContext& Context, int32 SectionIndex, FChunkMeshData& OutMesh);
+
+	/**
+	 * 追加一个轴对齐矩形面
+	 * @param Face      朝向
+	 * @param Cell      起始方块坐标
+	 * @param SizeU     沿切向 U 轴的方块数（U = (面法线轴 + 1) % 3）
+	 * @param SizeV     沿切向 V 轴的方块数（V = (面法线轴 + 2) % 3）
+	 */
+	static void AddFace(FChunkMeshData& OutMesh, EChunkFace Face, const FIntVector& Cell, int32 SizeU, int32 SizeV,
+		int32 BlockID, float BlockSize, const FVector& Origin);
+
+	// 面方向对应的单位偏移
+	static FIntVector GetFaceOffset(EChunkFace Face);
+};
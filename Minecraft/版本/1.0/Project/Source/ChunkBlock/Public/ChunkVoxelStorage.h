@@ -0,0 +1,252 @@
+﻿
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChunkVoxelStorage.generated.h"
+
+/**
+ * FPalettedVoxelArray - 调色板压缩的方块 ID 数组
+ * 每个体素只存调色板下标，位宽随调色板大小增长：0（整段同一 ID，无数组）/1/2/4/8/16 位。
+ * 位宽均为 2 的幂，下标不会跨越 32 位字边界，读写只需一次移位与掩码。
+ * 方块 ID 以 uint16 存储（0 = 空气）。
+ */
+USTRUCT()
+struct CHUNKBLOCK_API FPalettedVoxelArray
+{
+	GENERATED_BODY()
+
+public:
+	// 分配 InNum 个体素，全部填充为 FillID（此时为单一 ID，不分配下标数组）
+	void Init(int32 InNum, int32 FillID = 0);
+
+	// 体素数量
+	FORCEINLINE int32 Num() const { return NumVoxels; }
+
+	// 读取方块 ID（调用方保证下标有效）
+	FORCEINLINE int32 Get(int32 Index) const
+	{
+		if (BitsPerIndex == 0)
+			return Palette.Num() > 0 ? Palette[0] : 0;
+
+		const uint32 BitOffset = static_cast<uint32>(Index) * BitsPerIndex;
+		const uint32 Mask = (1u << BitsPerIndex) - 1u;
+		return Palette[(Words[BitOffset >> 5] >> (BitOffset & 31u)) & Mask];
+	}
+
+	// 写入方块 ID；新 ID 加入调色板，必要时扩大位宽
+	void Set(int32 Index, int32 BlockID);
+
+	// 从普通数组构建（调色板只包含实际出现的 ID）
+	void SetFromArray(const int32* Data, int32 InNum);
+
+	// 展开为普通数组
+	void ToArray(int32* OutData) const;
+
+	// 移除未使用的调色板项，并收缩到最小位宽（整段同一 ID 时释放下标数组）
+	void Compact();
+
+	// 是否整段为同一 ID（无下标数组）
+	FORCEINLINE bool IsUniform() const { return BitsPerIndex == 0; }
+
+	// 当前每个体素占用的位数
+	FORCEINLINE int32 GetBitsPerIndex() const { return BitsPerIndex; }
+
+	// 调色板项数
+	FORCEINLINE int32 GetPaletteSize() const { return Palette.Num(); }
+
+	// 原始编码（存档直接读写，无需展开为 int32 数组）
+	FORCEINLINE const TArray<uint16>& GetPalette() const { return Palette; }
+	FORCEINLINE const TArray<uint32>& GetWords() const { return Words; }
+
+	// InNum 个体素按 Bits 位宽打包所需的 32 位字数
+	static FORCEINLINE int32 GetNumWords(int32 InNum, int32 Bits)
+	{
+		return static_cast<int32>((static_cast<int64>(InNum) * Bits + 31) / 32);
+	}
+
+	// 直接设置原始编码（存档读取）；位宽、字数或下标与调色板不一致时返回 false 且不做修改
+	bool SetPacked(int32 InNum, int32 InBits, TArray<uint16>&& InPalette, TArray<uint32>&& InWords);
+
+	// 堆内存占用（字节）
+	SIZE_T GetAllocatedSize() const { return Palette.GetAllocatedSize() + Words.GetAllocatedSize(); }
+
+	// 编码完全一致（调色板、位宽、下标数组）；内容相同但编码不同时返回 false，调用方按已变更处理
+	FORCEINLINE bool IsIdenticalTo(const FPalettedVoxelArray& Other) const
+	{
+		return NumVoxels == Other.NumVoxels && BitsPerIndex == Other.BitsPerIndex
+			&& Palette == Other.Palette && Words == Other.Words;
+	}
+
+private:
+	// 容纳 PaletteNum 个调色板项所需的位宽
+	static uint8 GetRequiredBits(int32 PaletteNum);
+
+	// 以新位宽重新打包下标（可同时重映射调色板下标）
+	void Repack(uint8 NewBits, const TArray<int32>* Remap = nullptr);
+
+	FORCEINLINE void WriteIndex(int32 Index, uint32 PaletteIndex)
+	{
+		const uint32 BitOffset = static_cast<uint32>(Index) * BitsPerIndex;
+		const uint32 Shift = BitOffset & 31u;
+		const uint32 Mask = ((1u << BitsPerIndex) - 1u) << Shift;
+		uint32& Word = Words[BitOffset >> 5];
+		Word = (Word & ~Mask) | ((PaletteIndex << Shift) & Mask);
+	}
+
+	// 调色板：下标 -> 方块 ID
+	UPROPERTY()
+	TArray<uint16> Palette;
+
+	// 按 BitsPerIndex 紧密排列的调色板下标
+	UPROPERTY()
+	TArray<uint32> Words;
+
+	UPROPERTY()
+	int32 NumVoxels = 0;
+
+	UPROPERTY()
+	uint8 BitsPerIndex = 0;
+};
+
+/**
+ * FVoxelColumnRun - 列游程：沿 Z 自下而上连续 Length 个相同的方块 ID
+ * 地形每列通常只有基岩、石头、泥土、草、空气几段，整个区块只需 SizeX * SizeY * 6 个左右的游程。
+ */
+struct FVoxelColumnRun
+{
+	uint16 BlockID = 0;
+	uint16 Length = 0;
+};
+
+/**
+ * FChunkVoxelStorage - 区块体素存储
+ * 维护 SizeX * SizeY * SizeZ 的方块 ID，下标布局 X + Y * SizeX + Z * SizeX * SizeY，
+ * 与原先的 TArray<int32> Blocks 完全一致。
+ * 竖直方向按 SectionHeight 切分为若干段（Section），每段独立调色板压缩；
+ * 整段同一 ID（地表以上的空气、深层的石头）时不分配下标数组。
+ * 因为 Z 是最高维，每段在一维下标中是连续区间 [S * SectionVolume, (S + 1) * SectionVolume)。
+ */
+USTRUCT(BlueprintType)
+struct CHUNKBLOCK_API FChunkVoxelStorage
+{
+	GENERATED_BODY()
+
+public:
+	// 每段高度（方块数）
+	static constexpr int32 SectionHeight = 16;
+
+	// 初始化尺寸并全部填充为 FillID
+	void Init(int32 InSizeX, int32 InSizeY, int32 InSizeZ, int32 FillID = 0);
+
+	FORCEINLINE int32 GetSizeX() const { return SizeX; }
+	FORCEINLINE int32 GetSizeY() const { return SizeY; }
+	FORCEINLINE int32 GetSizeZ() const { return SizeZ; }
+	FORCEINLINE int32 Num() const { return SizeX * SizeY * SizeZ; }
+
+	FORCEINLINE bool IsValidCoord(int32 X, int32 Y, int32 Z) const
+	{
+		return X >= 0 && X < SizeX && Y >= 0 && Y < SizeY && Z >= 0 && Z < SizeZ;
+	}
+
+	FORCEINLINE int32 ToIndex(int32 X, int32 Y, int32 Z) const { return X + Y * SizeX + Z * SizeX * SizeY; }
+
+	// 读写方块 ID（调用方保证下标有效）
+	FORCEINLINE int32 Get(int32 Index) const
+	{
+		const int32 SectionVolume = GetSectionVolume();
+		const int32 SectionIndex = Index / SectionVolume;
+		return Sections[SectionIndex].Get(Index - SectionIndex * SectionVolume);
+	}
+	FORCEINLINE int32 Get(int32 X, int32 Y, int32 Z) const
+	{
+		const FPalettedVoxelArray& Section = Sections[Z / SectionHeight];
+		if (Section.IsUniform())
+			return Section.Get(0);
+		return Section.Get(X + Y * SizeX + (Z % SectionHeight) * SizeX * SizeY);
+	}
+	FORCEINLINE void Set(int32 Index, int32 BlockID)
+	{
+		const int32 SectionVolume = GetSectionVolume();
+		const int32 SectionIndex = Index / SectionVolume;
+		Sections[SectionIndex].Set(Index - SectionIndex * SectionVolume, BlockID);
+	}
+	FORCEINLINE void Set(int32 X, int32 Y, int32 Z, int32 BlockID) { Set(ToIndex(X, Y, Z), BlockID); }
+
+	// 从普通数组构建，长度必须等于 InSizeX * InSizeY * InSizeZ
+	bool SetFromArray(const TArray<int32>& Data, int32 InSizeX, int32 InSizeY, int32 InSizeZ);
+
+	// 展开为普通数组（用于存档等需要平铺数据的场合）
+	void ToArray(TArray<int32>& OutData) const;
+
+	// 收缩调色板与位宽（大量修改后调用）；被改成同一 ID 的段会释放下标数组
+	void Compact();
+
+	// 堆内存占用（字节）
+	SIZE_T GetAllocatedSize() const;
+
+	//------------------------------------ 分段访问 ------------------------------------
+
+	FORCEINLINE int32 GetNumSections() const { return Sections.Num(); }
+
+	// 一段的体素数（最后一段可能不满，按实际高度计算见 GetSectionSizeZ）
+	FORCEINLINE int32 GetSectionVolume() const { return SizeX * SizeY * SectionHeight; }
+
+	// 段的起始 Z 与实际高度
+	FORCEINLINE int32 GetSectionMinZ(int32 SectionIndex) const { return SectionIndex * SectionHeight; }
+	FORCEINLINE int32 GetSectionSizeZ(int32 SectionIndex) const
+	{
+		return FMath::Min(SectionHeight, SizeZ - SectionIndex * SectionHeight);
+	}
+
+	// 该段是否整段为同一 ID；OutBlockID 返回该 ID
+	bool IsSectionUniform(int32 SectionIndex, int32* OutBlockID = nullptr) const;
+
+	// 该段是否整段为空气（渲染与存档可直接跳过）
+	FORCEINLINE bool IsSectionEmpty(int32 SectionIndex) const
+	{
+		int32 BlockID = 0;
+		return IsSectionUniform(SectionIndex, &BlockID) && BlockID == 0;
+	}
+
+	// 把整段设为同一 ID（释放下标数组）
+	void SetSectionUniform(int32 SectionIndex, int32 BlockID);
+
+	// 用普通数组填充一段，长度必须等于该段体素数
+	bool SetSectionFromArray(int32 SectionIndex, const int32* Data, int32 InNum);
+
+	// 用原始编码填充一段（存档读取），规则见 FPalettedVoxelArray::SetPacked
+	bool SetSectionPacked(int32 SectionIndex, int32 Bits, TArray<uint16>&& InPalette, TArray<uint32>&& InWords);
+
+	const FPalettedVoxelArray& GetSection(int32 SectionIndex) const { return Sections[SectionIndex]; }
+
+	//------------------------------------ 列游程编码 ------------------------------------
+
+	// 按列（X + Y * SizeX 顺序）自下而上输出游程，追加到 OutRuns；整段同一 ID 时不逐格读取，超过 65535 的游程拆开
+	void ToColumnRuns(TArray<FVoxelColumnRun>& OutRuns) const;
+
+	// 从列游程构建；任一游程长度为 0、某列总长不等于 InSizeZ 或游程有剩余时返回 false 且不做修改
+	bool SetFromColumnRuns(const FVoxelColumnRun* Runs, int32 NumRuns, int32 InSizeX, int32 InSizeY, int32 InSizeZ);
+
+	//------------------------------------ LOD ------------------------------------
+
+	/**
+	 * 按 Factor 倍降采样（远处区块 LOD）：每 Factor^3 个体素合成一个，输出尺寸向上取整。
+	 * 空气占多数时为空气；否则取权重最高的非空 ID，顶面暴露的方块权重为 Factor^3，
+	 * 远景保留草地等地表材质而不是被下面的泥土、石头盖过。
+	 */
+	static void Downsample(const FChunkVoxelStorage& Source, int32 Factor, FChunkVoxelStorage& Out);
+
+private:
+	UPROPERTY()
+	int32 SizeX = 0;
+
+	UPROPERTY()
+	int32 SizeY = 0;
+
+	UPROPERTY()
+	int32 SizeZ = 0;
+
+	// 自下而上的各段，数量为 ceil(SizeZ / SectionHeight)
+	UPROPERTY()
+	TArray<FPalettedVoxelArray> Sections;
+};
@@ -3,6 +3,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "ChunkVoxelStorage.h"
 #include "IChunkInterface.generated.h"
 
 /**
@@ -21,10 +22,10 @@ class IChunkInterface
 
 public:
     /**
-     * 设置整个区块的方块数据（一维数组）
-     * 数组长度 = SizeX * WorldHeight * SizeZ
+     * 设置整个区块的方块数据（调色板压缩存储）
+     * 体素数量 = SizeX * SizeY * WorldHeight
      */
-    virtual void SetChunkData(const TArray<int32>& BlockData) = 0;
+    virtual void SetChunkData(const FChunkVoxelStorage& BlockData) = 0;
 
     /**
      * 设置该区块在世界中的逻辑坐标（以区块为单位）
@@ -43,6 +44,29 @@ public:
     virtual void RefreshRendering() = 0;
 
 	//区块体素数据相关接口
-    virtual void SetChunkVoxelData(const TArray<int32>& InVoxelData) = 0;
-    virtual const TArray<int32>& GetChunkVoxelData() const = 0;
+    virtual void SetChunkVoxelData(const FChunkVoxelStorage& InVoxelData) = 0;
+    virtual const FChunkVoxelStorage& GetChunkVoxelData() const = 0;
+
+    /**
+     * 区块被放回对象池时调用：隐藏并停止渲染，保留已分配的缓冲区
+     */
+    virtual void OnReleasedToPool() {}
+
+    /**
+     * 区块从对象池取出复用时调用（已移动到新位置并设置好坐标）
+     */
+    virtual void OnAcquiredFromPool() {}
+
+    /**
+     * 设置水平相邻区块，用于跨区块边界的遮挡判断
+     * Offset 为 (±1,0) 或 (0,±1)；Neighbor 为空表示该方向的区块已卸载
+     */
+    virtual void SetNeighborChunk(const FIntPoint& Offset, AActor* Neighbor) {}
+
+    /**
+     * 设置细节级别（LOD）：0 = 完整精度，N = 按 2^N 倍降采样渲染
+     * 级别变化后由下一次 RefreshRendering 重建，旧的表示保留到新网格就绪
+     */
+    virtual void SetLODLevel(int32 Level) {}
+    virtual int32 GetLODLevel() const { return 0; }
 };
\ No newline at end of file
@@ -0,0 +1,401 @@
+﻿
+// VoxelChunkCodec.cpp
+#include "VoxelChunkCodec.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Compression.h"
+#include "Compression/OodleDataCompression.h"
+#include "HAL/FileManager.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "LogVoxelPersistence.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "FVoxelChunkCodec writes palette and index words in native (little-endian) order");
+
+// 单个区块的体素数上限，防止损坏的文件触发巨大的内存分配
+static constexpr int64 GMaxChunkVoxels = 16 * 1024 * 1024;
+
+// 解压后段数据的字节数上限：每体素最多 2 字节下标 + 2 字节调色板，另留段头余量
+static constexpr int64 GMaxPayloadSize = GMaxChunkVoxels * 5;
+
+// 区块头：Flags 位于第 6 字节，压缩成功后回填
+struct FVoxelChunkHeader
+{
+    static constexpr int32 Size = 28;
+    static constexpr int32 FlagsOffset = 6;
+
+    uint32 Magic = 0;
+    uint16 Version = 0;
+    uint16 Flags = 0;
+    int32 ChunkX = 0;
+    int32 ChunkY = 0;
+    int32 SizeX = 0;
+    int32 SizeY = 0;
+    int32 SizeZ = 0;
+
+    EVoxelChunkCompression GetCompression() const { return static_cast<EVoxelChunkCompression>(Flags & 0xFF); }
+    EVoxelChunkLayout GetLayout() const { return static_cast<EVoxelChunkLayout>(Flags >> 8); }
+
+    friend FArchive& operator<<(FArchive& Ar, FVoxelChunkHeader& Header)
+    {
+        return Ar << Header.Magic << Header.Version << Header.Flags
+            << Header.ChunkX << Header.ChunkY << Header.SizeX << Header.SizeY << Header.SizeZ;
+    }
+};
+
+// 逐段写出调色板与打包下标，内存布局原样拷贝
+static void WriteSections(FArchive& Ar, const FChunkVoxelStorage& Voxels)
+{
+    for (int32 SectionIndex = 0; SectionIndex < Voxels.GetNumSections(); SectionIndex++)
+    {
+        const FPalettedVoxelArray& Section = Voxels.GetSection(SectionIndex);
+        const TArray<uint16>& Palette = Section.GetPalette();
+        const TArray<uint32>& Words = Section.GetWords();
+
+        uint8 Bits = static_cast<uint8>(Section.GetBitsPerIndex());
+        uint32 PaletteNum = static_cast<uint32>(Palette.Num());
+        Ar << Bits << PaletteNum;
+        Ar.Serialize(const_cast<uint16*>(Palette.GetData()), Palette.Num() * sizeof(uint16));
+        if (Bits > 0)
+        {
+            Ar.Serialize(const_cast<uint32*>(Words.GetData()), Words.Num() * sizeof(uint32));
+        }
+    }
+}
+
+// 读取各段到已按尺寸初始化的 Voxels
+static bool ReadSections(FArchive& Ar, const FIntPoint& ChunkPos, FChunkVoxelStorage& Voxels)
+{
+    for (int32 SectionIndex = 0; SectionIndex < Voxels.GetNumSections(); SectionIndex++)
+    {
+        uint8 Bits = 0;
+        uint32 PaletteNum = 0;
+        Ar << Bits << PaletteNum;
+
+        // 数量先与剩余字节比较，再分配
+        const int32 NumWords = FPalettedVoxelArray::GetNumWords(Voxels.GetSection(SectionIndex).Num(), Bits);
+        const int64 Remaining = Ar.TotalSize() - Ar.Tell();
+        if (Ar.IsError() || Bits > 16 || PaletteNum == 0 || PaletteNum > (1u << 16)
+            || static_cast<int64>(PaletteNum) * sizeof(uint16) + static_cast<int64>(NumWords) * sizeof(uint32) > Remaining)
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) section %d is truncated or corrupt"),
+                ChunkPos.X, ChunkPos.Y, SectionIndex);
+            return false;
+        }
+
+        TArray<uint16> Palette;
+        Palette.SetNumUninitialized(PaletteNum);
+        Ar.Serialize(Palette.GetData(), Palette.Num() * sizeof(uint16));
+
+        TArray<uint32> Words;
+        Words.SetNumUninitialized(NumWords);
+        Ar.Serialize(Words.GetData(), Words.Num() * sizeof(uint32));
+
+        if (Ar.IsError() || !Voxels.SetSectionPacked(SectionIndex, Bits, MoveTemp(Palette), MoveTemp(Words)))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) section %d has invalid palette data"),
+                ChunkPos.X, ChunkPos.Y, SectionIndex);
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(sizeof(FVoxelColumnRun) == 4, "FVoxelColumnRun is written to disk as { uint16 BlockID, uint16 Length }");
+
+// 游程数组原样拷贝
+static void WriteColumnRuns(FArchive& Ar, const TArray<FVoxelColumnRun>& Runs)
+{
+    uint32 NumRuns = static_cast<uint32>(Runs.Num());
+    Ar << NumRuns;
+    Ar.Serialize(const_cast<FVoxelColumnRun*>(Runs.GetData()), Runs.Num() * sizeof(FVoxelColumnRun));
+}
+
+// 读取游程并直接构建 Voxels
+static bool ReadColumnRuns(FArchive& Ar, const FIntPoint& ChunkPos, int32 SizeX, int32 SizeY, int32 SizeZ, FChunkVoxelStorage& Voxels)
+{
+    uint32 NumRuns = 0;
+    Ar << NumRuns;
+
+    // 每个游程至少一格，数量不会超过体素数
+    const int64 Remaining = Ar.TotalSize() - Ar.Tell();
+    if (Ar.IsError() || NumRuns > static_cast<uint64>(SizeX) * SizeY * SizeZ
+        || static_cast<int64>(NumRuns) * sizeof(FVoxelColumnRun) > Remaining)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) column runs are truncated or corrupt"),
+            ChunkPos.X, ChunkPos.Y);
+        return false;
+    }
+
+    TArray<FVoxelColumnRun> Runs;
+    Runs.SetNumUninitialized(NumRuns);
+    Ar.Serialize(Runs.GetData(), Runs.Num() * sizeof(FVoxelColumnRun));
+
+    if (Ar.IsError() || !Voxels.SetFromColumnRuns(Runs.GetData(), Runs.Num(), SizeX, SizeY, SizeZ))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) column runs do not match size %dx%dx%d"),
+            ChunkPos.X, ChunkPos.Y, SizeX, SizeY, SizeZ);
+        return false;
+    }
+    return true;
+}
+
+// 压缩 Src 并追加到 Out；失败或结果不比原数据小时返回 false，Out 保持不变
+static bool CompressPayload(EVoxelChunkCompression Compression, TConstArrayView<uint8> Src, TArray<uint8>& Out)
+{
+    const int32 Offset = Out.Num();
+    int64 CompressedSize = 0;
+
+    switch (Compression)
+    {
+    case EVoxelChunkCompression::LZ4:
+    case EVoxelChunkCompression::Zlib:
+    {
+        const FName Format = Compression == EVoxelChunkCompression::LZ4 ? NAME_LZ4 : NAME_Zlib;
+        int32 Size = FCompression::CompressMemoryBound(Format, Src.Num());
+        Out.AddUninitialized(Size);
+        if (FCompression::CompressMemory(Format, Out.GetData() + Offset, Size, Src.GetData(), Src.Num()))
+            CompressedSize = Size;
+        break;
+    }
+    case EVoxelChunkCompression::Oodle:
+    {
+        const int64 Bound = FOodleDataCompression::CompressedBufferSizeNeeded(Src.Num());
+        Out.AddUninitialized(static_cast<int32>(Bound));
+        CompressedSize = FOodleDataCompression::Compress(Out.GetData() + Offset, Bound, Src.GetData(), Src.Num(),
+            FOodleDataCompression::ECompressor::Kraken, FOodleDataCompression::ECompressionLevel::Optimal2);
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (CompressedSize <= 0 || CompressedSize >= Src.Num())
+    {
+        Out.SetNum(Offset, false);
+        return false;
+    }
+    Out.SetNum(Offset + static_cast<int32>(CompressedSize), false);
+    return true;
+}
+
+// 解压到 Out（大小为 UncompressedSize）
+static bool DecompressPayload(EVoxelChunkCompression Compression, TConstArrayView<uint8> Src, int32 UncompressedSize, TArray<uint8>& Out)
+{
+    Out.SetNumUninitialized(UncompressedSize);
+
+    switch (Compression)
+    {
+    case EVoxelChunkCompression::LZ4:
+        return FCompression::UncompressMemory(NAME_LZ4, Out.GetData(), UncompressedSize, Src.GetData(), Src.Num());
+    case EVoxelChunkCompression::Zlib:
+        return FCompression::UncompressMemory(NAME_Zlib, Out.GetData(), UncompressedSize, Src.GetData(), Src.Num());
+    case EVoxelChunkCompression::Oodle:
+        return FOodleDataCompression::Decompress(Out.GetData(), UncompressedSize, Src.GetData(), Src.Num());
+    default:
+        return false;
+    }
+}
+
+// --- Encode ---
+void FVoxelChunkCodec::Encode(const FVoxelChunkData& Chunk, TArray<uint8>& OutBytes, EVoxelChunkCompression Compression, EVoxelChunkLayout Layout)
+{
+    const FChunkVoxelStorage& Voxels = Chunk.VoxelData;
+
+    // 调色板布局的体素数据大小：每段 BitsPerIndex、PaletteNum、调色板与下标数组
+    int32 EstimatedPayloadSize = 0;
+    for (int32 SectionIndex = 0; SectionIndex < Voxels.GetNumSections(); SectionIndex++)
+    {
+        const FPalettedVoxelArray& Section = Voxels.GetSection(SectionIndex);
+        EstimatedPayloadSize += 5 + Section.GetPalette().Num() * sizeof(uint16) + Section.GetWords().Num() * sizeof(uint32);
+    }
+
+    // 列游程布局：只在游程数组比调色板布局更小时使用（洞穴、矿脉密集的区块退回调色板布局）
+    TArray<FVoxelColumnRun> Runs;
+    if (Layout == EVoxelChunkLayout::ColumnRuns)
+    {
+        Voxels.ToColumnRuns(Runs);
+        const int32 RunsPayloadSize = sizeof(uint32) + Runs.Num() * sizeof(FVoxelColumnRun);
+        if (RunsPayloadSize < EstimatedPayloadSize)
+            EstimatedPayloadSize = RunsPayloadSize;
+        else
+            Layout = EVoxelChunkLayout::Palette;
+    }
+    auto WritePayload = [&Voxels, &Runs, Layout](FArchive& PayloadAr)
+    {
+        if (Layout == EVoxelChunkLayout::ColumnRuns)
+            WriteColumnRuns(PayloadAr, Runs);
+        else
+            WriteSections(PayloadAr, Voxels);
+    };
+
+    OutBytes.Reset(FVoxelChunkHeader::Size + EstimatedPayloadSize);
+
+    FMemoryWriter Ar(OutBytes);
+
+    FVoxelChunkHeader Header;
+    Header.Magic = Magic;
+    Header.Version = CurrentVersion;
+    Header.Flags = static_cast<uint16>(Layout) << 8;
+    Header.ChunkX = Chunk.ChunkCoordinate.X;
+    Header.ChunkY = Chunk.ChunkCoordinate.Y;
+    Header.SizeX = Voxels.GetSizeX();
+    Header.SizeY = Voxels.GetSizeY();
+    Header.SizeZ = Voxels.GetSizeZ();
+    Ar << Header;
+
+    if (Compression == EVoxelChunkCompression::None)
+    {
+        WritePayload(Ar);
+        return;
+    }
+
+    // 体素数据先写入临时缓冲区，再压缩到头部之后
+    TArray<uint8> Payload;
+    Payload.Reserve(EstimatedPayloadSize);
+    FMemoryWriter PayloadAr(Payload);
+    WritePayload(PayloadAr);
+
+    uint32 UncompressedSize = static_cast<uint32>(Payload.Num());
+    Ar << UncompressedSize;
+
+    if (CompressPayload(Compression, Payload, OutBytes))
+    {
+        const uint16 Flags = Header.Flags | static_cast<uint16>(Compression);
+        FMemory::Memcpy(OutBytes.GetData() + FVoxelChunkHeader::FlagsOffset, &Flags, sizeof(Flags));
+    }
+    else
+    {
+        // 压缩无收益（如全空气区块）：去掉 UncompressedSize，按不压缩写出
+        OutBytes.SetNum(FVoxelChunkHeader::Size, false);
+        OutBytes.Append(Payload);
+    }
+}
+
+// --- Decode ---
+bool FVoxelChunkCodec::Decode(TConstArrayView<uint8> Bytes, FVoxelChunkData& OutChunk)
+{
+    FMemoryReaderView Ar(Bytes);
+
+    FVoxelChunkHeader Header;
+    Ar << Header;
+
+    if (Ar.IsError() || Header.Magic != Magic)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: not a chunk file (%d bytes)"), Bytes.Num());
+        return false;
+    }
+    if (Header.Version > CurrentVersion)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) has unsupported version %d (current %d)"),
+            Header.ChunkX, Header.ChunkY, Header.Version, CurrentVersion);
+        return false;
+    }
+
+    const EVoxelChunkCompression Compression = Header.GetCompression();
+    const EVoxelChunkLayout Layout = Header.GetLayout();
+    if (Compression > EVoxelChunkCompression::Oodle || Layout > EVoxelChunkLayout::ColumnRuns)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) has unknown flags 0x%04x"),
+            Header.ChunkX, Header.ChunkY, Header.Flags);
+        return false;
+    }
+
+    const int32 SizeX = Header.SizeX, SizeY = Header.SizeY, SizeZ = Header.SizeZ;
+    if (SizeX < 0 || SizeY < 0 || SizeZ < 0 || static_cast<int64>(SizeX) * SizeY * SizeZ > GMaxChunkVoxels)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) has invalid size %dx%dx%d"),
+            Header.ChunkX, Header.ChunkY, SizeX, SizeY, SizeZ);
+        return false;
+    }
+
+    // 压缩的体素数据先解压到临时缓冲区
+    const FIntPoint ChunkPos(Header.ChunkX, Header.ChunkY);
+    TConstArrayView<uint8> PayloadView = Bytes.RightChop(FVoxelChunkHeader::Size);
+    TArray<uint8> Payload;
+    if (Compression != EVoxelChunkCompression::None)
+    {
+        uint32 UncompressedSize = 0;
+        Ar << UncompressedSize;
+        if (Ar.IsError() || UncompressedSize > GMaxPayloadSize
+            || !DecompressPayload(Compression, Bytes.RightChop(FVoxelChunkHeader::Size + sizeof(uint32)), UncompressedSize, Payload))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("FVoxelChunkCodec::Decode: chunk (%d, %d) failed to decompress (%s)"),
+                ChunkPos.X, ChunkPos.Y, *StaticEnum<EVoxelChunkCompression>()->GetNameStringByValue(static_cast<int64>(Compression)));
+            return false;
+        }
+        PayloadView = Payload;
+    }
+
+    // 先解码到临时存储，成功后再交给调用方
+    FChunkVoxelStorage Voxels;
+    FMemoryReaderView PayloadAr(PayloadView);
+    if (Layout == EVoxelChunkLayout::ColumnRuns)
+    {
+        if (!ReadColumnRuns(PayloadAr, ChunkPos, SizeX, SizeY, SizeZ, Voxels))
+            return false;
+    }
+    else
+    {
+        Voxels.Init(SizeX, SizeY, SizeZ, 0);
+        if (!ReadSections(PayloadAr, ChunkPos, Voxels))
+            return false;
+    }
+
+    OutChunk.ChunkCoordinate = ChunkPos;
+    OutChunk.VoxelData = MoveTemp(Voxels);
+    return true;
+}
+
+bool FVoxelChunkCodec::GetEncoding(TConstArrayView<uint8> Bytes, EVoxelChunkCompression& OutCompression, EVoxelChunkLayout& OutLayout)
+{
+    FMemoryReaderView Ar(Bytes);
+
+    FVoxelChunkHeader Header;
+    Ar << Header;
+    if (Ar.IsError() || Header.Magic != Magic)
+        return false;
+
+    OutCompression = Header.GetCompression();
+    OutLayout = Header.GetLayout();
+    return true;
+}
+
+// --- 文件 I/O: Save ---
+bool FVoxelChunkCodec::SaveChunkToFile(const FString& FilePath, const FVoxelChunkData& Chunk, EVoxelChunkCompression Compression, EVoxelChunkLayout Layout)
+{
+    TArray<uint8> Bytes;
+    Encode(Chunk, Bytes, Compression, Layout);
+
+    // 确保目录存在
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+
+    if (!FFileHelper::SaveArrayToFile(Bytes, *FilePath))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to write file: %s"), *FilePath);
+        return false;
+    }
+
+    UE_LOG(H_LogVoxelPersistence, Verbose, TEXT("Saved chunk to: %s (%d bytes)"), *FilePath, Bytes.Num());
+    return true;
+}
+
+// --- 文件 I/O: Load ---
+bool FVoxelChunkCodec::LoadChunkFromFile(const FString& FilePath, FVoxelChunkData& OutChunk)
+{
+    TArray<uint8> Bytes;
+    if (!FFileHelper::LoadFileToArray(Bytes, *FilePath, FILEREAD_Silent))
+    {
+        UE_LOG(H_LogVoxelPersistence, Verbose, TEXT("File not found or unreadable: %s"), *FilePath);
+        return false;
+    }
+
+    if (!Decode(Bytes, OutChunk))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to decode chunk from: %s"), *FilePath);
+        return false;
+    }
+
+    UE_LOG(H_LogVoxelPersistence, Verbose, TEXT("Loaded chunk from: %s"), *FilePath);
+    return true;
+}
@@ -0,0 +1,127 @@
+﻿
+// VoxelPersistenceBenchmarks.cpp
+#include "VoxelChunkCodec.h"
+#include "ChunkActor.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "LogVoxelPersistence.h"
+
+/**
+ * VoxelPersistence 基准测试（PIE / 开发版中在控制台输入）
+ * 取当前世界中已生成的区块，分别用各布局与压缩方式编码、解码，报告压缩率与吞吐量。
+ * 压缩率与吞吐量均相对于调色板布局、不压缩的 .vxc 字节数计算；只在内存中进行，不含磁盘 I/O。
+ */
+
+//------------------------------------ 区块压缩 ------------------------------------
+static void BenchmarkChunkCompression(UWorld* World, int32 Iterations)
+{
+    // 收集已生成的区块（跳过回收到池中的隐藏区块）
+    TArray<FVoxelChunkData> Chunks;
+    for (TActorIterator<AChunkActor> It(World); It; ++It)
+    {
+        const FChunkVoxelStorage& Voxels = It->GetChunkVoxelData();
+        if (It->IsHidden() || Voxels.Num() == 0)
+            continue;
+
+        const FIntVector Coords = It->GetChunkCoordinates();
+        FVoxelChunkData& Chunk = Chunks.AddDefaulted_GetRef();
+        Chunk.ChunkCoordinate = FIntPoint(Coords.X, Coords.Y);
+        Chunk.VoxelData = Voxels;
+    }
+
+    if (Chunks.Num() == 0)
+    {
+        UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Voxel.Benchmark.Compression: no generated chunks in world"));
+        return;
+    }
+
+    Iterations = FMath::Max(1, Iterations);
+
+    struct FCodecCase
+    {
+        EVoxelChunkLayout Layout;
+        EVoxelChunkCompression Compression;
+    };
+    const FCodecCase Cases[] =
+    {
+        { EVoxelChunkLayout::Palette, EVoxelChunkCompression::None },
+        { EVoxelChunkLayout::Palette, EVoxelChunkCompression::LZ4 },
+        { EVoxelChunkLayout::Palette, EVoxelChunkCompression::Zlib },
+        { EVoxelChunkLayout::Palette, EVoxelChunkCompression::Oodle },
+        { EVoxelChunkLayout::ColumnRuns, EVoxelChunkCompression::None },
+        { EVoxelChunkLayout::ColumnRuns, EVoxelChunkCompression::LZ4 },
+    };
+
+    TArray<TArray<uint8>> Encoded;
+    Encoded.SetNum(Chunks.Num());
+    FVoxelChunkData Decoded;
+    int64 RawBytes = 0;
+
+    FString Report;
+    for (const FCodecCase& Case : Cases)
+    {
+        //=================== 编码 ===================
+        double Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+        {
+            for (int32 i = 0; i < Chunks.Num(); i++)
+                FVoxelChunkCodec::Encode(Chunks[i], Encoded[i], Case.Compression, Case.Layout);
+        }
+        const double EncodeSeconds = (FPlatformTime::Seconds() - Start) / Iterations;
+
+        // 统计实际按所选方式写出的区块（压缩无收益或游程数组不比调色板布局小时会退回）
+        int64 EncodedBytes = 0;
+        int32 NumApplied = 0;
+        for (const TArray<uint8>& Bytes : Encoded)
+        {
+            EncodedBytes += Bytes.Num();
+
+            EVoxelChunkCompression Compression = EVoxelChunkCompression::None;
+            EVoxelChunkLayout Layout = EVoxelChunkLayout::Palette;
+            if (FVoxelChunkCodec::GetEncoding(Bytes, Compression, Layout) && Compression == Case.Compression && Layout == Case.Layout)
+                NumApplied++;
+        }
+
+        // 第一轮（调色板布局、不压缩）作为基准
+        if (RawBytes == 0)
+            RawBytes = EncodedBytes;
+
+        //=================== 解码 ===================
+        bool bDecodeOk = true;
+        Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+        {
+            for (const TArray<uint8>& Bytes : Encoded)
+                bDecodeOk &= FVoxelChunkCodec::Decode(Bytes, Decoded);
+        }
+        const double DecodeSeconds = (FPlatformTime::Seconds() - Start) / Iterations;
+
+        const double RawMB = RawBytes / (1024.0 * 1024.0);
+        const FString Name = StaticEnum<EVoxelChunkLayout>()->GetNameStringByValue(static_cast<int64>(Case.Layout)) + TEXT("/")
+            + StaticEnum<EVoxelChunkCompression>()->GetNameStringByValue(static_cast<int64>(Case.Compression));
+        Report += FString::Printf(TEXT("\n  %-17s: %9.1f KB  ratio %6.2fx  encode %8.1f MB/s  decode %8.1f MB/s  applied %d/%d%s"),
+            *Name, EncodedBytes / 1024.0,
+            EncodedBytes > 0 ? static_cast<double>(RawBytes) / EncodedBytes : 0.0,
+            EncodeSeconds > 0.0 ? RawMB / EncodeSeconds : 0.0,
+            DecodeSeconds > 0.0 ? RawMB / DecodeSeconds : 0.0,
+            NumApplied, Chunks.Num(), bDecodeOk ? TEXT("") : TEXT("  DECODE FAILED"));
+    }
+
+    // 参照：展开为每体素一个 int32 时的大小（旧 JSON 存档前的原始体积）
+    int64 VoxelCount = 0;
+    for (const FVoxelChunkData& Chunk : Chunks)
+        VoxelCount += Chunk.VoxelData.Num();
+
+    UE_LOG(H_LogVoxelPersistence, Display, TEXT("Voxel.Benchmark.Compression: %d chunks, %lld voxels (%.1f MB as int32), %d iterations%s"),
+        Chunks.Num(), VoxelCount, VoxelCount * sizeof(int32) / (1024.0 * 1024.0), Iterations, *Report);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GVoxelBenchmarkCompressionCommand(
+    TEXT("Voxel.Benchmark.Compression"),
+    TEXT("Encode and decode every generated chunk in the world with each chunk layout and compression and report ratio and MB/s. Usage: Voxel.Benchmark.Compression [Iterations=3]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            const int32 Iterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 3;
+            BenchmarkChunkCompression(World, Iterations);
+        }));
@@ -69,6 +69,8 @@ TSharedPtr<FJsonObject> FVoxelPersistenceJsonUtils::ToJson(const FVoxelWorldMeta
         ChunkList.Add(IntPointToJson(P));
     }
     Json->SetArrayField("Chunks", ChunkList);
+    Json->SetStringField("ChunkCompression", StaticEnum<EVoxelChunkCompression>()->GetNameStringByValue(static_cast<int64>(Meta.ChunkCompression)));
+    Json->SetStringField("ChunkLayout", StaticEnum<EVoxelChunkLayout>()->GetNameStringByValue(static_cast<int64>(Meta.ChunkLayout)));
 
     return Json;
 }
@@ -115,22 +117,48 @@ bool FVoxelPersistenceJsonUtils::FromJson(const TSharedPtr<FJsonObject>& Json, F
         }
     }
 
+    // 旧存档没有该字段：使用默认值；未知名称同样回退到默认值
+    OutMeta.ChunkCompression = FVoxelWorldMeta().ChunkCompression;
+    if (Json->HasField("ChunkCompression"))
+    {
+        const int64 Value = StaticEnum<EVoxelChunkCompression>()->GetValueByNameString(Json->GetStringField("ChunkCompression"));
+        if (Value != INDEX_NONE)
+            OutMeta.ChunkCompression = static_cast<EVoxelChunkCompression>(Value);
+    }
+
+    OutMeta.ChunkLayout = FVoxelWorldMeta().ChunkLayout;
+    if (Json->HasField("ChunkLayout"))
+    {
+        const int64 Value = StaticEnum<EVoxelChunkLayout>()->GetValueByNameString(Json->GetStringField("ChunkLayout"));
+        if (Value != INDEX_NONE)
+            OutMeta.ChunkLayout = static_cast<EVoxelChunkLayout>(Value);
+    }
+
     return true;
 }
 
-// --- FVoxelChunkData: ToJson ---
+// --- FVoxelChunkData: ToJson（列游程格式）---
 TSharedPtr<FJsonObject> FVoxelPersistenceJsonUtils::ToJson(const FVoxelChunkData& Chunk)
 {
     TSharedPtr<FJsonObject> Json = MakeShareable(new FJsonObject);
     Json->SetNumberField("X", Chunk.ChunkCoordinate.X);
     Json->SetNumberField("Y", Chunk.ChunkCoordinate.Y);
+    Json->SetNumberField("SizeX", Chunk.VoxelData.GetSizeX());
+    Json->SetNumberField("SizeY", Chunk.VoxelData.GetSizeY());
+    Json->SetNumberField("SizeZ", Chunk.VoxelData.GetSizeZ());
+
+    // 平铺为 [ID, Length, ID, Length, ...]，每列只有几个游程，文件可直接阅读
+    TArray<FVoxelColumnRun> Runs;
+    Chunk.VoxelData.ToColumnRuns(Runs);
 
-    TArray<TSharedPtr<FJsonValue>> BlockValues;
-    for (int32 ID : Chunk.VoxelData)
+    TArray<TSharedPtr<FJsonValue>> RunValues;
+    RunValues.Reserve(Runs.Num() * 2);
+    for (const FVoxelColumnRun& Run : Runs)
     {
-        BlockValues.Add(MakeShareable(new FJsonValueNumber(ID)));
+        RunValues.Add(MakeShareable(new FJsonValueNumber(Run.BlockID)));
+        RunValues.Add(MakeShareable(new FJsonValueNumber(Run.Length)));
     }
-    Json->SetArrayField("Blocks", BlockValues);
+    Json->SetArrayField("ColumnRuns", RunValues);
 
     return Json;
 }
@@ -143,16 +171,103 @@ bool FVoxelPersistenceJsonUtils::FromJson(const TSharedPtr<FJsonObject>& Json, F
     OutChunk.ChunkCoordinate.X = Json->HasField("X") ? Json->GetIntegerField("X") : 0;
     OutChunk.ChunkCoordinate.Y = Json->HasField("Y") ? Json->GetIntegerField("Y") : 0;
 
-    OutChunk.VoxelData.Empty();
+    // 列游程格式
+    const TArray<TSharedPtr<FJsonValue>>* RunArray = nullptr;
+    if (Json->TryGetArrayField("ColumnRuns", RunArray) && RunArray && Json->HasField("SizeX") && Json->HasField("SizeY") && Json->HasField("SizeZ"))
+    {
+        TArray<FVoxelColumnRun> Runs;
+        Runs.Reserve(RunArray->Num() / 2);
+        for (int32 i = 0; i + 1 < RunArray->Num(); i += 2)
+        {
+            Runs.Add({
+                static_cast<uint16>(FMath::Clamp(static_cast<int32>((*RunArray)[i]->AsNumber()), 0, (int32)MAX_uint16)),
+                static_cast<uint16>(FMath::Clamp(static_cast<int32>((*RunArray)[i + 1]->AsNumber()), 0, (int32)MAX_uint16)) });
+        }
+
+        const int32 SizeX = Json->GetIntegerField("SizeX");
+        const int32 SizeY = Json->GetIntegerField("SizeY");
+        const int32 SizeZ = Json->GetIntegerField("SizeZ");
+        if (RunArray->Num() % 2 != 0 || !OutChunk.VoxelData.SetFromColumnRuns(Runs.GetData(), Runs.Num(), SizeX, SizeY, SizeZ))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("Chunk (%d, %d): column runs do not match size %dx%dx%d"),
+                OutChunk.ChunkCoordinate.X, OutChunk.ChunkCoordinate.Y, SizeX, SizeY, SizeZ);
+            return false;
+        }
+        return true;
+    }
+
+    // 分段格式
+    if (Json->HasField("Sections") && Json->HasField("SizeX") && Json->HasField("SizeY") && Json->HasField("SizeZ"))
+    {
+        FChunkVoxelStorage& Voxels = OutChunk.VoxelData;
+        Voxels.Init(Json->GetIntegerField("SizeX"), Json->GetIntegerField("SizeY"), Json->GetIntegerField("SizeZ"), 0);
+
+        const TArray<TSharedPtr<FJsonValue>>& SectionArray = Json->GetArrayField("Sections");
+        if (SectionArray.Num() != Voxels.GetNumSections())
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("Chunk (%d, %d): section count %d does not match expected %d"),
+                OutChunk.ChunkCoordinate.X, OutChunk.ChunkCoordinate.Y, SectionArray.Num(), Voxels.GetNumSections());
+            return false;
+        }
+
+        TArray<int32> SectionBlocks;
+        for (int32 SectionIndex = 0; SectionIndex < SectionArray.Num(); SectionIndex++)
+        {
+            const TSharedPtr<FJsonObject>* SectionJson = nullptr;
+            if (!SectionArray[SectionIndex]->TryGetObject(SectionJson) || !SectionJson)
+                return false;
+
+            if ((*SectionJson)->HasField("Uniform"))
+            {
+                Voxels.SetSectionUniform(SectionIndex, (*SectionJson)->GetIntegerField("Uniform"));
+                continue;
+            }
+
+            const TArray<TSharedPtr<FJsonValue>>* BlockArray = nullptr;
+            if (!(*SectionJson)->TryGetArrayField("Blocks", BlockArray) || !BlockArray)
+                return false;
+
+            SectionBlocks.Reset(BlockArray->Num());
+            for (const TSharedPtr<FJsonValue>& Value : *BlockArray)
+            {
+                SectionBlocks.Add(static_cast<int32>(Value->AsNumber()));
+            }
+
+            if (!Voxels.SetSectionFromArray(SectionIndex, SectionBlocks.GetData(), SectionBlocks.Num()))
+            {
+                UE_LOG(H_LogVoxelPersistence, Error, TEXT("Chunk (%d, %d): section %d has %d blocks"),
+                    OutChunk.ChunkCoordinate.X, OutChunk.ChunkCoordinate.Y, SectionIndex, SectionBlocks.Num());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 旧格式：平铺的 Blocks 数组
+    TArray<int32> Blocks;
     if (Json->HasField("Blocks"))
     {
         const TArray<TSharedPtr<FJsonValue>>& BlockArray = Json->GetArrayField("Blocks");
+        Blocks.Reserve(BlockArray.Num());
         for (const TSharedPtr<FJsonValue>& Value : BlockArray)
         {
-            OutChunk.VoxelData.Add(static_cast<int32>(Value->AsNumber()));
+            Blocks.Add(static_cast<int32>(Value->AsNumber()));
         }
     }
 
+    // 更早的存档没有尺寸字段：按 16 x 16 x N 解释
+    const int32 SizeX = Json->HasField("SizeX") ? Json->GetIntegerField("SizeX") : 16;
+    const int32 SizeY = Json->HasField("SizeY") ? Json->GetIntegerField("SizeY") : 16;
+    const int32 SizeZ = Json->HasField("SizeZ") ? Json->GetIntegerField("SizeZ") :
+        (SizeX * SizeY > 0 ? Blocks.Num() / (SizeX * SizeY) : 0);
+
+    if (!OutChunk.VoxelData.SetFromArray(Blocks, SizeX, SizeY, SizeZ))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Chunk (%d, %d): block count %d does not match size %dx%dx%d"),
+            OutChunk.ChunkCoordinate.X, OutChunk.ChunkCoordinate.Y, Blocks.Num(), SizeX, SizeY, SizeZ);
+        return false;
+    }
+
     return true;
 }
 
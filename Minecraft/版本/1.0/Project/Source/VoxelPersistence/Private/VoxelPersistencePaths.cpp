@@ -19,6 +19,21 @@ FString FVoxelPersistencePaths::GetChunkDir(const FString& WorldName)
 }
 
 FString FVoxelPersistencePaths::GetChunkFilePath(const FString& WorldName, const FIntPoint& ChunkPos)
+{
+    return GetChunkDir(WorldName) / FString::Printf(TEXT("chunk_%d_%d.vxc"), ChunkPos.X, ChunkPos.Y);
+}
+
+FString FVoxelPersistencePaths::GetRegionDir(const FString& WorldName)
+{
+    return GetWorldSaveDir(WorldName) / TEXT("regions");
+}
+
+FString FVoxelPersistencePaths::GetRegionFilePath(const FString& WorldName, const FIntPoint& RegionPos)
+{
+    return GetRegionDir(WorldName) / FString::Printf(TEXT("r.%d.%d.vxr"), RegionPos.X, RegionPos.Y);
+}
+
+FString FVoxelPersistencePaths::GetLegacyChunkFilePath(const FString& WorldName, const FIntPoint& ChunkPos)
 {
     return GetChunkDir(WorldName) / FString::Printf(TEXT("chunk_%d_%d.json"), ChunkPos.X, ChunkPos.Y);
 }
\ No newline at end of file
@@ -2,12 +2,23 @@
 // VoxelPersistenceSubsystem.cpp
 #include "VoxelPersistenceSubsystem.h"
 #include "VoxelPersistenceJsonUtils.h"
+#include "VoxelChunkCodec.h"
+#include "VoxelRegionFile.h"
 #include "VoxelPersistencePaths.h"
 #include "Misc/Paths.h"
 #include "HAL/FileManager.h"
 #include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeRWLock.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
 #include "LogVoxelPersistence.h"
 
+// 区域文件读写锁：读取（同步/异步加载）可以并行，保存、整理与导出独占
+static FRWLock GRegionFileLock;
+
 bool UVoxelPersistenceSubsystem::DoesWorldExist(const FString& WorldName)
 {
     if (WorldName.IsEmpty()) return false;
@@ -60,14 +71,7 @@ void UVoxelPersistenceSubsystem::LoadWorldMetaAsync(
     AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WorldNameCopy, OnComplete]()
         {
             FVoxelWorldMeta LoadedMeta;
-            bool bSuccess = false;
-
-            FString MetaPath = FVoxelPersistencePaths::GetMetaFilePath(WorldNameCopy);
-            TSharedPtr<FJsonObject> Json;
-            if (FVoxelPersistenceJsonUtils::LoadJsonFromFile(MetaPath, Json))
-            {
-                bSuccess = FVoxelPersistenceJsonUtils::FromJson(Json, LoadedMeta);
-            }
+            bool bSuccess = LoadMeta(WorldNameCopy, LoadedMeta);
 
             AsyncTask(ENamedThreads::GameThread, [OnComplete, bSuccess, LoadedMeta]()
                 {
@@ -77,16 +81,332 @@ void UVoxelPersistenceSubsystem::LoadWorldMetaAsync(
         });
 }
 
+bool UVoxelPersistenceSubsystem::LoadMeta(const FString& WorldName, FVoxelWorldMeta& OutMeta)
+{
+    FString MetaPath = FVoxelPersistencePaths::GetMetaFilePath(WorldName);
+    TSharedPtr<FJsonObject> Json;
+    return FVoxelPersistenceJsonUtils::LoadJsonFromFile(MetaPath, Json) && FVoxelPersistenceJsonUtils::FromJson(Json, OutMeta);
+}
+
 bool UVoxelPersistenceSubsystem::LoadChunkSync(const FString& WorldName, const FIntPoint& ChunkPos, FVoxelChunkData& OutChunk)
 {
     if (WorldName.IsEmpty()) return false;
 
+    // 区域文件优先；区域文件中没有的区块再找单区块文件（旧存档）
+    // 单区块文件也在读锁内读取：保存/整理会先写区域文件再删除单区块文件，锁外读取可能两边都找不到
+    EVoxelChunkLoadResult Result = EVoxelChunkLoadResult::NotFound;
+    {
+        FReadScopeLock Lock(GRegionFileLock);
+        bool bInRegion = false;
+        bool bRegionUnreadable = false;
+        const FString RegionPath = FVoxelPersistencePaths::GetRegionFilePath(WorldName, FVoxelRegionFile::GetRegionCoord(ChunkPos));
+        FVoxelRegionFile Region;
+        if (FPaths::FileExists(RegionPath))
+        {
+            if (!Region.Open(RegionPath, false))
+            {
+                bRegionUnreadable = true;
+            }
+            else if (Region.IsChunkCorrupt(ChunkPos))
+            {
+                // 保存过但偏移表项已损坏：报告失败，不回退到单区块文件（可能是更旧的数据）
+                bInRegion = true;
+                Result = EVoxelChunkLoadResult::Failed;
+            }
+            else if (Region.HasChunk(ChunkPos))
+            {
+                bInRegion = true;
+                TArray<uint8> Bytes;
+                Result = Region.ReadChunk(ChunkPos, Bytes) && FVoxelChunkCodec::Decode(Bytes, OutChunk)
+                    ? EVoxelChunkLoadResult::Loaded : EVoxelChunkLoadResult::Failed;
+            }
+        }
+
+        if (!bInRegion)
+        {
+            Result = LoadLooseChunk(WorldName, ChunkPos, OutChunk);
+
+            // 区域文件打不开时无法确定区块是否保存过，不能当作未保存
+            if (Result == EVoxelChunkLoadResult::NotFound && bRegionUnreadable)
+                Result = EVoxelChunkLoadResult::Failed;
+        }
+    }
+
+    if (Result == EVoxelChunkLoadResult::Failed)
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("LoadChunkSync: chunk %d,%d in world %s could not be read"), ChunkPos.X, ChunkPos.Y, *WorldName);
+    }
+    return Result == EVoxelChunkLoadResult::Loaded;
+}
+
+EVoxelChunkLoadResult UVoxelPersistenceSubsystem::LoadLooseChunk(const FString& WorldName, const FIntPoint& ChunkPos, FVoxelChunkData& OutChunk)
+{
     FString ChunkPath = FVoxelPersistencePaths::GetChunkFilePath(WorldName, ChunkPos);
+    if (FPaths::FileExists(ChunkPath))
+        return FVoxelChunkCodec::LoadChunkFromFile(ChunkPath, OutChunk) ? EVoxelChunkLoadResult::Loaded : EVoxelChunkLoadResult::Failed;
+
+    // 更早的存档：JSON 区块文件
+    FString LegacyPath = FVoxelPersistencePaths::GetLegacyChunkFilePath(WorldName, ChunkPos);
+    if (!FPaths::FileExists(LegacyPath))
+        return EVoxelChunkLoadResult::NotFound;
+
     TSharedPtr<FJsonObject> Json;
-    if (!FVoxelPersistenceJsonUtils::LoadJsonFromFile(ChunkPath, Json))
-        return false;
+    if (!FVoxelPersistenceJsonUtils::LoadJsonFromFile(LegacyPath, Json) || !FVoxelPersistenceJsonUtils::FromJson(Json, OutChunk))
+        return EVoxelChunkLoadResult::Failed;
 
-    return FVoxelPersistenceJsonUtils::FromJson(Json, OutChunk);
+    return EVoxelChunkLoadResult::Loaded;
+}
+
+// --- 异步区块加载 ---
+void UVoxelPersistenceSubsystem::LoadChunksAsync(const FString& WorldName, const TArray<FIntPoint>& ChunkPositions, const FOnVoxelChunkLoaded& OnChunkLoaded)
+{
+    if (WorldName.IsEmpty())
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("LoadChunksAsync: WorldName is empty!"));
+        return;
+    }
+
+    // 按区域分组（区域按首次出现的顺序，组内保持调用方顺序），分发时同一区域的请求合并为一个任务
+    TMap<FIntPoint, TArray<FIntPoint>> ChunksByRegion;
+    for (const FIntPoint& ChunkPos : ChunkPositions)
+    {
+        ChunksByRegion.FindOrAdd(FVoxelRegionFile::GetRegionCoord(ChunkPos)).Add(ChunkPos);
+    }
+
+    for (const auto& RegionPair : ChunksByRegion)
+    {
+        for (const FIntPoint& ChunkPos : RegionPair.Value)
+        {
+            // 同一区块已在加载中：取消旧请求，只回调最新的
+            if (TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe>* Existing = PendingChunkLoads.Find(ChunkPos))
+            {
+                **Existing = true;
+            }
+
+            FChunkLoadRequest& Request = ChunkLoadQueue.AddDefaulted_GetRef();
+            Request.WorldName = WorldName;
+            Request.ChunkPos = ChunkPos;
+            Request.OnLoaded = OnChunkLoaded;
+            Request.bCancelled = MakeShared<std::atomic<bool>, ESPMode::ThreadSafe>(false);
+            PendingChunkLoads.Add(ChunkPos, Request.bCancelled);
+        }
+    }
+
+    DispatchChunkLoads();
+}
+
+void UVoxelPersistenceSubsystem::CancelChunkLoads(const TArray<FIntPoint>& ChunkPositions)
+{
+    for (const FIntPoint& ChunkPos : ChunkPositions)
+    {
+        TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe> Cancelled;
+        if (PendingChunkLoads.RemoveAndCopyValue(ChunkPos, Cancelled))
+        {
+            *Cancelled = true;
+        }
+    }
+}
+
+void UVoxelPersistenceSubsystem::CancelAllChunkLoads()
+{
+    for (const auto& Pair : PendingChunkLoads)
+    {
+        *Pair.Value = true;
+    }
+    PendingChunkLoads.Reset();
+    ChunkLoadQueue.Reset();
+}
+
+void UVoxelPersistenceSubsystem::Deinitialize()
+{
+    // 仍在运行的任务结果回到游戏线程时子系统已失效，会被直接丢弃
+    CancelAllChunkLoads();
+    Super::Deinitialize();
+}
+
+// 一个后台任务中单个区块的读取结果
+struct FVoxelChunkLoadResult
+{
+    EVoxelChunkLoadResult Result = EVoxelChunkLoadResult::NotFound;
+    FVoxelChunkData Chunk;
+};
+
+void UVoxelPersistenceSubsystem::DispatchChunkLoads()
+{
+    const int32 MaxTasks = FMath::Max(1, MaxConcurrentChunkLoads);
+    while (NumChunkLoadTasksInFlight < MaxTasks && ChunkLoadQueue.Num() > 0)
+    {
+        // 从队首取同一存档、同一区域的连续请求（跳过已取消的）作为一个任务
+        const FString WorldName = ChunkLoadQueue[0].WorldName;
+        const FIntPoint RegionPos = FVoxelRegionFile::GetRegionCoord(ChunkLoadQueue[0].ChunkPos);
+
+        TArray<FChunkLoadRequest> Batch;
+        int32 NumTaken = 0;
+        for (; NumTaken < ChunkLoadQueue.Num() && Batch.Num() < MaxChunksPerLoadTask; NumTaken++)
+        {
+            FChunkLoadRequest& Request = ChunkLoadQueue[NumTaken];
+            if (*Request.bCancelled)
+                continue;
+            if (Request.WorldName != WorldName || FVoxelRegionFile::GetRegionCoord(Request.ChunkPos) != RegionPos)
+                break;
+
+            Batch.Add(MoveTemp(Request));
+        }
+        ChunkLoadQueue.RemoveAt(0, NumTaken, false);
+
+        if (Batch.Num() == 0)
+            continue;
+
+        NumChunkLoadTasksInFlight++;
+        TWeakObjectPtr<UVoxelPersistenceSubsystem> WeakThis(this);
+
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, WorldName, RegionPos, Batch = MoveTemp(Batch)]() mutable
+            {
+                // 区域文件只打开一次，读取在读锁内完成；区域数据的解码在锁外进行，多个任务可以并行
+                // 与 LoadChunkSync 相同：区域文件中没有的区块再找单区块文件，同样在读锁内读取，
+                // 避免与先写区域文件再删除单区块文件的保存/整理交错而两边都找不到
+                TArray<TArray<uint8>> RegionBytes;
+                TArray<bool> InRegion;
+                TArray<bool> ReadOk;
+                TArray<FVoxelChunkLoadResult> Results;
+                RegionBytes.SetNum(Batch.Num());
+                InRegion.SetNumZeroed(Batch.Num());
+                ReadOk.SetNumZeroed(Batch.Num());
+                Results.SetNum(Batch.Num());
+                {
+                    FReadScopeLock Lock(GRegionFileLock);
+                    const FString RegionPath = FVoxelPersistencePaths::GetRegionFilePath(WorldName, RegionPos);
+                    FVoxelRegionFile Region;
+                    bool bRegionUnreadable = false;
+                    if (FPaths::FileExists(RegionPath))
+                    {
+                        if (Region.Open(RegionPath, false))
+                        {
+                            for (int32 i = 0; i < Batch.Num(); i++)
+                            {
+                                if (*Batch[i].bCancelled)
+                                    continue;
+
+                                // 偏移表项已损坏的区块按读取失败处理
+                                if (Region.IsChunkCorrupt(Batch[i].ChunkPos))
+                                {
+                                    InRegion[i] = true;
+                                    continue;
+                                }
+
+                                if (!Region.HasChunk(Batch[i].ChunkPos))
+                                    continue;
+
+                                InRegion[i] = true;
+                                ReadOk[i] = Region.ReadChunk(Batch[i].ChunkPos, RegionBytes[i]);
+                            }
+                        }
+                        else
+                        {
+                            bRegionUnreadable = true;
+                        }
+                    }
+
+                    for (int32 i = 0; i < Batch.Num(); i++)
+                    {
+                        if (*Batch[i].bCancelled || InRegion[i])
+                            continue;
+
+                        FVoxelChunkLoadResult& Result = Results[i];
+                        Result.Result = LoadLooseChunk(WorldName, Batch[i].ChunkPos, Result.Chunk);
+
+                        // 区域文件打不开时无法确定区块是否保存过，不能当作未保存
+                        if (Result.Result == EVoxelChunkLoadResult::NotFound && bRegionUnreadable)
+                            Result.Result = EVoxelChunkLoadResult::Failed;
+                    }
+                }
+
+                // 解码区域数据；读取或解码失败与未存档分开报告
+                for (int32 i = 0; i < Batch.Num(); i++)
+                {
+                    if (*Batch[i].bCancelled)
+                        continue;
+
+                    FVoxelChunkLoadResult& Result = Results[i];
+                    if (InRegion[i])
+                    {
+                        Result.Result = ReadOk[i] && FVoxelChunkCodec::Decode(RegionBytes[i], Result.Chunk)
+                            ? EVoxelChunkLoadResult::Loaded : EVoxelChunkLoadResult::Failed;
+                    }
+                    RegionBytes[i].Empty();
+
+                    if (Result.Result == EVoxelChunkLoadResult::Failed)
+                    {
+                        UE_LOG(H_LogVoxelPersistence, Error, TEXT("LoadChunksAsync: chunk %d,%d in world %s could not be read"),
+                            Batch[i].ChunkPos.X, Batch[i].ChunkPos.Y, *WorldName);
+                    }
+                }
+
+                AsyncTask(ENamedThreads::GameThread, [WeakThis, Batch = MoveTemp(Batch), Results = MoveTemp(Results)]()
+                    {
+                        UVoxelPersistenceSubsystem* This = WeakThis.Get();
+                        if (!This)
+                            return;
+
+                        This->NumChunkLoadTasksInFlight--;
+                        for (int32 i = 0; i < Batch.Num(); i++)
+                        {
+                            // 回调中可能取消本批后面的区块，逐个检查
+                            const FChunkLoadRequest& Request = Batch[i];
+                            if (*Request.bCancelled)
+                                continue;
+
+                            // 先移出等待表，回调中可以再次请求同一区块
+                            This->PendingChunkLoads.Remove(Request.ChunkPos);
+                            Request.OnLoaded.ExecuteIfBound(Request.ChunkPos, Results[i].Result, Results[i].Chunk);
+                        }
+
+                        This->DispatchChunkLoads();
+                    });
+            });
+    }
+}
+
+// 删除区块的单区块文件（已写入区域文件）
+static void DeleteLooseChunkFiles(const FString& WorldName, const FIntPoint& ChunkPos)
+{
+    IFileManager::Get().Delete(*FVoxelPersistencePaths::GetChunkFilePath(WorldName, ChunkPos), false, false, true);
+    IFileManager::Get().Delete(*FVoxelPersistencePaths::GetLegacyChunkFilePath(WorldName, ChunkPos), false, false, true);
+}
+
+// 查找存档中所有单区块文件的区块坐标（chunk_X_Y.vxc / chunk_X_Y.json）
+static void FindLooseChunks(const FString& WorldName, TSet<FIntPoint>& OutChunks)
+{
+    TArray<FString> LooseFiles;
+    IFileManager::Get().FindFiles(LooseFiles, *(FVoxelPersistencePaths::GetChunkDir(WorldName) / TEXT("chunk_*.*")), true, false);
+
+    for (const FString& FileName : LooseFiles)
+    {
+        // chunk_X_Y（坐标可能为负）
+        TArray<FString> Parts;
+        FPaths::GetBaseFilename(FileName).ParseIntoArray(Parts, TEXT("_"));
+        if (Parts.Num() == 3 && Parts[1].IsNumeric() && Parts[2].IsNumeric())
+        {
+            OutChunks.Add(FIntPoint(FCString::Atoi(*Parts[1]), FCString::Atoi(*Parts[2])));
+        }
+    }
+}
+
+// 查找存档中所有区域文件的区域坐标（r.X.Y.vxr）
+static void FindRegions(const FString& WorldName, TArray<FIntPoint>& OutRegions)
+{
+    TArray<FString> RegionFiles;
+    IFileManager::Get().FindFiles(RegionFiles, *(FVoxelPersistencePaths::GetRegionDir(WorldName) / TEXT("r.*.vxr")), true, false);
+
+    for (const FString& FileName : RegionFiles)
+    {
+        TArray<FString> Parts;
+        FPaths::GetBaseFilename(FileName).ParseIntoArray(Parts, TEXT("."));
+        if (Parts.Num() == 3 && Parts[1].IsNumeric() && Parts[2].IsNumeric())
+        {
+            OutRegions.Add(FIntPoint(FCString::Atoi(*Parts[1]), FCString::Atoi(*Parts[2])));
+        }
+    }
 }
 
 // --- Internal: Save on background thread ---
@@ -104,18 +424,291 @@ bool UVoxelPersistenceSubsystem::SaveWorld_Internal(
         return false;
     }
 
-    // Save chunks
+    // Save chunks：按区域分组，每个区域文件只打开一次
+    TMap<FIntPoint, TArray<const FVoxelChunkData*>> ChunksByRegion;
     for (const auto& Pair : ModifiedChunks)
     {
-        FString ChunkPath = FVoxelPersistencePaths::GetChunkFilePath(WorldName, Pair.Key);
-        TSharedPtr<FJsonObject> ChunkJson = FVoxelPersistenceJsonUtils::ToJson(Pair.Value);
-        if (!FVoxelPersistenceJsonUtils::SaveJsonToFile(ChunkPath, ChunkJson))
+        ChunksByRegion.FindOrAdd(FVoxelRegionFile::GetRegionCoord(Pair.Key)).Add(&Pair.Value);
+    }
+
+    // 旧存档留下的单区块文件：写入区域文件后删除，避免文件数只增不减
+    const bool bHasLooseChunks = IFileManager::Get().DirectoryExists(*FVoxelPersistencePaths::GetChunkDir(WorldName));
+
+    TArray<uint8> ChunkBytes;
+    for (const auto& RegionPair : ChunksByRegion)
+    {
+        FWriteScopeLock Lock(GRegionFileLock);
+        FVoxelRegionFile Region;
+        if (!Region.Open(FVoxelPersistencePaths::GetRegionFilePath(WorldName, RegionPair.Key), true))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to open region %d,%d for world: %s"), RegionPair.Key.X, RegionPair.Key.Y, *WorldName);
+            return false;
+        }
+
+        for (const FVoxelChunkData* Chunk : RegionPair.Value)
+        {
+            // 编码缓冲区在区块间复用；压缩方式与布局由存档设置决定（默认 LZ4 + 调色板，保存耗时最短）
+            FVoxelChunkCodec::Encode(*Chunk, ChunkBytes, Meta.ChunkCompression, Meta.ChunkLayout);
+            if (!Region.WriteChunk(Chunk->ChunkCoordinate, ChunkBytes))
+            {
+                UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to save chunk %d,%d for world: %s"),
+                    Chunk->ChunkCoordinate.X, Chunk->ChunkCoordinate.Y, *WorldName);
+                return false;
+            }
+
+            if (bHasLooseChunks)
+                DeleteLooseChunkFiles(WorldName, Chunk->ChunkCoordinate);
+        }
+    }
+
+    UE_LOG(H_LogVoxelPersistence, Log, TEXT("Successfully saved world: %s (chunks: %d, regions: %d)"), *WorldName, ModifiedChunks.Num(), ChunksByRegion.Num());
+    return true;
+}
+
+// --- 整理存档 ---
+bool UVoxelPersistenceSubsystem::CompactWorld(const FString& WorldName)
+{
+    if (!DoesWorldExist(WorldName))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("CompactWorld: world not found: %s"), *WorldName);
+        return false;
+    }
+
+    FWriteScopeLock Lock(GRegionFileLock);
+    const double StartTime = FPlatformTime::Seconds();
+
+    //------ 1. 单区块文件并入区域文件（chunk_X_Y.vxc 优先于同名 .json）------
+    TSet<FIntPoint> LooseChunks;
+    FindLooseChunks(WorldName, LooseChunks);
+
+    // 迁移的区块按存档设置的压缩方式与布局编码
+    FVoxelWorldMeta Meta;
+    LoadMeta(WorldName, Meta);
+
+    int32 NumMigrated = 0;
+    TArray<uint8> ChunkBytes;
+    for (const FIntPoint& ChunkPos : LooseChunks)
+    {
+        // 区域文件中已有的区块更新，单区块文件是过期数据
+        FVoxelRegionFile Region;
+        if (!Region.Open(FVoxelPersistencePaths::GetRegionFilePath(WorldName, FVoxelRegionFile::GetRegionCoord(ChunkPos)), true))
+            return false;
+
+        if (!Region.HasChunk(ChunkPos))
         {
-            UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to save chunk %d,%d for world: %s"), Pair.Key.X, Pair.Key.Y, *WorldName);
+            FVoxelChunkData Chunk;
+            if (LoadLooseChunk(WorldName, ChunkPos, Chunk) != EVoxelChunkLoadResult::Loaded)
+            {
+                UE_LOG(H_LogVoxelPersistence, Warning, TEXT("CompactWorld: skipping unreadable chunk %d,%d"), ChunkPos.X, ChunkPos.Y);
+                continue;
+            }
+
+            Chunk.ChunkCoordinate = ChunkPos;
+            FVoxelChunkCodec::Encode(Chunk, ChunkBytes, Meta.ChunkCompression, Meta.ChunkLayout);
+            if (!Region.WriteChunk(ChunkPos, ChunkBytes))
+                return false;
+            NumMigrated++;
+        }
+        Region.Close();
+        DeleteLooseChunkFiles(WorldName, ChunkPos);
+    }
+
+    //------ 2. 去除区域文件中的空洞 ------
+    TArray<FString> RegionFiles;
+    const FString RegionDir = FVoxelPersistencePaths::GetRegionDir(WorldName);
+    IFileManager::Get().FindFiles(RegionFiles, *(RegionDir / TEXT("*.vxr")), true, false);
+
+    int64 TotalReclaimed = 0;
+    for (const FString& FileName : RegionFiles)
+    {
+        int64 Reclaimed = 0;
+        if (!FVoxelRegionFile::Compact(RegionDir / FileName, &Reclaimed))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("CompactWorld: failed to compact %s"), *FileName);
             return false;
         }
+        TotalReclaimed += Reclaimed;
+    }
+
+    UE_LOG(H_LogVoxelPersistence, Log, TEXT("CompactWorld: %s - migrated %d loose chunks, compacted %d regions, reclaimed %lld KB in %.2f s"),
+        *WorldName, NumMigrated, RegionFiles.Num(), TotalReclaimed / 1024, FPlatformTime::Seconds() - StartTime);
+    return true;
+}
+
+// --- 导出存档 ---
+bool UVoxelPersistenceSubsystem::ExportWorld(const FString& WorldName, const FString& ExportName, EVoxelChunkCompression Compression)
+{
+    FVoxelWorldMeta Meta;
+    if (!LoadMeta(WorldName, Meta))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("ExportWorld: world not found: %s"), *WorldName);
+        return false;
+    }
+    if (ExportName.IsEmpty() || ExportName == WorldName || DoesWorldExist(ExportName))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("ExportWorld: invalid or existing export name: %s"), *ExportName);
+        return false;
+    }
+
+    FWriteScopeLock Lock(GRegionFileLock);
+    const double StartTime = FPlatformTime::Seconds();
+
+    // 中途失败时删除不完整的导出
+    auto Fail = [&ExportName]()
+    {
+        IFileManager::Get().DeleteDirectory(*FVoxelPersistencePaths::GetWorldSaveDir(ExportName), false, true);
+        return false;
+    };
+
+    int32 NumChunks = 0;
+    int64 ExportBytes = 0;
+    TArray<uint8> ChunkBytes;
+    auto ExportChunk = [&](FVoxelRegionFile& Target, const FVoxelChunkData& Chunk)
+    {
+        FVoxelChunkCodec::Encode(Chunk, ChunkBytes, Compression, Meta.ChunkLayout);
+        NumChunks++;
+        ExportBytes += ChunkBytes.Num();
+        return Target.WriteChunk(Chunk.ChunkCoordinate, ChunkBytes);
+    };
+
+    //------ 1. 区域文件中的区块：解码后以新的压缩方式重新编码 ------
+    TSet<FIntPoint> ExportedChunks;
+    TArray<FIntPoint> Regions;
+    FindRegions(WorldName, Regions);
+    for (const FIntPoint& RegionPos : Regions)
+    {
+        FVoxelRegionFile Source;
+        FVoxelRegionFile Target;
+        if (!Source.Open(FVoxelPersistencePaths::GetRegionFilePath(WorldName, RegionPos), false)
+            || !Target.Open(FVoxelPersistencePaths::GetRegionFilePath(ExportName, RegionPos), true))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("ExportWorld: failed to open region %d,%d"), RegionPos.X, RegionPos.Y);
+            return Fail();
+        }
+
+        for (int32 LocalY = 0; LocalY < FVoxelRegionFile::RegionSize; LocalY++)
+        {
+            for (int32 LocalX = 0; LocalX < FVoxelRegionFile::RegionSize; LocalX++)
+            {
+                const FIntPoint ChunkPos = RegionPos * FVoxelRegionFile::RegionSize + FIntPoint(LocalX, LocalY);
+                if (!Source.HasChunk(ChunkPos))
+                    continue;
+
+                FVoxelChunkData Chunk;
+                if (!Source.ReadChunk(ChunkPos, ChunkBytes) || !FVoxelChunkCodec::Decode(ChunkBytes, Chunk))
+                {
+                    UE_LOG(H_LogVoxelPersistence, Warning, TEXT("ExportWorld: skipping unreadable chunk %d,%d"), ChunkPos.X, ChunkPos.Y);
+                    continue;
+                }
+
+                Chunk.ChunkCoordinate = ChunkPos;
+                if (!ExportChunk(Target, Chunk))
+                    return Fail();
+                ExportedChunks.Add(ChunkPos);
+            }
+        }
+    }
+
+    //------ 2. 尚未并入区域文件的单区块文件（区域文件中已有的更新，跳过）------
+    TSet<FIntPoint> LooseChunks;
+    FindLooseChunks(WorldName, LooseChunks);
+    for (const FIntPoint& ChunkPos : LooseChunks)
+    {
+        FVoxelChunkData Chunk;
+        if (ExportedChunks.Contains(ChunkPos))
+            continue;
+        if (LoadLooseChunk(WorldName, ChunkPos, Chunk) != EVoxelChunkLoadResult::Loaded)
+        {
+            UE_LOG(H_LogVoxelPersistence, Warning, TEXT("ExportWorld: skipping unreadable chunk %d,%d"), ChunkPos.X, ChunkPos.Y);
+            continue;
+        }
+
+        Chunk.ChunkCoordinate = ChunkPos;
+        FVoxelRegionFile Target;
+        if (!Target.Open(FVoxelPersistencePaths::GetRegionFilePath(ExportName, FVoxelRegionFile::GetRegionCoord(ChunkPos)), true)
+            || !ExportChunk(Target, Chunk))
+        {
+            return Fail();
+        }
+    }
+
+    //------ 3. 元数据最后写入：导出完成前目标存档不可见 ------
+    Meta.WorldName = ExportName;
+    if (!FVoxelPersistenceJsonUtils::SaveJsonToFile(FVoxelPersistencePaths::GetMetaFilePath(ExportName), FVoxelPersistenceJsonUtils::ToJson(Meta)))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("ExportWorld: failed to save meta file for: %s"), *ExportName);
+        return Fail();
     }
 
-    UE_LOG(H_LogVoxelPersistence, Log, TEXT("Successfully saved world: %s (chunks: %d)"), *WorldName, ModifiedChunks.Num());
+    UE_LOG(H_LogVoxelPersistence, Log, TEXT("ExportWorld: %s -> %s (%s) - %d chunks, %lld KB in %.2f s"),
+        *WorldName, *ExportName, *StaticEnum<EVoxelChunkCompression>()->GetNameStringByValue(static_cast<int64>(Compression)), NumChunks, ExportBytes / 1024, FPlatformTime::Seconds() - StartTime);
     return true;
-}
\ No newline at end of file
+}
+
+static FAutoConsoleCommand GVoxelCompactWorldCommand(
+    TEXT("Voxel.CompactWorld"),
+    TEXT("Move loose chunk files of a saved world into region files and remove unused sectors. Usage: Voxel.CompactWorld <WorldName>"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            if (Args.Num() < 1)
+            {
+                UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Usage: Voxel.CompactWorld <WorldName>"));
+                return;
+            }
+            UVoxelPersistenceSubsystem::CompactWorld(Args[0]);
+        }));
+
+static FAutoConsoleCommand GVoxelExportWorldCommand(
+    TEXT("Voxel.ExportWorld"),
+    TEXT("Re-encode every chunk of a saved world into a new world with the given compression. Usage: Voxel.ExportWorld <WorldName> <ExportName> [None|LZ4|Zlib|Oodle=Oodle]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            if (Args.Num() < 2)
+            {
+                UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Usage: Voxel.ExportWorld <WorldName> <ExportName> [None|LZ4|Zlib|Oodle]"));
+                return;
+            }
+
+            EVoxelChunkCompression Compression = EVoxelChunkCompression::Oodle;
+            if (Args.Num() > 2)
+            {
+                const int64 Value = StaticEnum<EVoxelChunkCompression>()->GetValueByNameString(Args[2]);
+                if (Value == INDEX_NONE)
+                {
+                    UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Voxel.ExportWorld: unknown compression '%s'"), *Args[2]);
+                    return;
+                }
+                Compression = static_cast<EVoxelChunkCompression>(Value);
+            }
+            UVoxelPersistenceSubsystem::ExportWorld(Args[0], Args[1], Compression);
+        }));
+
+static FAutoConsoleCommandWithWorldAndArgs GVoxelDumpChunkJsonCommand(
+    TEXT("Voxel.DumpChunkJson"),
+    TEXT("Write one saved chunk as readable column-run JSON to <World>/debug/chunk_X_Y.json. Usage: Voxel.DumpChunkJson <WorldName> <ChunkX> <ChunkY>"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+            UVoxelPersistenceSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UVoxelPersistenceSubsystem>() : nullptr;
+            if (!Subsystem || Args.Num() < 3)
+            {
+                UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Usage: Voxel.DumpChunkJson <WorldName> <ChunkX> <ChunkY>"));
+                return;
+            }
+
+            const FIntPoint ChunkPos(FCString::Atoi(*Args[1]), FCString::Atoi(*Args[2]));
+            FVoxelChunkData Chunk;
+            if (!Subsystem->LoadChunkSync(Args[0], ChunkPos, Chunk))
+            {
+                UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Voxel.DumpChunkJson: chunk %d,%d not found or unreadable in world %s"), ChunkPos.X, ChunkPos.Y, *Args[0]);
+                return;
+            }
+
+            // 不写入 chunks 目录，避免被当作旧存档读取或被 CompactWorld 迁移
+            const FString DumpPath = FVoxelPersistencePaths::GetWorldSaveDir(Args[0]) / TEXT("debug")
+                / FPaths::GetCleanFilename(FVoxelPersistencePaths::GetLegacyChunkFilePath(Args[0], ChunkPos));
+            if (FVoxelPersistenceJsonUtils::SaveJsonToFile(DumpPath, FVoxelPersistenceJsonUtils::ToJson(Chunk)))
+            {
+                UE_LOG(H_LogVoxelPersistence, Display, TEXT("Voxel.DumpChunkJson: wrote %s"), *DumpPath);
+            }
+        }));
@@ -0,0 +1,310 @@
+﻿
+// VoxelRegionFile.cpp
+#include "VoxelRegionFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "LogVoxelPersistence.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "FVoxelRegionFile writes its header and offset table in native (little-endian) order");
+static_assert(FVoxelRegionFile::NumEntries * 8 == (FVoxelRegionFile::HeaderSectors - 1) * FVoxelRegionFile::SectorSize,
+    "Offset table must fill the sectors after the file header exactly");
+
+// 补齐扇区用的零
+static const uint8 GZeroSector[FVoxelRegionFile::SectorSize] = {};
+
+FVoxelRegionFile::FVoxelRegionFile() = default;
+
+FVoxelRegionFile::~FVoxelRegionFile()
+{
+    Close();
+}
+
+static int32 FloorDiv(int32 Value, int32 Divisor)
+{
+    return Value >= 0 ? Value / Divisor : (Value - Divisor + 1) / Divisor;
+}
+
+FIntPoint FVoxelRegionFile::GetRegionCoord(const FIntPoint& ChunkPos)
+{
+    return FIntPoint(FloorDiv(ChunkPos.X, RegionSize), FloorDiv(ChunkPos.Y, RegionSize));
+}
+
+int32 FVoxelRegionFile::GetEntryIndex(const FIntPoint& ChunkPos)
+{
+    const FIntPoint Region = GetRegionCoord(ChunkPos);
+    return (ChunkPos.X - Region.X * RegionSize) + (ChunkPos.Y - Region.Y * RegionSize) * RegionSize;
+}
+
+// --- Open / Close ---
+bool FVoxelRegionFile::Open(const FString& FilePath, bool bInWritable)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (bInWritable)
+    {
+        IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+        // bAppend 只把初始位置放在末尾，不截断；之后可任意 Seek 覆盖
+        Handle.Reset(PlatformFile.OpenWrite(*FilePath, /*bAppend*/true, /*bAllowRead*/true));
+    }
+    else
+    {
+        Handle.Reset(PlatformFile.OpenRead(*FilePath));
+    }
+    if (!Handle.IsValid())
+        return false;
+
+    Path = FilePath;
+    bWritable = bInWritable;
+    Entries.SetNumZeroed(NumEntries);
+    CorruptEntries.Init(false, NumEntries);
+
+    const int64 FileSize = Handle->Size();
+    if (FileSize == 0 && bWritable)
+    {
+        // 新文件：写入文件头与空偏移表
+        uint32 Header[3] = { Magic, CurrentVersion, SectorSize };
+        UsedSectors.Init(true, HeaderSectors);
+        if (!WriteSectors(0, TConstArrayView<uint8>(reinterpret_cast<const uint8*>(Header), sizeof(Header)))
+            || !Handle->Seek(SectorSize) || !Handle->Write(GZeroSector, SectorSize) || !Handle->Write(GZeroSector, SectorSize))
+        {
+            UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to initialize region file: %s"), *FilePath);
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    // 读取并校验文件头与偏移表
+    uint32 Header[3] = {};
+    if (FileSize < HeaderSectors * SectorSize || !Handle->Seek(0) || !Handle->Read(reinterpret_cast<uint8*>(Header), sizeof(Header))
+        || Header[0] != Magic || Header[1] > CurrentVersion || Header[2] != SectorSize
+        || !Handle->Seek(SectorSize) || !Handle->Read(reinterpret_cast<uint8*>(Entries.GetData()), NumEntries * sizeof(FEntry)))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Not a valid region file: %s"), *FilePath);
+        Close();
+        return false;
+    }
+
+    // 越界或与其他区块重叠的项视为损坏，丢弃（写入时会被新数据覆盖）；记录下来，读取时报告失败而不是未保存
+    const int32 FileSectors = static_cast<int32>((FileSize + SectorSize - 1) / SectorSize);
+    UsedSectors.Init(false, FileSectors);
+    SetSectorsUsed(0, HeaderSectors, true);
+    for (int32 Index = 0; Index < NumEntries; Index++)
+    {
+        FEntry& Entry = Entries[Index];
+        if (Entry.ByteLength == 0)
+            continue;
+
+        const int64 EndSector = static_cast<int64>(Entry.FirstSector) + Entry.GetNumSectors();
+        bool bValid = Entry.FirstSector >= static_cast<uint32>(HeaderSectors) && EndSector <= FileSectors;
+        for (int32 Sector = Entry.FirstSector; bValid && Sector < EndSector; Sector++)
+        {
+            bValid = !UsedSectors[Sector];
+        }
+
+        if (!bValid)
+        {
+            UE_LOG(H_LogVoxelPersistence, Warning, TEXT("Region file %s: entry %d is out of range or overlaps another chunk, ignored"),
+                *FilePath, Index);
+            Entry = FEntry();
+            CorruptEntries[Index] = true;
+            continue;
+        }
+        SetSectorsUsed(Entry.FirstSector, Entry.GetNumSectors(), true);
+    }
+    return true;
+}
+
+void FVoxelRegionFile::Close()
+{
+    if (Handle.IsValid())
+    {
+        if (bWritable)
+            Handle->Flush();
+        Handle.Reset();
+    }
+    Entries.Reset();
+    CorruptEntries.Reset();
+    UsedSectors.Reset();
+}
+
+// --- 查询 ---
+bool FVoxelRegionFile::HasChunk(const FIntPoint& ChunkPos) const
+{
+    return IsOpen() && Entries[GetEntryIndex(ChunkPos)].ByteLength > 0;
+}
+
+bool FVoxelRegionFile::IsChunkCorrupt(const FIntPoint& ChunkPos) const
+{
+    return IsOpen() && CorruptEntries[GetEntryIndex(ChunkPos)];
+}
+
+int32 FVoxelRegionFile::GetNumChunks() const
+{
+    int32 Count = 0;
+    for (const FEntry& Entry : Entries)
+    {
+        Count += Entry.ByteLength > 0 ? 1 : 0;
+    }
+    return Count;
+}
+
+int32 FVoxelRegionFile::GetNumUsedSectors() const
+{
+    return UsedSectors.CountSetBits();
+}
+
+// --- 读写 ---
+bool FVoxelRegionFile::ReadChunk(const FIntPoint& ChunkPos, TArray<uint8>& OutBytes)
+{
+    if (!IsOpen())
+        return false;
+
+    const FEntry& Entry = Entries[GetEntryIndex(ChunkPos)];
+    if (Entry.ByteLength == 0)
+        return false;
+
+    OutBytes.SetNumUninitialized(Entry.ByteLength);
+    if (!Handle->Seek(static_cast<int64>(Entry.FirstSector) * SectorSize) || !Handle->Read(OutBytes.GetData(), Entry.ByteLength))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Region file %s: failed to read chunk (%d, %d)"), *Path, ChunkPos.X, ChunkPos.Y);
+        return false;
+    }
+    return true;
+}
+
+bool FVoxelRegionFile::WriteChunk(const FIntPoint& ChunkPos, TConstArrayView<uint8> Bytes)
+{
+    if (!IsOpen() || !bWritable || Bytes.Num() == 0)
+        return false;
+
+    const int32 Index = GetEntryIndex(ChunkPos);
+    FEntry& Entry = Entries[Index];
+    const int32 OldSectors = Entry.GetNumSectors();
+    const int32 NewSectors = (Bytes.Num() + SectorSize - 1) / SectorSize;
+
+    int32 FirstSector = Entry.FirstSector;
+    if (OldSectors == 0 || NewSectors > OldSectors)
+    {
+        // 原位置放不下：找空洞或追加到末尾；旧扇区此时仍标记为占用，新数据不会覆盖唯一有效的旧副本
+        FirstSector = FindFreeSectors(NewSectors);
+    }
+
+    if (!WriteSectors(FirstSector, Bytes))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Region file %s: failed to write chunk (%d, %d)"), *Path, ChunkPos.X, ChunkPos.Y);
+        return false;
+    }
+    SetSectorsUsed(FirstSector, NewSectors, true);
+
+    const FEntry OldEntry = Entry;
+    Entry.FirstSector = static_cast<uint32>(FirstSector);
+    Entry.ByteLength = static_cast<uint32>(Bytes.Num());
+    if (!WriteEntry(Index))
+    {
+        // 偏移表未更新：仍指向旧数据，新写入的扇区归还（原地覆盖时与旧数据重合，保持占用）
+        if (FirstSector != static_cast<int32>(OldEntry.FirstSector))
+            SetSectorsUsed(FirstSector, NewSectors, false);
+        Entry = OldEntry;
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Region file %s: failed to update offset table for chunk (%d, %d)"), *Path, ChunkPos.X, ChunkPos.Y);
+        return false;
+    }
+    CorruptEntries[Index] = false;
+
+    // 偏移表已指向新数据，再归还旧扇区；原地覆盖时只归还多出来的尾部
+    if (OldSectors > 0 && FirstSector != static_cast<int32>(OldEntry.FirstSector))
+        SetSectorsUsed(OldEntry.FirstSector, OldSectors, false);
+    else if (NewSectors < OldSectors)
+        SetSectorsUsed(OldEntry.FirstSector + NewSectors, OldSectors - NewSectors, false);
+    return true;
+}
+
+int32 FVoxelRegionFile::FindFreeSectors(int32 Count) const
+{
+    int32 RunStart = HeaderSectors;
+    for (int32 Sector = HeaderSectors; Sector < UsedSectors.Num(); Sector++)
+    {
+        if (UsedSectors[Sector])
+        {
+            RunStart = Sector + 1;
+        }
+        else if (Sector - RunStart + 1 >= Count)
+        {
+            return RunStart;
+        }
+    }
+
+    // 末尾的空闲扇区可与追加的部分拼接
+    return RunStart;
+}
+
+bool FVoxelRegionFile::WriteSectors(int32 Sector, TConstArrayView<uint8> Bytes)
+{
+    if (!Handle->Seek(static_cast<int64>(Sector) * SectorSize) || !Handle->Write(Bytes.GetData(), Bytes.Num()))
+        return false;
+
+    // 补零到扇区边界，文件长度始终为扇区整数倍
+    const int32 Padding = (SectorSize - Bytes.Num() % SectorSize) % SectorSize;
+    return Padding == 0 || Handle->Write(GZeroSector, Padding);
+}
+
+bool FVoxelRegionFile::WriteEntry(int32 Index)
+{
+    const int64 Offset = SectorSize + static_cast<int64>(Index) * sizeof(FEntry);
+    return Handle->Seek(Offset) && Handle->Write(reinterpret_cast<const uint8*>(&Entries[Index]), sizeof(FEntry));
+}
+
+void FVoxelRegionFile::SetSectorsUsed(int32 FirstSector, int32 Count, bool bUsed)
+{
+    if (FirstSector + Count > UsedSectors.Num())
+        UsedSectors.Add(false, FirstSector + Count - UsedSectors.Num());
+    UsedSectors.SetRange(FirstSector, Count, bUsed);
+}
+
+// --- 整理 ---
+bool FVoxelRegionFile::Compact(const FString& FilePath, int64* OutBytesReclaimed)
+{
+    FVoxelRegionFile Source;
+    if (!Source.Open(FilePath, false))
+        return false;
+
+    const int64 OldSize = static_cast<int64>(Source.GetNumSectors()) * SectorSize;
+    const FString TempPath = FilePath + TEXT(".tmp");
+    IFileManager::Get().Delete(*TempPath, false, false, true);
+
+    // 新文件没有空洞，区块按偏移表顺序依次追加
+    {
+        FVoxelRegionFile Target;
+        if (!Target.Open(TempPath, true))
+            return false;
+
+        TArray<uint8> Bytes;
+        for (int32 Index = 0; Index < NumEntries; Index++)
+        {
+            if (Source.Entries[Index].ByteLength == 0)
+                continue;
+
+            const FIntPoint LocalPos(Index % RegionSize, Index / RegionSize);
+            if (!Source.ReadChunk(LocalPos, Bytes) || !Target.WriteChunk(LocalPos, Bytes))
+            {
+                Target.Close();
+                IFileManager::Get().Delete(*TempPath, false, false, true);
+                return false;
+            }
+        }
+    }
+    Source.Close();
+
+    const int64 NewSize = IFileManager::Get().FileSize(*TempPath);
+    if (!IFileManager::Get().Move(*FilePath, *TempPath, /*Replace*/true))
+    {
+        UE_LOG(H_LogVoxelPersistence, Error, TEXT("Failed to replace region file: %s"), *FilePath);
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        return false;
+    }
+
+    if (OutBytesReclaimed)
+        *OutBytesReclaimed = OldSize - NewSize;
+    return true;
+}
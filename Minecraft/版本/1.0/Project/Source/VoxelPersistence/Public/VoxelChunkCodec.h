@@ -0,0 +1,48 @@
+﻿
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelPersistenceTypes.h"
+
+/**
+ * 区块二进制编解码（.vxc）
+ * 直接读写 FChunkVoxelStorage 的调色板与打包下标，不经过任何中间 DOM，也不展开为 int32 数组。
+ *
+ * 文件布局（小端，UE 支持的平台均为小端）：
+ *   Header : uint32 Magic "VXCK" | uint16 Version | uint16 Flags（低 8 位 EVoxelChunkCompression，高 8 位 EVoxelChunkLayout；版本 1 恒为 0）
+ *            int32 ChunkX | int32 ChunkY | int32 SizeX | int32 SizeY | int32 SizeZ
+ *   Payload: 未压缩时直接为体素数据；
+ *            压缩时为 uint32 UncompressedSize | 压缩后的体素数据（至文件末尾）
+ *   体素数据（Palette 布局）：共 ceil(SizeZ / 16) 段，自下而上
+ *            uint8 BitsPerIndex | uint32 PaletteNum | uint16 Palette[PaletteNum]
+ *            uint32 Words[ceil(段体素数 * BitsPerIndex / 32)]（BitsPerIndex 为 0 时无此项）
+ *   体素数据（ColumnRuns 布局）：uint32 NumRuns | { uint16 BlockID, uint16 Length }[NumRuns]
+ *            按列（X + Y * SizeX 顺序）自下而上，每列游程总长为 SizeZ
+ *
+ * 压缩方式与布局逐区块记录，同一世界中可混合存在；
+ * 压缩后不比原数据小的区块按不压缩写出，游程数组不比 Palette 布局小的区块按 Palette 布局写出。
+ */
+class VOXELPERSISTENCE_API FVoxelChunkCodec
+{
+public:
+    static constexpr uint32 Magic = 0x4B435856; // "VXCK"
+    static constexpr uint16 CurrentVersion = 2;
+
+    // 编码到 OutBytes（覆盖原内容，保留已分配内存，可跨区块复用）
+    static void Encode(const FVoxelChunkData& Chunk, TArray<uint8>& OutBytes,
+        EVoxelChunkCompression Compression = EVoxelChunkCompression::None,
+        EVoxelChunkLayout Layout = EVoxelChunkLayout::Palette);
+
+    // 解码；格式、版本或数据不一致时返回 false，且不修改 OutChunk
+    static bool Decode(TConstArrayView<uint8> Bytes, FVoxelChunkData& OutChunk);
+
+    // 读取已编码区块实际使用的压缩方式与布局；不是区块数据时返回 false
+    static bool GetEncoding(TConstArrayView<uint8> Bytes, EVoxelChunkCompression& OutCompression, EVoxelChunkLayout& OutLayout);
+
+    // 文件 I/O（同步）
+    static bool SaveChunkToFile(const FString& FilePath, const FVoxelChunkData& Chunk,
+        EVoxelChunkCompression Compression = EVoxelChunkCompression::None,
+        EVoxelChunkLayout Layout = EVoxelChunkLayout::Palette);
+    static bool LoadChunkFromFile(const FString& FilePath, FVoxelChunkData& OutChunk);
+};
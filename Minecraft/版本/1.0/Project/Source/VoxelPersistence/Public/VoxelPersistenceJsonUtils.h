@@ -7,6 +7,8 @@
 #include "Dom/JsonObject.h"
 /**
  * JSON 序列化和反序列化工具类
+ * 用于 world_meta.json；区块存档使用二进制格式（FVoxelChunkCodec），
+ * 区块 JSON 只用于调试导出（列游程格式，可直接阅读）与旧存档读取
  */
 class VOXELPERSISTENCE_API FVoxelPersistenceJsonUtils
 {
@@ -15,7 +17,7 @@ public:
     static TSharedPtr<FJsonObject> ToJson(const FVoxelWorldMeta& Meta);
     static bool FromJson(const TSharedPtr<FJsonObject>& Json, FVoxelWorldMeta& OutMeta);
 
-    // FVoxelChunkData
+    // FVoxelChunkData：写出列游程格式；读取支持列游程、分段与更早的平铺格式
     static TSharedPtr<FJsonObject> ToJson(const FVoxelChunkData& Chunk);
     static bool FromJson(const TSharedPtr<FJsonObject>& Json, FVoxelChunkData& OutChunk);
 
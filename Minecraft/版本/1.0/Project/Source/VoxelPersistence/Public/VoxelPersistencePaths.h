@@ -15,4 +15,11 @@ public:
     static FString GetMetaFilePath(const FString& WorldName);
     static FString GetChunkDir(const FString& WorldName);
     static FString GetChunkFilePath(const FString& WorldName, const FIntPoint& ChunkPos);
+
+    // 旧版 JSON 区块文件（只读，用于迁移旧存档）
+    static FString GetLegacyChunkFilePath(const FString& WorldName, const FIntPoint& ChunkPos);
+
+    // 区域文件（32 x 32 个区块一个文件）
+    static FString GetRegionDir(const FString& WorldName);
+    static FString GetRegionFilePath(const FString& WorldName, const FIntPoint& RegionPos);
 };
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "VoxelPersistenceTypes.h"
+#include <atomic>
 #include "VoxelPersistenceSubsystem.generated.h"
 
 /**
@@ -12,6 +13,7 @@
 
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnVoxelWorldSaved, bool, bSuccess);
 DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnVoxelWorldLoaded, bool, bSuccess, FVoxelWorldMeta, Meta);
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnVoxelChunkLoaded, FIntPoint, ChunkPos, EVoxelChunkLoadResult, Result, const FVoxelChunkData&, Chunk);
 
 UCLASS()
 class VOXELPERSISTENCE_API UVoxelPersistenceSubsystem : public UGameInstanceSubsystem
@@ -35,15 +37,76 @@ public:
         const FOnVoxelWorldLoaded& OnComplete
     );
 
-    // 同步加载单个区块（通常在生成时调用）
+    // 同步加载单个区块（阻塞调用线程；流式加载请用 LoadChunksAsync）；已保存但读取失败时记录 Error 日志
     UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
     bool LoadChunkSync(const FString& WorldName, const FIntPoint& ChunkPos, FVoxelChunkData& OutChunk);
 
+    // 异步加载一批区块：按区域文件分组，后台线程读取并解码，同时运行的任务不超过 MaxConcurrentChunkLoads。
+    // 每个区块完成后在游戏线程回调一次，Result 区分已读取、未存档与读取失败；同一区块已在加载中时旧请求被取消
+    UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
+    void LoadChunksAsync(const FString& WorldName, const TArray<FIntPoint>& ChunkPositions, const FOnVoxelChunkLoaded& OnChunkLoaded);
+
+    // 取消尚未回调的区块加载（例如区块已离开流式窗口）：排队的不再读取，读取中的结果到达后丢弃
+    UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
+    void CancelChunkLoads(const TArray<FIntPoint>& ChunkPositions);
+
+    // 取消全部区块加载（切换存档、退出世界）
+    UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
+    void CancelAllChunkLoads();
+
+    // 尚未回调的区块加载数量（排队 + 读取中）
+    UFUNCTION(BlueprintPure, Category = "Voxel Persistence")
+    int32 GetNumPendingChunkLoads() const { return PendingChunkLoads.Num(); }
+
+    // 同时运行的后台加载任务上限；每个任务读取同一区域文件中的至多 MaxChunksPerLoadTask 个区块
+    UPROPERTY(BlueprintReadWrite, Category = "Voxel Persistence")
+    int32 MaxConcurrentChunkLoads = 4;
+
+    static constexpr int32 MaxChunksPerLoadTask = 16;
+
     // 工具函数
     UFUNCTION(BlueprintPure, Category = "Voxel Persistence")
     static bool DoesWorldExist(const FString& WorldName);
 
+    // 整理存档（同步）：把散落的单区块文件并入区域文件，再去除区域文件中的空洞
+    UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
+    static bool CompactWorld(const FString& WorldName);
+
+    // 导出存档（同步）：所有区块以 Compression 重新编码，写入新存档 ExportName；默认使用高压缩率的归档格式
+    UFUNCTION(BlueprintCallable, Category = "Voxel Persistence")
+    static bool ExportWorld(const FString& WorldName, const FString& ExportName,
+        EVoxelChunkCompression Compression = EVoxelChunkCompression::Oodle);
+
+    virtual void Deinitialize() override;
+
 private:
+    // 排队的异步区块加载请求；取消标记与后台任务共享
+    struct FChunkLoadRequest
+    {
+        FString WorldName;
+        FIntPoint ChunkPos = FIntPoint::ZeroValue;
+        FOnVoxelChunkLoaded OnLoaded;
+        TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe> bCancelled;
+    };
+
+    // 把排队的请求提交为后台任务（游戏线程）
+    void DispatchChunkLoads();
+
+    // 等待提交的请求（同一区域的请求相邻，可能含已取消的过期项）
+    TArray<FChunkLoadRequest> ChunkLoadQueue;
+
+    // 尚未回调的区块 -> 其最新请求的取消标记；移除并置位即表示取消
+    TMap<FIntPoint, TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe>> PendingChunkLoads;
+
+    // 已提交但结果尚未回到游戏线程的后台任务数量
+    int32 NumChunkLoadTasksInFlight = 0;
+
+    // 读取存档元数据（同步）
+    static bool LoadMeta(const FString& WorldName, FVoxelWorldMeta& OutMeta);
+
+    // 读取单区块文件（.vxc，或更早的 .json）；两种文件都不存在时返回 NotFound
+    static EVoxelChunkLoadResult LoadLooseChunk(const FString& WorldName, const FIntPoint& ChunkPos, FVoxelChunkData& OutChunk);
+
     // 后台线程任务
     static bool SaveWorld_Internal(
         const FString& WorldName,
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ChunkVoxelStorage.h"
 #include "VoxelPersistenceTypes.generated.h"
 
 /**
@@ -9,6 +10,49 @@
  * FVoxelWorldMeta - 存档元数据
  * FVoxelChunkData - 区块数据
  */
+
+/** 区块压缩方式：数值写入区块头，不可更改已有项的值 */
+UENUM(BlueprintType)
+enum class EVoxelChunkCompression : uint8
+{
+    // 不压缩（调色板打包数据原样写出）
+    None    = 0 UMETA(DisplayName = "None"),
+
+    // 速度优先，适合自动保存
+    LZ4     = 1 UMETA(DisplayName = "LZ4 (Fast)"),
+
+    // 通用格式，便于外部工具读取
+    Zlib    = 2 UMETA(DisplayName = "Zlib"),
+
+    // 压缩率优先（Oodle Kraken 最高档），适合归档与导出；压缩慢、解压快
+    Oodle   = 3 UMETA(DisplayName = "Oodle Kraken (Archive)"),
+};
+
+/** 区块体素布局：与压缩方式相互独立，数值写入区块头，不可更改已有项的值 */
+UENUM(BlueprintType)
+enum class EVoxelChunkLayout : uint8
+{
+    // 按 16 高分段的调色板与打包下标（与内存中的 FChunkVoxelStorage 一致）
+    Palette     = 0 UMETA(DisplayName = "Palette Sections"),
+
+    // 按列的游程（BlockID, Length）：自然地形每列只有 5 ~ 6 个游程，编解码接近内存拷贝
+    ColumnRuns  = 1 UMETA(DisplayName = "Column Runs"),
+};
+
+/** 读取单个区块的结果 */
+UENUM(BlueprintType)
+enum class EVoxelChunkLoadResult : uint8
+{
+    // 已读取并解码
+    Loaded      = 0 UMETA(DisplayName = "Loaded"),
+
+    // 存档中没有该区块（从未保存过），可以重新生成
+    NotFound    = 1 UMETA(DisplayName = "Not Found"),
+
+    // 区块已保存，但读取或解码失败（文件损坏、版本不支持等）；不应当作未保存而用生成结果覆盖
+    Failed      = 2 UMETA(DisplayName = "Failed"),
+};
+
 USTRUCT(BlueprintType)
 struct FVoxelWorldMeta
 {
@@ -41,6 +85,14 @@ struct FVoxelWorldMeta
 	/*区块列表*/
     UPROPERTY()
     TArray<FIntPoint> ChunkList;
+
+	/*区块压缩方式（保存时使用；读取时以每个区块头中记录的为准）*/
+    UPROPERTY()
+    EVoxelChunkCompression ChunkCompression = EVoxelChunkCompression::LZ4;
+
+	/*区块体素布局（保存时使用；读取时以每个区块头中记录的为准）*/
+    UPROPERTY()
+    EVoxelChunkLayout ChunkLayout = EVoxelChunkLayout::Palette;
 };
 
 USTRUCT(BlueprintType)
@@ -52,7 +104,7 @@ struct FVoxelChunkData
     UPROPERTY()
     FIntPoint ChunkCoordinate;
 
-    /*体素数据*/
+    /*体素数据（调色板压缩）*/
     UPROPERTY()
-    TArray<int32> VoxelData;
+    FChunkVoxelStorage VoxelData;
 };
\ No newline at end of file
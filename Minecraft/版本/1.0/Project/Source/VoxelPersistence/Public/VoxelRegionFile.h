@@ -0,0 +1,104 @@
+﻿
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/**
+ * 区域文件（.vxr）：32 x 32 个区块共用一个文件，减少存档文件数量
+ *
+ * 文件按 4 KB 扇区组织：
+ *   扇区 0      : 文件头（uint32 Magic "VXCR" | uint32 Version | uint32 SectorSize），其余补零
+ *   扇区 1 - 2  : 偏移表，1024 项 x (uint32 FirstSector, uint32 ByteLength)，ByteLength 为 0 表示没有该区块
+ *   扇区 3 起   : 区块数据（FVoxelChunkCodec 编码），每个区块占用连续的整数个扇区
+ *
+ * 写入时新数据仍放得下原来的扇区则原地覆盖；放不下则优先使用空闲扇区，没有合适的空洞才追加到文件末尾，
+ * 偏移表指向新数据之后才归还旧扇区。
+ * 扇区数变化留下的空洞由 Compact 整理。
+ * 非线程安全：同一文件的并发访问由调用方加锁。
+ */
+class VOXELPERSISTENCE_API FVoxelRegionFile
+{
+public:
+    static constexpr int32 RegionSize = 32;
+    static constexpr int32 NumEntries = RegionSize * RegionSize;
+    static constexpr int32 SectorSize = 4096;
+    static constexpr int32 HeaderSectors = 3;
+    static constexpr uint32 Magic = 0x52435856; // "VXCR"
+    static constexpr uint32 CurrentVersion = 1;
+
+    FVoxelRegionFile();
+    ~FVoxelRegionFile();
+
+    // 区块所在的区域坐标（向下取整）
+    static FIntPoint GetRegionCoord(const FIntPoint& ChunkPos);
+
+    /**
+     * 打开区域文件
+     * @param bWritable 可写：文件不存在时创建；只读：文件不存在时返回 false
+     */
+    bool Open(const FString& FilePath, bool bWritable);
+    void Close();
+    bool IsOpen() const { return Handle.IsValid(); }
+
+    bool HasChunk(const FIntPoint& ChunkPos) const;
+
+    // 偏移表中有该区块但项已损坏（越界或与其他区块重叠，打开时被丢弃）：区块保存过但无法读取
+    bool IsChunkCorrupt(const FIntPoint& ChunkPos) const;
+
+    // 读取区块的编码数据；没有该区块或读取失败时返回 false
+    bool ReadChunk(const FIntPoint& ChunkPos, TArray<uint8>& OutBytes);
+
+    // 写入区块的编码数据（先写数据再更新偏移表）
+    bool WriteChunk(const FIntPoint& ChunkPos, TConstArrayView<uint8> Bytes);
+
+    // 已存区块数量
+    int32 GetNumChunks() const;
+
+    // 文件占用的扇区数（含文件头与空洞）与区块实际使用的扇区数
+    int32 GetNumSectors() const { return UsedSectors.Num(); }
+    int32 GetNumUsedSectors() const;
+
+    /**
+     * 整理区域文件：按偏移表顺序把区块紧密写入临时文件，再替换原文件
+     * @param OutBytesReclaimed 释放的字节数（可为空）
+     */
+    static bool Compact(const FString& FilePath, int64* OutBytesReclaimed = nullptr);
+
+private:
+    struct FEntry
+    {
+        uint32 FirstSector = 0;
+        uint32 ByteLength = 0;
+
+        int32 GetNumSectors() const { return static_cast<int32>((ByteLength + SectorSize - 1) / SectorSize); }
+    };
+
+    static int32 GetEntryIndex(const FIntPoint& ChunkPos);
+
+    // 找到 Count 个连续空闲扇区（首次适配），没有则返回文件末尾
+    int32 FindFreeSectors(int32 Count) const;
+
+    // 在 Sector 处写入数据并补零到扇区边界
+    bool WriteSectors(int32 Sector, TConstArrayView<uint8> Bytes);
+
+    // 把一项偏移表写回文件
+    bool WriteEntry(int32 Index);
+
+    void SetSectorsUsed(int32 FirstSector, int32 Count, bool bUsed);
+
+    TUniquePtr<IFileHandle> Handle;
+    FString Path;
+    bool bWritable = false;
+
+    // 偏移表（NumEntries 项）
+    TArray<FEntry> Entries;
+
+    // 打开时因损坏被丢弃的偏移表项（NumEntries 位），重新写入该区块后清除
+    TBitArray<> CorruptEntries;
+
+    // 每个扇区是否被文件头或区块占用，长度即文件扇区数
+    TBitArray<> UsedSectors;
+};
@@ -6,6 +6,13 @@ public class VoxelPersistence: ModuleRules
     {
         PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
+        // 公共头文件（FVoxelChunkData）使用 FChunkVoxelStorage
+        PublicDependencyModuleNames.AddRange(new string[]
+        {
+            "ChunkBlock"
+        }
+        );
+
         PrivateDependencyModuleNames.AddRange(new string[] 
         {
             "Core",
@@ -3,11 +3,22 @@
 #include "HeightGenerator.h"
 #include "Engine/World.h"
 #include "GameFramework/Actor.h"
+#include "Async/Async.h"
 #include "LogWorldGeneration.h"
 
 void UChunkGenerationManager::Initialize(UWorldGenerationConfig* Config)
 {
     CurrentConfig = Config;
+
+    // 配置切换：仍在运行的旧任务结果作废
+    ConfigGeneration++;
+    PendingChunks.Reset();
+    RequestQueue.Reset();
+    QueuedChunks.Reset();
+    bHasStreamingWindow = false;
+
+    // LOD 阈值可能已改变：下一次更新全量重新计算
+    bHasLODCenter = false;
 }
 
 AActor* UChunkGenerationManager::RequestChunk(int32 ChunkX, int32 ChunkY, UWorld* World)
@@ -31,15 +42,253 @@ AActor* UChunkGenerationManager::RequestChunk(int32 ChunkX, int32 ChunkY, UWorld
         // 弱引用失效（Actor 已被销毁），继续创建新实例
     }
 
-    // 生成新区块
-    AActor* NewChunk = SpawnChunkActor(ChunkX, ChunkY, World);
-    if (!NewChunk)
+    // 已排队或已在后台生成中
+    if (QueuedChunks.Contains(ChunkKey) || PendingChunks.Contains(ChunkKey))
         return nullptr;
 
-    // 缓存并生成数据
-    LoadedChunks.Add(ChunkKey, NewChunk);
-    GenerateChunkData(NewChunk, ChunkX, ChunkY);
-    return NewChunk;
+    // 加入优先级队列，由 DispatchQueuedRequests 按优先级提交
+    StreamingStats.ChunksRequested++;
+    if (bStationaryUpdate)
+    {
+        StreamingStats.StationaryChurnCount++;
+    }
+    QueuedChunks.Add(ChunkKey);
+    RequestQueue.HeapPush(FChunkGenerationRequest{ ChunkKey, ComputeChunkPriority(ChunkKey) }, FChunkGenerationRequestPredicate());
+
+    return nullptr;
+}
+
+void UChunkGenerationManager::UpdateStreamingFocus(const FIntPoint& CenterChunk, const FVector& ViewDirection)
+{
+    const FVector2D NewViewDirection = FVector2D(ViewDirection.X, ViewDirection.Y).GetSafeNormal();
+
+    // 中心不变且视线转向小于约 18° 时保持现有顺序
+    const bool bCenterChanged = CenterChunk != StreamingCenter;
+    const bool bViewChanged = !(NewViewDirection.IsZero() && StreamingViewDirection.IsZero())
+        && (NewViewDirection | StreamingViewDirection) < 0.95f;
+    if (!bCenterChanged && !bViewChanged)
+        return;
+
+    StreamingCenter = CenterChunk;
+    StreamingViewDirection = NewViewDirection;
+    ReprioritizeQueue();
+}
+
+void UChunkGenerationManager::DispatchQueuedRequests()
+{
+    if (!CurrentConfig)
+        return;
+
+    const int32 MaxTasks = FMath::Max(1, CurrentConfig->Params.MaxConcurrentGenerationTasks);
+    while (NumTasksInFlight < MaxTasks && RequestQueue.Num() > 0)
+    {
+        FChunkGenerationRequest Request;
+        RequestQueue.HeapPop(Request, FChunkGenerationRequestPredicate(), false);
+
+        // 已被取消的请求（QueuedChunks 中已移除）直接跳过
+        if (QueuedChunks.Remove(Request.ChunkKey) == 0)
+            continue;
+
+        LaunchGenerationTask(Request.ChunkKey);
+    }
+}
+
+float UChunkGenerationManager::ComputeChunkPriority(const FIntPoint& ChunkKey) const
+{
+    const FIntPoint Offset = ChunkKey - StreamingCenter;
+    const float DistSq = static_cast<float>(GetChunkDistanceSq(ChunkKey, StreamingCenter));
+    if (DistSq <= 0.0f || StreamingViewDirection.IsZero() || !CurrentConfig)
+        return DistSq;
+
+    // 视线正前方系数为 1，正后方为 1 + Weight
+    const float CosAngle = FVector2D(Offset.X, Offset.Y).GetSafeNormal() | StreamingViewDirection;
+    const float Weight = CurrentConfig->Params.ViewDirectionPriorityWeight;
+    return DistSq * (1.0f + Weight * (1.0f - CosAngle) * 0.5f);
+}
+
+void UChunkGenerationManager::ReprioritizeQueue()
+{
+    // 顺带清理已取消的请求
+    RequestQueue.RemoveAll([this](const FChunkGenerationRequest& Request)
+        {
+            return !QueuedChunks.Contains(Request.ChunkKey);
+        });
+
+    for (FChunkGenerationRequest& Request : RequestQueue)
+    {
+        Request.Priority = ComputeChunkPriority(Request.ChunkKey);
+    }
+    RequestQueue.Heapify(FChunkGenerationRequestPredicate());
+}
+
+void UChunkGenerationManager::LaunchGenerationTask(const FIntPoint& ChunkKey)
+{
+    PendingChunks.Add(ChunkKey);
+    NumTasksInFlight++;
+
+    // 后台生成体素数据：参数按值拷贝，任务不访问任何 UObject
+    const FWorldGenParams ParamsCopy = CurrentConfig->Params;
+    const uint32 Generation = ConfigGeneration;
+    TSharedPtr<FChunkGenerationResults, ESPMode::ThreadSafe> Results = GenerationResults;
+
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Results, ChunkKey, Generation, ParamsCopy]()
+        {
+            FGeneratedChunkData Data;
+            Data.ChunkKey = ChunkKey;
+            Data.ConfigGeneration = Generation;
+            BuildChunkVoxels(ChunkKey.X, ChunkKey.Y, ParamsCopy, Data.Voxels);
+
+            Results->Completed.Enqueue(MoveTemp(Data));
+        });
+}
+
+int32 UChunkGenerationManager::ProcessCompletedChunks(UWorld* World)
+{
+    if (!CurrentConfig || !World)
+        return 0;
+
+    // 每帧提交预算，避免一帧内生成大量 Actor 造成卡顿
+    const int32 Budget = FMath::Max(1, CurrentConfig->Params.MaxChunkCommitsPerFrame);
+    int32 Committed = 0;
+
+    // 先执行排队的 LOD 刷新（最近的在末尾）：近处区块的精度变化最显眼，且数量随中心移动有限，不会长期挤占新区块
+    while (Committed < Budget && LODRefreshQueue.Num() > 0)
+    {
+        const FIntPoint ChunkKey = LODRefreshQueue.Pop(false);
+
+        // 已卸载的区块直接跳过
+        if (QueuedLODRefreshes.Remove(ChunkKey) == 0)
+            continue;
+
+        const TWeakObjectPtr<AActor>* ChunkPtr = LoadedChunks.Find(ChunkKey);
+        if (IChunkInterface* CI = Cast<IChunkInterface>(ChunkPtr ? ChunkPtr->Get() : nullptr))
+        {
+            CI->RefreshRendering();
+            Committed++;
+        }
+    }
+
+    FGeneratedChunkData Data;
+    while (Committed < Budget && GenerationResults->Completed.Dequeue(Data))
+    {
+        NumTasksInFlight--;
+
+        // 配置已切换，或请求已被取消（例如玩家已远离）
+        if (Data.ConfigGeneration != ConfigGeneration || PendingChunks.Remove(Data.ChunkKey) == 0)
+            continue;
+
+        AActor* NewChunk = AcquireChunkActor(Data.ChunkKey.X, Data.ChunkKey.Y, World);
+        if (!NewChunk)
+            continue;
+
+        // 缓存并传递给 Chunk Actor
+        LoadedChunks.Add(Data.ChunkKey, NewChunk);
+        if (IChunkInterface* CI = Cast<IChunkInterface>(NewChunk))
+        {
+            // 先定 LOD，首次渲染即为对应精度
+            CI->SetLODLevel(ComputeChunkLOD(Data.ChunkKey, StreamingCenter, 0));
+            CI->SetChunkData(Data.Voxels);
+            LinkChunkNeighbors(Data.ChunkKey, NewChunk);
+            CI->RefreshRendering();
+        }
+        OnChunkResidencyChanged.Broadcast(Data.ChunkKey, true);
+        StreamingStats.ChunksCommitted++;
+        Committed++;
+    }
+
+    return Committed;
+}
+
+/** 区块在世界中的位置（区块原点，X-Y 平面） */
+static FVector GetChunkWorldLocation(int32 ChunkX, int32 ChunkY)
+{
+    // 每个区块物理尺寸：16 格 × 128 cm/格 = 2048 cm
+    const float ChunkSizeCM = 16.0f * 128.0f;
+    // 在 X-Y 平面放置区块，Z=0 表示地面高度（后续由体素数据决定实际地形高度）
+    return FVector(ChunkX * ChunkSizeCM, ChunkY * ChunkSizeCM, 0.0f);
+}
+
+AActor* UChunkGenerationManager::AcquireChunkActor(int32 ChunkX, int32 ChunkY, UWorld* World)
+{
+    const FVector Location = GetChunkWorldLocation(ChunkX, ChunkY);
+
+    // 优先复用对象池中的 Actor（跳过已被外部销毁的）
+    AActor* Chunk = nullptr;
+    while (!Chunk && ChunkActorPool.Num() > 0)
+    {
+        AActor* Candidate = ChunkActorPool.Pop(false);
+        if (IsValid(Candidate) && Candidate->GetWorld() == World)
+        {
+            Chunk = Candidate;
+        }
+    }
+
+    if (Chunk)
+    {
+        // 重新放置并设置逻辑坐标，组件与缓冲区沿用之前的分配
+        Chunk->SetActorLocation(Location);
+        if (IChunkInterface* CI = Cast<IChunkInterface>(Chunk))
+        {
+            CI->SetChunkCoordinates(FIntVector(ChunkX, ChunkY, 0));
+            CI->OnAcquiredFromPool();
+        }
+        StreamingStats.ChunkActorsReused++;
+    }
+    else
+    {
+        Chunk = SpawnChunkActor(ChunkX, ChunkY, World);
+        if (!Chunk)
+            return nullptr;
+        StreamingStats.ChunkActorsSpawned++;
+    }
+
+	//============== 区块边界调试显示 ==============
+#if !(UE_BUILD_SHIPPING)
+    DrawDebugBox(World, Location + FVector(1024, 1024, 512), FVector(1024, 1024, 512), FColor::Green, false, 1000.f);
+#endif
+
+    return Chunk;
+}
+
+void UChunkGenerationManager::ReleaseChunkActor(AActor* Chunk)
+{
+    if (!IsValid(Chunk))
+        return;
+
+    // 池未满：隐藏并回收，保留组件与已分配的缓冲区
+    const int32 MaxPooled = CurrentConfig ? FMath::Max(0, CurrentConfig->Params.MaxPooledChunkActors) : 0;
+    IChunkInterface* CI = Cast<IChunkInterface>(Chunk);
+    if (CI && ChunkActorPool.Num() < MaxPooled)
+    {
+        CI->OnReleasedToPool();
+        ChunkActorPool.Add(Chunk);
+        return;
+    }
+
+    Chunk->Destroy();
+}
+
+void UChunkGenerationManager::WarmUpChunkPool(UWorld* World, int32 Count)
+{
+    if (!CurrentConfig || !World || !ChunkActorClass)
+        return;
+
+    const int32 Target = FMath::Min(Count, CurrentConfig->Params.MaxPooledChunkActors);
+    while (ChunkActorPool.Num() < Target)
+    {
+        AActor* Chunk = SpawnChunkActor(0, 0, World);
+        if (!Chunk)
+            break;
+
+        StreamingStats.ChunkActorsSpawned++;
+        if (IChunkInterface* CI = Cast<IChunkInterface>(Chunk))
+        {
+            CI->OnReleasedToPool();
+        }
+        ChunkActorPool.Add(Chunk);
+    }
+
+    UE_LOG(H_LogWorldGeneration, Log, TEXT("Chunk actor pool warmed up: %d actors"), ChunkActorPool.Num());
 }
 
 AActor* UChunkGenerationManager::SpawnChunkActor(int32 ChunkX, int32 ChunkY, UWorld* World)
@@ -50,10 +299,7 @@ AActor* UChunkGenerationManager::SpawnChunkActor(int32 ChunkX, int32 ChunkY, UWo
         return nullptr;
     }
     
-    // 每个区块物理尺寸：16 格 × 128 cm/格 = 2048 cm
-    const float ChunkSizeCM = 16.0f * 128.0f;
-    // 在 X-Y 平面放置区块，Z=0 表示地面高度（后续由体素数据决定实际地形高度）
-    const FVector Location(ChunkX * ChunkSizeCM, ChunkY * ChunkSizeCM, 0.0f);
+    const FVector Location = GetChunkWorldLocation(ChunkX, ChunkY);
 
     FActorSpawnParameters SpawnParams;
     SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -62,11 +308,6 @@ AActor* UChunkGenerationManager::SpawnChunkActor(int32 ChunkX, int32 ChunkY, UWo
     AActor* Chunk = World->SpawnActor<AActor>(ChunkActorClass, Location, FRotator::ZeroRotator, SpawnParams);   
     if (!Chunk)
         return nullptr;
-    
-	//============== 区块边界调试显示 ==============
-#if !(UE_BUILD_SHIPPING)
-    DrawDebugBox(World, Location + FVector(1024, 1024, 512), FVector(1024, 1024, 512), FColor::Green, false, 1000.f);
-#endif
 
     // 通知区块 Actor 设置其逻辑坐标（Z=0 表示无垂直分块）
     if (IChunkInterface* CI = Cast<IChunkInterface>(Chunk))
@@ -83,52 +324,420 @@ AActor* UChunkGenerationManager::SpawnChunkActor(int32 ChunkX, int32 ChunkY, UWo
     return Chunk;
 }
 
-void UChunkGenerationManager::GenerateChunkData(AActor* Chunk, int32 ChunkX, int32 ChunkY)
+void UChunkGenerationManager::BuildChunkVoxels(int32 ChunkX, int32 ChunkY, const FWorldGenParams& Params, FChunkVoxelStorage& OutVoxels)
 {
-    if (!CurrentConfig || !Chunk)
-        return;
-
-    const FWorldGenParams& Params = CurrentConfig->Params;
-
     // Step 1: 生成 16x16 地表高度图（每个 (x,y) 对应一个地表 Z 值）
     TArray<int32> SurfaceHeights;
     UHeightGenerator::GenerateChunkHeights(ChunkX, ChunkY, Params, SurfaceHeights); // 返回 256 个值，按 x + y*16 存储
 
-    // Step 2: 分配三维体素数据 [X=16][Y=16][Z=WorldHeight]
-    const int32 TotalBlocks = 16 * 16 * Params.WorldHeight; 
-    TArray<int32> Blocks;
-    Blocks.SetNumZeroed(TotalBlocks); // 0 = 空气
+    // Step 2: 分配三维体素数据 [X=16][Y=16][Z=WorldHeight]，按 16 高分段
+    OutVoxels.Init(16, 16, Params.WorldHeight, 0); // 0 = 空气
 
-    // Step 3: 填充体素
-    for (int32 x = 0; x < 16; x++)          // X: 水平方向
+    int32 MinSurfaceZ = MAX_int32;
+    int32 MaxSurfaceZ = MIN_int32;
+    for (int32 SurfaceZ : SurfaceHeights)
     {
-        for (int32 y = 0; y < 16; y++)      // Y: 水平方向
+        MinSurfaceZ = FMath::Min(MinSurfaceZ, SurfaceZ);
+        MaxSurfaceZ = FMath::Max(MaxSurfaceZ, SurfaceZ);
+    }
+
+    // Step 3: 逐段填充体素
+    TArray<int32> SectionBlocks;
+    for (int32 SectionIndex = 0; SectionIndex < OutVoxels.GetNumSections(); SectionIndex++)
+    {
+        const int32 MinZ = OutVoxels.GetSectionMinZ(SectionIndex);
+        const int32 MaxZ = MinZ + OutVoxels.GetSectionSizeZ(SectionIndex) - 1;
+
+        // 整段在最高地表之上：保持空气，不分配数组
+        if (MinZ > MaxSurfaceZ)
+            continue;
+
+        // 整段在基岩之上、最低泥土层之下：整段石头
+        if (MinZ > 0 && MaxZ < MinSurfaceZ - 2)
         {
-            // 获取 (x,y) 处的地表高度（Z 坐标）
-            const int32 SurfaceZ = SurfaceHeights[x + y * 16]; // HeightGenerator 输出按 x + y*16 存储
+            OutVoxels.SetSectionUniform(SectionIndex, 3);
+            continue;
+        }
 
-            // 从底部 (Z=0) 填充到地表 (Z=SurfaceZ)
-            for (int32 z = 0; z <= SurfaceZ && z < Params.WorldHeight; z++)
+        // 跨越地表的段：逐格填充后一次性压缩
+        SectionBlocks.SetNumZeroed(16 * 16 * OutVoxels.GetSectionSizeZ(SectionIndex));
+        for (int32 x = 0; x < 16; x++)          // X: 水平方向
+        {
+            for (int32 y = 0; y < 16; y++)      // Y: 水平方向
             {
-                //世界Z方向方块分配规则
-                const int32 BlockID = (z == 0) ? 2 :
-                    (z == SurfaceZ) ? 1 :
-                    (z >= SurfaceZ - 2 && z < SurfaceZ) ? 7 :
-                    3;
-                const int32 Index = x + y * 16 + z * (16 * 16); // ← 关键：z * (SizeX * SizeY)
-                if (Index >= 0 && Index < Blocks.Num())
+                // 获取 (x,y) 处的地表高度（Z 坐标）
+                const int32 SurfaceZ = SurfaceHeights[x + y * 16]; // HeightGenerator 输出按 x + y*16 存储
+
+                // 从本段底部填充到地表 (Z=SurfaceZ)
+                for (int32 z = MinZ; z <= SurfaceZ && z <= MaxZ; z++)
                 {
-                    Blocks[Index] = BlockID;
+                    SectionBlocks[x + y * 16 + (z - MinZ) * (16 * 16)] = GetTerrainBlockID(z, SurfaceZ); // ← 段内下标：(z - MinZ) * (SizeX * SizeY)
                 }
             }
         }
+        OutVoxels.SetSectionFromArray(SectionIndex, SectionBlocks.GetData(), SectionBlocks.Num());
     }
+}
 
-    // 传递给 Chunk Actor
-    if (IChunkInterface* CI = Cast<IChunkInterface>(Chunk))
+int32 UChunkGenerationManager::GetTerrainBlockID(int32 Z, int32 SurfaceZ)
+{
+    //世界Z方向方块分配规则
+    return (Z == 0) ? 2 :
+        (Z == SurfaceZ) ? 1 :
+        (Z >= SurfaceZ - 2 && Z < SurfaceZ) ? 7 :
+        3;
+}
+
+/** 圆形窗口第 Dy 行（相对中心）的半宽：Dx² + Dy² <= Radius²；行不在窗口内时返回 -1 */
+static int32 GetWindowRowHalfWidth(int32 Dy, int32 Radius)
+{
+    if (Radius < 0 || FMath::Abs(Dy) > Radius)
+        return -1;
+
+    const int32 Remaining = Radius * Radius - Dy * Dy;
+    int32 HalfWidth = FMath::FloorToInt(FMath::Sqrt(static_cast<float>(Remaining)));
+
+    // 修正浮点开方误差，保证与整数距离平方判定完全一致
+    while ((HalfWidth + 1) * (HalfWidth + 1) <= Remaining)
+        HalfWidth++;
+    while (HalfWidth * HalfWidth > Remaining)
+        HalfWidth--;
+    return HalfWidth;
+}
+
+/**
+ * 对位于窗口 A、但不在窗口 B 内的每个区块调用 Callback
+ * 按行求区间差，耗时与窗口行数和差集大小成正比，而不是窗口面积
+ */
+template <typename FuncType>
+static void ForEachChunkInWindowDifference(const FIntPoint& CenterA, int32 RadiusA, const FIntPoint& CenterB, int32 RadiusB, bool bHasB, FuncType&& Callback)
+{
+    for (int32 Dy = -RadiusA; Dy <= RadiusA; Dy++)
+    {
+        const int32 HalfA = GetWindowRowHalfWidth(Dy, RadiusA);
+        if (HalfA < 0)
+            continue;
+
+        const int32 Y = CenterA.Y + Dy;
+        const int32 MinA = CenterA.X - HalfA;
+        const int32 MaxA = CenterA.X + HalfA;
+
+        const int32 HalfB = bHasB ? GetWindowRowHalfWidth(Y - CenterB.Y, RadiusB) : -1;
+        if (HalfB < 0)
+        {
+            for (int32 X = MinA; X <= MaxA; X++)
+                Callback(FIntPoint(X, Y));
+            continue;
+        }
+
+        // A 行区间减去 B 行区间，最多剩下左右两段
+        const int32 MinB = CenterB.X - HalfB;
+        const int32 MaxB = CenterB.X + HalfB;
+        for (int32 X = MinA; X <= FMath::Min(MaxA, MinB - 1); X++)
+            Callback(FIntPoint(X, Y));
+        for (int32 X = FMath::Max(MinA, MaxB + 1); X <= MaxA; X++)
+            Callback(FIntPoint(X, Y));
+    }
+}
+
+int32 UChunkGenerationManager::GetUnloadRadius(int32 LoadRadius) const
+{
+    const int32 Hysteresis = CurrentConfig ? FMath::Max(0, CurrentConfig->Params.UnloadHysteresis) : 1;
+    return LoadRadius + Hysteresis;
+}
+
+void UChunkGenerationManager::BeginStreamingUpdate(const FIntPoint& CenterChunk, int32 Radius)
+{
+    // 中心区块与半径都未变化：本次更新不应产生任何加载或卸载
+    bStationaryUpdate = bHasLastUpdate && CenterChunk == LastUpdateCenter && Radius == LastUpdateRadius;
+    bHasLastUpdate = true;
+    LastUpdateCenter = CenterChunk;
+    LastUpdateRadius = Radius;
+}
+
+void UChunkGenerationManager::UpdateStreamingWindow(const FIntPoint& CenterChunk, int32 Radius, UWorld* World)
+{
+    if (!CurrentConfig || !World || Radius < 0)
+        return;
+
+    // 首次流式更新前预热对象池
+    if (!bHasLastUpdate)
+    {
+        WarmUpChunkPool(World, CurrentConfig->Params.ChunkPoolWarmupCount);
+    }
+
+    BeginStreamingUpdate(CenterChunk, Radius);
+
+    // 玩家仍在同一区块且半径未变：无需任何工作
+    if (bHasStreamingWindow && CenterChunk == WindowCenter && Radius == WindowRadius)
+    {
+        bStationaryUpdate = false;
+        return;
+    }
+
+    // 首次进入增量模式：清理之前（全量模式）遗留在范围外的区块
+    if (!bHasStreamingWindow)
+    {
+        UnloadDistantChunks(CenterChunk, Radius);
+    }
+
+    // 卸载窗口比加载窗口大 UnloadHysteresis 圈，防止边缘来回加载
+    const int32 UnloadRadius = GetUnloadRadius(Radius);
+
+    // 离开卸载窗口的区块：卸载或取消请求
+    if (bHasStreamingWindow)
+    {
+        ForEachChunkInWindowDifference(WindowCenter, WindowUnloadRadius, CenterChunk, UnloadRadius, true,
+            [this](const FIntPoint& ChunkKey)
+            {
+                UnloadChunk(ChunkKey);
+            });
+    }
+
+    // 进入加载窗口的区块：加入请求队列
+    ForEachChunkInWindowDifference(CenterChunk, Radius, WindowCenter, WindowRadius, bHasStreamingWindow,
+        [this, World](const FIntPoint& ChunkKey)
+        {
+            RequestChunk(ChunkKey.X, ChunkKey.Y, World);
+        });
+
+    bHasStreamingWindow = true;
+    WindowCenter = CenterChunk;
+    WindowRadius = Radius;
+    WindowUnloadRadius = UnloadRadius;
+    bStationaryUpdate = false;
+
+    UpdateChunkLODs(CenterChunk);
+}
+
+void UChunkGenerationManager::RescanStreamingArea(const FIntPoint& CenterChunk, int32 Radius, UWorld* World)
+{
+    if (!CurrentConfig || !World || Radius < 0)
+        return;
+
+    // 首次流式更新前预热对象池
+    if (!bHasLastUpdate)
+    {
+        WarmUpChunkPool(World, CurrentConfig->Params.ChunkPoolWarmupCount);
+    }
+
+    BeginStreamingUpdate(CenterChunk, Radius);
+
+    // 卸载远处区块（同时取消超出范围的排队请求）
+    UnloadDistantChunks(CenterChunk, Radius);
+
+    // 请求圆形范围内的区块，与卸载使用同一距离度量
+    for (int32 Dy = -Radius; Dy <= Radius; Dy++)
+    {
+        const int32 HalfWidth = GetWindowRowHalfWidth(Dy, Radius);
+        for (int32 Dx = -HalfWidth; Dx <= HalfWidth; Dx++)
+        {
+            RequestChunk(CenterChunk.X + Dx, CenterChunk.Y + Dy, World);
+        }
+    }
+
+    bStationaryUpdate = false;
+
+    UpdateChunkLODs(CenterChunk);
+}
+
+int32 UChunkGenerationManager::ComputeChunkLOD(const FIntPoint& ChunkKey, const FIntPoint& CenterChunk, int32 CurrentLOD) const
+{
+    if (!CurrentConfig)
+        return 0;
+
+    const TArray<int32>& Distances = CurrentConfig->Params.LODDistances;
+    const float Distance = FMath::Sqrt(static_cast<float>(GetChunkDistanceSq(ChunkKey, CenterChunk)));
+    auto GetLevelAt = [&Distances](float InDistance)
+    {
+        int32 Level = 0;
+        while (Level < Distances.Num() && InDistance >= Distances[Level])
+            Level++;
+        return Level;
+    };
+
+    // 变粗立即生效；变细要求按 距离 + 滞后 计算也更精细
+    int32 Level = GetLevelAt(Distance);
+    if (Level < CurrentLOD)
+    {
+        const int32 Hysteresis = FMath::Max(0, CurrentConfig->Params.LODHysteresis);
+        Level = FMath::Min(CurrentLOD, GetLevelAt(Distance + Hysteresis));
+    }
+    return Level;
+}
+
+void UChunkGenerationManager::UpdateChunkLODs(const FIntPoint& CenterChunk)
+{
+    if (!CurrentConfig || (bHasLODCenter && CenterChunk == LODCenter))
+        return;
+
+    const bool bHadLODCenter = bHasLODCenter;
+    const FIntPoint PrevCenter = LODCenter;
+    bHasLODCenter = true;
+    LODCenter = CenterChunk;
+
+    // 先切换全部级别（只改状态），相邻区块的边界随各自的刷新合并，不会按旧级别多建一次；
+    // 刷新排入 LODRefreshQueue，由 ProcessCompletedChunks 占用每帧提交预算执行
+    int32 NumChanged = 0;
+    auto UpdateChunk = [this, &CenterChunk, &NumChanged](const FIntPoint& ChunkKey, AActor* Chunk)
+    {
+        IChunkInterface* CI = Cast<IChunkInterface>(Chunk);
+        if (!CI)
+            return;
+
+        const int32 CurrentLOD = CI->GetLODLevel();
+        const int32 Level = ComputeChunkLOD(ChunkKey, CenterChunk, CurrentLOD);
+        if (Level == CurrentLOD)
+            return;
+
+        // 超出区块支持的最大级别时被钳制，级别可能并未改变
+        CI->SetLODLevel(Level);
+        if (CI->GetLODLevel() == CurrentLOD)
+            return;
+
+        NumChanged++;
+        if (!QueuedLODRefreshes.Contains(ChunkKey))
+        {
+            QueuedLODRefreshes.Add(ChunkKey);
+            LODRefreshQueue.Add(ChunkKey);
+        }
+    };
+
+    // 中心移动 Move 个区块时，每个区块的距离变化不超过 Move：只有新距离落在某个阈值 ± Move 内的区块可能换级别
+    // 阈值：变粗为 LODDistances[k]，变细为 LODDistances[k] - LODHysteresis，合并为环 [D - 滞后 - Move, D + Move]
+    TArray<FIntPoint, TInlineAllocator<8>> Rings; // (内半径, 外半径)
+    int64 RingArea = 0;
+    if (bHadLODCenter)
+    {
+        const int32 Move = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(GetChunkDistanceSq(CenterChunk, PrevCenter))));
+        const int32 Hysteresis = FMath::Max(0, CurrentConfig->Params.LODHysteresis);
+        TArray<FIntPoint, TInlineAllocator<8>> ThresholdRings;
+        for (const int32 Distance : CurrentConfig->Params.LODDistances)
+            ThresholdRings.Emplace(FMath::Max(0, Distance - Hysteresis - Move), Distance + Move);
+
+        // 相邻阈值的环可能重叠，合并后每个区块只检查一次
+        ThresholdRings.Sort([](const FIntPoint& A, const FIntPoint& B) { return A.X < B.X; });
+        for (const FIntPoint& Ring : ThresholdRings)
+        {
+            if (Rings.Num() > 0 && Ring.X <= Rings.Last().Y + 1)
+                Rings.Last().Y = FMath::Max(Rings.Last().Y, Ring.Y);
+            else
+                Rings.Add(Ring);
+        }
+        for (const FIntPoint& Ring : Rings)
+            RingArea += static_cast<int64>(PI * (static_cast<double>(Ring.Y) * Ring.Y - static_cast<double>(Ring.X) * Ring.X)) + 1;
+    }
+
+    if (!bHadLODCenter || RingArea >= LoadedChunks.Num())
     {
-        CI->SetChunkData(Blocks);
-        CI->RefreshRendering();
+        // 首次更新或大范围跳跃（传送）：环的面积已超过已加载区块数，直接遍历
+        for (const TPair<FIntPoint, TWeakObjectPtr<AActor>>& Pair : LoadedChunks)
+        {
+            if (AActor* Chunk = Pair.Value.Get())
+                UpdateChunk(Pair.Key, Chunk);
+        }
+    }
+    else
+    {
+        // 环 = 外半径圆减去（内半径 - 1）圆，与距离平方的整数判定一致，只会多查、不会漏查
+        for (const FIntPoint& Ring : Rings)
+        {
+            ForEachChunkInWindowDifference(CenterChunk, Ring.Y, CenterChunk, Ring.X - 1, Ring.X > 0,
+                [this, &UpdateChunk](const FIntPoint& ChunkKey)
+                {
+                    const TWeakObjectPtr<AActor>* ChunkPtr = LoadedChunks.Find(ChunkKey);
+                    if (AActor* Chunk = ChunkPtr ? ChunkPtr->Get() : nullptr)
+                        UpdateChunk(ChunkKey, Chunk);
+                });
+        }
+    }
+
+    // 清理已卸载的项，按距离排序：最近的在末尾，出队为 O(1)
+    if (NumChanged > 0)
+    {
+        LODRefreshQueue.RemoveAll([this](const FIntPoint& ChunkKey)
+            {
+                return !QueuedLODRefreshes.Contains(ChunkKey);
+            });
+        LODRefreshQueue.Sort([this, &CenterChunk](const FIntPoint& A, const FIntPoint& B)
+            {
+                return GetChunkDistanceSq(A, CenterChunk) > GetChunkDistanceSq(B, CenterChunk);
+            });
+    }
+
+    StreamingStats.LODTransitions += NumChanged;
+}
+
+void UChunkGenerationManager::UnloadChunk(const FIntPoint& ChunkKey)
+{
+    // 取消排队与生成中的请求（排队项在出队时跳过，生成结果到达后丢弃）
+    const int32 NumCancelled = QueuedChunks.Remove(ChunkKey) + PendingChunks.Remove(ChunkKey);
+    StreamingStats.RequestsCancelled += NumCancelled;
+
+    // 排队的 LOD 刷新在出队时跳过
+    QueuedLODRefreshes.Remove(ChunkKey);
+
+    bool bUnloaded = false;
+    TWeakObjectPtr<AActor> ChunkPtr;
+    if (LoadedChunks.RemoveAndCopyValue(ChunkKey, ChunkPtr))
+    {
+        OnChunkResidencyChanged.Broadcast(ChunkKey, false);
+        if (AActor* ChunkActor = ChunkPtr.Get())
+        {
+            UnlinkChunkNeighbors(ChunkKey, ChunkActor);
+            ReleaseChunkActor(ChunkActor);
+            StreamingStats.ChunksUnloaded++;
+            bUnloaded = true;
+            UE_LOG(H_LogWorldGeneration, Verbose, TEXT("Unloaded chunk at (%d, %d)"), ChunkKey.X, ChunkKey.Y);
+        }
+    }
+
+    if (bStationaryUpdate && (bUnloaded || NumCancelled > 0))
+    {
+        StreamingStats.StationaryChurnCount++;
+    }
+}
+
+/** 四个水平相邻方向 */
+static const FIntPoint GChunkNeighborOffsets[4] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+
+void UChunkGenerationManager::LinkChunkNeighbors(const FIntPoint& ChunkKey, AActor* Chunk)
+{
+    IChunkInterface* CI = Cast<IChunkInterface>(Chunk);
+    if (!CI)
+        return;
+
+    for (const FIntPoint& Offset : GChunkNeighborOffsets)
+    {
+        const TWeakObjectPtr<AActor>* NeighborPtr = LoadedChunks.Find(ChunkKey + Offset);
+        AActor* Neighbor = NeighborPtr ? NeighborPtr->Get() : nullptr;
+        IChunkInterface* NeighborCI = Cast<IChunkInterface>(Neighbor);
+        if (!NeighborCI)
+            continue;
+
+        CI->SetNeighborChunk(Offset, Neighbor);
+        NeighborCI->SetNeighborChunk(FIntPoint(-Offset.X, -Offset.Y), Chunk);
+
+        // 相邻区块贴边的方块可能因此被完全遮挡：只重新判断朝向本区块的一侧边界格（未受影响时为空操作）
+        NeighborCI->RefreshRendering();
+    }
+}
+
+void UChunkGenerationManager::UnlinkChunkNeighbors(const FIntPoint& ChunkKey, AActor* Chunk)
+{
+    IChunkInterface* CI = Cast<IChunkInterface>(Chunk);
+    for (const FIntPoint& Offset : GChunkNeighborOffsets)
+    {
+        const TWeakObjectPtr<AActor>* NeighborPtr = LoadedChunks.Find(ChunkKey + Offset);
+        if (IChunkInterface* NeighborCI = Cast<IChunkInterface>(NeighborPtr ? NeighborPtr->Get() : nullptr))
+        {
+            // 只登记，不立即重建：朝向已卸载区域的边界面背对玩家，等下次刷新时再补上
+            NeighborCI->SetNeighborChunk(FIntPoint(-Offset.X, -Offset.Y), nullptr);
+        }
+        if (CI)
+        {
+            CI->SetNeighborChunk(Offset, nullptr);
+        }
     }
 }
 
@@ -137,38 +746,54 @@ void UChunkGenerationManager::UnloadDistantChunks(const FIntPoint& PlayerChunkPo
     if (!CurrentConfig || RenderDistance <= 0)
         return;
 
-    // 计算最大允许距离平方（+1 防止边缘闪烁）
-    const int32 MaxDistSq = (RenderDistance + 1) * (RenderDistance + 1);
+    // 卸载半径 = 加载半径 + UnloadHysteresis，与加载使用同一圆形度量
+    const int32 UnloadRadius = GetUnloadRadius(RenderDistance);
+    const int32 MaxDistSq = UnloadRadius * UnloadRadius;
     TArray<FIntPoint> ChunksToRemove;
+    TArray<FIntPoint> StaleChunks;
 
     // 遍历所有已加载区块
     for (const auto& Pair : LoadedChunks)
     {
-        const FIntPoint& ChunkKey = Pair.Key;
-        TWeakObjectPtr<AActor>& ChunkPtr = const_cast<TWeakObjectPtr<AActor>&>(Pair.Value);
-
         // 清理已销毁的弱引用
-        if (!ChunkPtr.IsValid())
+        if (!Pair.Value.IsValid())
         {
-            ChunksToRemove.Add(ChunkKey);
+            StaleChunks.Add(Pair.Key);
             continue;
         }
 
         // 检查是否超出可视范围
+        if (GetChunkDistanceSq(Pair.Key, PlayerChunkPos) > MaxDistSq)
+        {
+            ChunksToRemove.Add(Pair.Key);
+        }
+    }
+
+    // 超出范围、尚未完成的生成与排队请求
+    for (const FIntPoint& ChunkKey : PendingChunks)
+    {
+        if (GetChunkDistanceSq(ChunkKey, PlayerChunkPos) > MaxDistSq)
+        {
+            ChunksToRemove.Add(ChunkKey);
+        }
+    }
+    for (const FIntPoint& ChunkKey : QueuedChunks)
+    {
         if (GetChunkDistanceSq(ChunkKey, PlayerChunkPos) > MaxDistSq)
         {
-            if (AActor* ChunkActor = ChunkPtr.Get())
-            {
-                ChunkActor->Destroy();
-                UE_LOG(H_LogWorldGeneration, Verbose, TEXT("Unloaded chunk at (%d, %d)"), ChunkKey.X, ChunkKey.Y);
-            }
             ChunksToRemove.Add(ChunkKey);
         }
     }
 
-    // 从缓存中移除已卸载的区块
-    for (const FIntPoint& Key : ChunksToRemove)
+    for (const FIntPoint& Key : StaleChunks)
     {
         LoadedChunks.Remove(Key);
+        OnChunkResidencyChanged.Broadcast(Key, false);
+    }
+
+    // 卸载区块并取消请求（排队项在出队时跳过，生成结果到达后丢弃）
+    for (const FIntPoint& Key : ChunksToRemove)
+    {
+        UnloadChunk(Key);
     }
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+﻿#include "FarTerrainActor.h"
+#include "ProceduralMeshComponent.h"
+#include "Materials/MaterialInterface.h"
+
+AFarTerrainActor::AFarTerrainActor()
+{
+    PrimaryActorTick.bCanEverTick = false;
+    RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+UProceduralMeshComponent* AFarTerrainActor::AcquireMeshComponent()
+{
+    while (FreeMeshes.Num() > 0)
+    {
+        UProceduralMeshComponent* Mesh = FreeMeshes.Pop(false);
+        if (IsValid(Mesh))
+            return Mesh;
+    }
+
+    // 远景只用于显示：无碰撞、不投射阴影（阴影距离外也看不到）
+    UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(this);
+    Mesh->SetupAttachment(RootComponent);
+    Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Mesh->bUseComplexAsSimpleCollision = false;
+    Mesh->SetCastShadow(false);
+    Mesh->RegisterComponent();
+    return Mesh;
+}
+
+void AFarTerrainActor::ApplyRegionMesh(const FIntPoint& RegionKey, const FVector& Location, FFarTerrainMeshData&& MeshData, const TBitArray<>& HiddenChunks)
+{
+    if (MeshData.IsEmpty())
+    {
+        RemoveRegion(RegionKey);
+        return;
+    }
+
+    TObjectPtr<UProceduralMeshComponent>& Mesh = RegionMeshes.FindOrAdd(RegionKey);
+    if (!Mesh)
+        Mesh = AcquireMeshComponent();
+
+    Mesh->SetWorldLocation(Location);
+    const FFarTerrainMeshData& StoredData = RegionMeshData.Add(RegionKey, MoveTemp(MeshData));
+    UpdateMeshSection(Mesh, StoredData, HiddenChunks);
+}
+
+void AFarTerrainActor::SetHiddenChunks(const FIntPoint& RegionKey, const TBitArray<>& HiddenChunks)
+{
+    const TObjectPtr<UProceduralMeshComponent>* Mesh = RegionMeshes.Find(RegionKey);
+    const FFarTerrainMeshData* MeshData = RegionMeshData.Find(RegionKey);
+    if (Mesh && IsValid(*Mesh) && MeshData)
+        UpdateMeshSection(*Mesh, *MeshData, HiddenChunks);
+}
+
+void AFarTerrainActor::UpdateMeshSection(UProceduralMeshComponent* Mesh, const FFarTerrainMeshData& MeshData, const TBitArray<>& HiddenChunks)
+{
+    // 没有隐藏的区块：直接使用完整索引
+    TArray<int32> VisibleTriangles;
+    const bool bAnyHidden = HiddenChunks.Find(true) != INDEX_NONE;
+    if (bAnyHidden)
+    {
+        VisibleTriangles.Reserve(MeshData.Triangles.Num());
+        for (int32 Slot = 0; Slot + 1 < MeshData.ChunkTriangleStarts.Num(); Slot++)
+        {
+            if (Slot < HiddenChunks.Num() && HiddenChunks[Slot])
+                continue;
+
+            const int32 Start = MeshData.ChunkTriangleStarts[Slot];
+            VisibleTriangles.Append(MeshData.Triangles.GetData() + Start, MeshData.ChunkTriangleStarts[Slot + 1] - Start);
+        }
+    }
+
+    const TArray<int32>& Triangles = bAnyHidden ? VisibleTriangles : MeshData.Triangles;
+    if (Triangles.Num() == 0)
+    {
+        Mesh->ClearAllMeshSections();
+        Mesh->SetVisibility(false);
+        return;
+    }
+
+    Mesh->CreateMeshSection(0, MeshData.Vertices, Triangles, MeshData.Normals,
+        TArray<FVector2D>(), MeshData.Colors, TArray<FProcMeshTangent>(), false);
+    if (Material)
+        Mesh->SetMaterial(0, Material);
+    Mesh->SetVisibility(true);
+}
+
+void AFarTerrainActor::RemoveRegion(const FIntPoint& RegionKey)
+{
+    RegionMeshData.Remove(RegionKey);
+
+    TObjectPtr<UProceduralMeshComponent> Mesh;
+    if (!RegionMeshes.RemoveAndCopyValue(RegionKey, Mesh) || !IsValid(Mesh))
+        return;
+
+    // 保留组件与渲染资源分配，下次直接覆盖网格段
+    Mesh->ClearAllMeshSections();
+    Mesh->SetVisibility(false);
+    FreeMeshes.Add(Mesh);
+}
+
+void AFarTerrainActor::ClearRegions()
+{
+    TArray<FIntPoint> Keys;
+    RegionMeshes.GetKeys(Keys);
+    for (const FIntPoint& Key : Keys)
+        RemoveRegion(Key);
+}
@@ -0,0 +1,469 @@
+﻿#include "FarTerrainManager.h"
+#include "FarTerrainActor.h"
+#include "ChunkGenerationManager.h"
+#include "WorldGenerationConfig.h"
+#include "HeightGenerator.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+#include "LogWorldGeneration.h"
+
+/** 方块尺寸（cm），与 AChunkActor::BlockSize、区块摆放位置一致 */
+static constexpr float GFarTerrainBlockSize = 128.0f;
+
+/**
+ * 远景网格整体下移一个最低精度 LOD 单元（方块数，1 << AChunkActor::MaxLODLevel）
+ * 最外圈体素区块按多数规则降采样，地表最多比全精度低一个单元；下移后与其相接的远景边缘不会高出或与之 Z 冲突
+ */
+static constexpr int32 GFarTerrainDepthOffset = 1 << 3;
+
+/** 远景顶点色：未配置的方块 */
+static const FColor GFarTerrainDefaultColor(128, 128, 128);
+
+void UFarTerrainManager::Initialize(UWorldGenerationConfig* Config)
+{
+    CurrentConfig = Config;
+
+    // 配置切换：仍在运行的旧任务结果作废，已显示的区域按新配置重建
+    ConfigGeneration++;
+    RequestQueue.Reset();
+    QueuedRegions.Reset();
+    PendingRegions.Reset();
+    LoadedRegions.Reset();
+    DirtyRegions.Reset();
+    bHasStreamingArea = false;
+
+    if (AFarTerrainActor* Actor = FarTerrainActor.Get())
+    {
+        Actor->ClearRegions();
+        Actor->Material = Config ? Config->FarTerrainMaterial : nullptr;
+    }
+}
+
+AFarTerrainActor* UFarTerrainManager::GetOrSpawnFarTerrainActor(UWorld* World)
+{
+    if (AFarTerrainActor* Actor = FarTerrainActor.Get())
+        return Actor;
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    AFarTerrainActor* Actor = World->SpawnActor<AFarTerrainActor>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+    if (!Actor)
+    {
+        UE_LOG(H_LogWorldGeneration, Error, TEXT("Failed to spawn far terrain actor!"));
+        return nullptr;
+    }
+
+    Actor->Material = CurrentConfig ? CurrentConfig->FarTerrainMaterial : nullptr;
+    FarTerrainActor = Actor;
+    return Actor;
+}
+
+void UFarTerrainManager::GetRegionDistanceSq(const FIntPoint& RegionKey, const FIntPoint& CenterChunk, int32& OutMinSq, int32& OutMaxSq) const
+{
+    const int32 RegionSize = FMath::Max(1, CurrentConfig->Params.FarTerrainRegionSize);
+    const FIntPoint MinChunk = RegionKey * RegionSize;
+    const FIntPoint MaxChunk = MinChunk + FIntPoint(RegionSize - 1, RegionSize - 1);
+
+    // 最近：中心夹到区域范围内；最远：每个轴取离中心更远的一端
+    const int32 NearX = FMath::Clamp(CenterChunk.X, MinChunk.X, MaxChunk.X) - CenterChunk.X;
+    const int32 NearY = FMath::Clamp(CenterChunk.Y, MinChunk.Y, MaxChunk.Y) - CenterChunk.Y;
+    const int32 FarX = FMath::Max(FMath::Abs(MinChunk.X - CenterChunk.X), FMath::Abs(MaxChunk.X - CenterChunk.X));
+    const int32 FarY = FMath::Max(FMath::Abs(MinChunk.Y - CenterChunk.Y), FMath::Abs(MaxChunk.Y - CenterChunk.Y));
+    OutMinSq = NearX * NearX + NearY * NearY;
+    OutMaxSq = FarX * FarX + FarY * FarY;
+}
+
+void UFarTerrainManager::UpdateStreamingArea(const FIntPoint& CenterChunk, int32 VoxelRadius, UWorld* World)
+{
+    if (!CurrentConfig || !World)
+        return;
+
+    const FWorldGenParams& Params = CurrentConfig->Params;
+    if (Params.FarTerrainRadius <= 0)
+        return;
+
+    // 中心区块与体素半径都未变化：无需任何工作
+    if (bHasStreamingArea && CenterChunk == StreamingCenter && VoxelRadius == StreamingVoxelRadius)
+        return;
+
+    bHasStreamingArea = true;
+    StreamingCenter = CenterChunk;
+    StreamingVoxelRadius = VoxelRadius;
+
+    if (!GetOrSpawnFarTerrainActor(World))
+        return;
+
+    // 卸载半径比加载半径大一个区域，防止在边界来回加载
+    const int32 RegionSize = FMath::Max(1, Params.FarTerrainRegionSize);
+    const int32 LoadRadius = Params.FarTerrainRadius;
+    const int32 UnloadRadius = LoadRadius + RegionSize;
+    const int32 VoxelRadiusSq = VoxelRadius * VoxelRadius;
+
+    //------ 卸载离开远景半径的区域，取消其排队/构建中的请求 ------
+    TArray<FIntPoint> RegionsToUnload;
+    auto CollectDistant = [&](const TSet<FIntPoint>& Regions)
+    {
+        for (const FIntPoint& RegionKey : Regions)
+        {
+            int32 MinSq, MaxSq;
+            GetRegionDistanceSq(RegionKey, CenterChunk, MinSq, MaxSq);
+            if (MinSq > UnloadRadius * UnloadRadius)
+                RegionsToUnload.Add(RegionKey);
+        }
+    };
+    CollectDistant(LoadedRegions);
+    CollectDistant(QueuedRegions);
+    CollectDistant(PendingRegions);
+
+    // 已完全进入体素半径：取消尚未显示的请求；已显示的区域等其区块全部加载后再卸载，避免露出空洞
+    auto CollectCovered = [&](const TSet<FIntPoint>& Regions)
+    {
+        for (const FIntPoint& RegionKey : Regions)
+        {
+            int32 MinSq, MaxSq;
+            GetRegionDistanceSq(RegionKey, CenterChunk, MinSq, MaxSq);
+            if (MaxSq <= VoxelRadiusSq)
+                RegionsToUnload.Add(RegionKey);
+        }
+    };
+    CollectCovered(QueuedRegions);
+    CollectCovered(PendingRegions);
+    for (const FIntPoint& RegionKey : LoadedRegions)
+    {
+        int32 MinSq, MaxSq;
+        GetRegionDistanceSq(RegionKey, CenterChunk, MinSq, MaxSq);
+        if (MaxSq <= VoxelRadiusSq)
+            DirtyRegions.Add(RegionKey);
+    }
+
+    for (const FIntPoint& RegionKey : RegionsToUnload)
+        UnloadRegion(RegionKey);
+
+    //------ 请求进入远景半径的区域 ------
+    // 完全被体素区块覆盖的区域不构建；部分覆盖的区域在已加载区块下方的四边形隐藏
+    const FIntPoint MinRegion(FMath::FloorToInt(static_cast<float>(CenterChunk.X - LoadRadius) / RegionSize),
+        FMath::FloorToInt(static_cast<float>(CenterChunk.Y - LoadRadius) / RegionSize));
+    const FIntPoint MaxRegion(FMath::FloorToInt(static_cast<float>(CenterChunk.X + LoadRadius) / RegionSize),
+        FMath::FloorToInt(static_cast<float>(CenterChunk.Y + LoadRadius) / RegionSize));
+    for (int32 RY = MinRegion.Y; RY <= MaxRegion.Y; RY++)
+    {
+        for (int32 RX = MinRegion.X; RX <= MaxRegion.X; RX++)
+        {
+            const FIntPoint RegionKey(RX, RY);
+            if (LoadedRegions.Contains(RegionKey) || QueuedRegions.Contains(RegionKey) || PendingRegions.Contains(RegionKey))
+                continue;
+
+            int32 MinSq, MaxSq;
+            GetRegionDistanceSq(RegionKey, CenterChunk, MinSq, MaxSq);
+            if (MinSq > LoadRadius * LoadRadius || MaxSq <= VoxelRadiusSq)
+                continue;
+
+            QueuedRegions.Add(RegionKey);
+            RequestQueue.Add(RegionKey);
+        }
+    }
+
+    // 清理已取消的请求，按距离排序：最近的在末尾，出队为 O(1)
+    RequestQueue.RemoveAll([this](const FIntPoint& RegionKey)
+        {
+            return !QueuedRegions.Contains(RegionKey);
+        });
+    RequestQueue.Sort([this, &CenterChunk](const FIntPoint& A, const FIntPoint& B)
+        {
+            int32 MinA, MaxA, MinB, MaxB;
+            GetRegionDistanceSq(A, CenterChunk, MinA, MaxA);
+            GetRegionDistanceSq(B, CenterChunk, MinB, MaxB);
+            return MinA > MinB;
+        });
+}
+
+void UFarTerrainManager::UnloadRegion(const FIntPoint& RegionKey)
+{
+    // 排队项在出队时跳过，构建结果到达后丢弃
+    QueuedRegions.Remove(RegionKey);
+    PendingRegions.Remove(RegionKey);
+    DirtyRegions.Remove(RegionKey);
+
+    if (LoadedRegions.Remove(RegionKey) > 0)
+    {
+        if (AFarTerrainActor* Actor = FarTerrainActor.Get())
+            Actor->RemoveRegion(RegionKey);
+    }
+}
+
+FIntPoint UFarTerrainManager::GetRegionOfChunk(const FIntPoint& ChunkKey) const
+{
+    // 向下取整除法：负坐标的区块属于负坐标的区域
+    const int32 RegionSize = FMath::Max(1, CurrentConfig->Params.FarTerrainRegionSize);
+    auto FloorDiv = [RegionSize](int32 Value)
+    {
+        return Value >= 0 ? Value / RegionSize : (Value + 1) / RegionSize - 1;
+    };
+    return FIntPoint(FloorDiv(ChunkKey.X), FloorDiv(ChunkKey.Y));
+}
+
+bool UFarTerrainManager::GetHiddenChunks(const FIntPoint& RegionKey, TBitArray<>& OutHidden) const
+{
+    const int32 RegionSize = FMath::Max(1, CurrentConfig->Params.FarTerrainRegionSize);
+    const FIntPoint MinChunk = RegionKey * RegionSize;
+
+    bool bAllLoaded = true;
+    OutHidden.Init(false, RegionSize * RegionSize);
+    for (int32 CY = 0; CY < RegionSize; CY++)
+    {
+        for (int32 CX = 0; CX < RegionSize; CX++)
+        {
+            if (VoxelChunks.Contains(MinChunk + FIntPoint(CX, CY)))
+                OutHidden[CX + CY * RegionSize] = true;
+            else
+                bAllLoaded = false;
+        }
+    }
+    return bAllLoaded;
+}
+
+bool UFarTerrainManager::IsRegionCovered(const FIntPoint& RegionKey, bool bAllChunksLoaded) const
+{
+    if (!bAllChunksLoaded || !bHasStreamingArea)
+        return false;
+
+    int32 MinSq, MaxSq;
+    GetRegionDistanceSq(RegionKey, StreamingCenter, MinSq, MaxSq);
+    return MaxSq <= StreamingVoxelRadius * StreamingVoxelRadius;
+}
+
+void UFarTerrainManager::SetVoxelChunkLoaded(const FIntPoint& ChunkKey, bool bLoaded)
+{
+    if (bLoaded)
+        VoxelChunks.Add(ChunkKey);
+    else
+        VoxelChunks.Remove(ChunkKey);
+
+    if (!CurrentConfig)
+        return;
+
+    const FIntPoint RegionKey = GetRegionOfChunk(ChunkKey);
+    if (LoadedRegions.Contains(RegionKey))
+        DirtyRegions.Add(RegionKey);
+}
+
+void UFarTerrainManager::UpdateDirtyRegions()
+{
+    if (DirtyRegions.Num() == 0)
+        return;
+
+    AFarTerrainActor* Actor = FarTerrainActor.Get();
+    TArray<FIntPoint> RegionsToUnload;
+    for (const FIntPoint& RegionKey : DirtyRegions)
+    {
+        if (!Actor || !LoadedRegions.Contains(RegionKey))
+            continue;
+
+        // 只重建索引：已加载区块下方的四边形隐藏，卸载后的区块重新显示
+        TBitArray<> Hidden;
+        const bool bAllLoaded = GetHiddenChunks(RegionKey, Hidden);
+        if (IsRegionCovered(RegionKey, bAllLoaded))
+            RegionsToUnload.Add(RegionKey);
+        else
+            Actor->SetHiddenChunks(RegionKey, Hidden);
+    }
+    DirtyRegions.Reset();
+
+    for (const FIntPoint& RegionKey : RegionsToUnload)
+        UnloadRegion(RegionKey);
+}
+
+void UFarTerrainManager::DispatchQueuedRequests()
+{
+    if (!CurrentConfig)
+        return;
+
+    while (NumTasksInFlight < MaxRegionTasksInFlight && RequestQueue.Num() > 0)
+    {
+        const FIntPoint RegionKey = RequestQueue.Pop(false);
+
+        // 已被取消的请求直接跳过
+        if (QueuedRegions.Remove(RegionKey) == 0)
+            continue;
+
+        PendingRegions.Add(RegionKey);
+        NumTasksInFlight++;
+
+        // 后台构建网格：参数按值拷贝，任务不访问任何 UObject
+        const FWorldGenParams ParamsCopy = CurrentConfig->Params;
+        const uint32 Generation = ConfigGeneration;
+        TSharedPtr<FFarTerrainResults, ESPMode::ThreadSafe> Results = RegionResults;
+
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Results, RegionKey, Generation, ParamsCopy]()
+            {
+                FFarTerrainRegionData Data;
+                Data.RegionKey = RegionKey;
+                Data.ConfigGeneration = Generation;
+                BuildRegionMesh(RegionKey, ParamsCopy, Data.Mesh);
+
+                Results->Completed.Enqueue(MoveTemp(Data));
+            });
+    }
+}
+
+int32 UFarTerrainManager::ProcessCompletedRegions(int32 Budget)
+{
+    if (!CurrentConfig)
+        return 0;
+
+    // 本帧体素区块的加载/卸载：先更新已显示区域的可见四边形（只重建索引，不计入预算）
+    UpdateDirtyRegions();
+
+    // Budget 为体素区块提交后本帧剩余的预算，用完时结果留在队列中等下一帧
+    int32 Committed = 0;
+
+    FFarTerrainRegionData Data;
+    while (Committed < Budget && RegionResults->Completed.Dequeue(Data))
+    {
+        NumTasksInFlight--;
+
+        // 配置已切换，或请求已被取消（例如玩家已远离）
+        if (Data.ConfigGeneration != ConfigGeneration || PendingRegions.Remove(Data.RegionKey) == 0)
+            continue;
+
+        AFarTerrainActor* Actor = FarTerrainActor.Get();
+        if (!Actor)
+            continue;
+
+        // 构建期间区块已全部加载且区域已被完全覆盖：不再显示
+        TBitArray<> Hidden;
+        const bool bAllLoaded = GetHiddenChunks(Data.RegionKey, Hidden);
+        if (IsRegionCovered(Data.RegionKey, bAllLoaded))
+            continue;
+
+        const int32 RegionBlocks = FMath::Max(1, CurrentConfig->Params.FarTerrainRegionSize) * CurrentConfig->Params.ChunkSize;
+        const FVector Location(Data.RegionKey.X * RegionBlocks * GFarTerrainBlockSize, Data.RegionKey.Y * RegionBlocks * GFarTerrainBlockSize, 0.0f);
+        Actor->ApplyRegionMesh(Data.RegionKey, Location, MoveTemp(Data.Mesh), Hidden);
+        LoadedRegions.Add(Data.RegionKey);
+        Committed++;
+    }
+
+    return Committed;
+}
+
+void UFarTerrainManager::BuildRegionMesh(const FIntPoint& RegionKey, const FWorldGenParams& Params, FFarTerrainMeshData& OutMesh)
+{
+    const int32 ChunkSize = Params.ChunkSize;
+    const int32 RegionSize = FMath::Max(1, Params.FarTerrainRegionSize);
+    const int32 RegionBlocks = RegionSize * ChunkSize;
+    const int32 Step = FMath::Clamp(Params.FarTerrainSampleStep, 1, ChunkSize);
+
+    // 每个轴的采样坐标：区块内每 Step 个方块一个，并且总包含区块边界，四边形不跨越区块
+    // ChunkFirstQuad[C] 为区块 C 的第一个四边形下标，ChunkFirstQuad[RegionSize] 为四边形总数
+    TArray<int32> Samples;
+    TArray<int32> ChunkFirstQuad;
+    ChunkFirstQuad.SetNumUninitialized(RegionSize + 1);
+    for (int32 C = 0; C < RegionSize; C++)
+    {
+        ChunkFirstQuad[C] = Samples.Num();
+        for (int32 B = 0; B < ChunkSize; B += Step)
+            Samples.Add(C * ChunkSize + B);
+    }
+    ChunkFirstQuad[RegionSize] = Samples.Num();
+    Samples.Add(RegionBlocks);
+    const int32 NumVerts = Samples.Num();
+
+    // Step 1: 区域及外围一圈区块的地表高度图（与体素区块完全相同的噪声采样）
+    // 采样点的覆盖范围最多伸出区域 Step <= ChunkSize 个方块，外围一圈区块足以覆盖
+    const int32 PaddedSize = RegionSize + 2;
+    TArray<TArray<int32>> ChunkHeights;
+    ChunkHeights.SetNum(PaddedSize * PaddedSize);
+    for (int32 CY = 0; CY < PaddedSize; CY++)
+    {
+        for (int32 CX = 0; CX < PaddedSize; CX++)
+        {
+            UHeightGenerator::GenerateChunkHeights(RegionKey.X * RegionSize + CX - 1, RegionKey.Y * RegionSize + CY - 1,
+                Params, ChunkHeights[CX + CY * PaddedSize]);
+        }
+    }
+
+    // 区域局部方块坐标 -> 地表高度，坐标可落在外围一圈区块内 [-ChunkSize, RegionBlocks + ChunkSize)
+    auto GetSurfaceHeight = [&ChunkHeights, ChunkSize, PaddedSize](int32 BX, int32 BY)
+    {
+        const int32 PX = BX + ChunkSize;
+        const int32 PY = BY + ChunkSize;
+        return ChunkHeights[PX / ChunkSize + (PY / ChunkSize) * PaddedSize][PX % ChunkSize + (PY % ChunkSize) * ChunkSize];
+    };
+
+    // Step 2: 采样点高度取方块列 [B - Step, B + Step) 中的最低地表（采样间距不超过 Step，覆盖相邻四个四边形）
+    // 四边形内任一点的高度都是其角点的插值，不会高出所覆盖的任何一列全精度地表
+    // 相邻区域的首行/列与本区域的最后一行/列覆盖同一批方块列，高度一致，接缝无裂缝
+    TArray<int32> Heights;
+    TArray<int32> SurfaceIDs;
+    Heights.SetNumUninitialized(NumVerts * NumVerts);
+    SurfaceIDs.SetNumUninitialized(NumVerts * NumVerts);
+    for (int32 J = 0; J < NumVerts; J++)
+    {
+        const int32 BY = Samples[J];
+        for (int32 I = 0; I < NumVerts; I++)
+        {
+            const int32 BX = Samples[I];
+            int32 MinHeight = MAX_int32;
+            for (int32 Y = BY - Step; Y < BY + Step; Y++)
+                for (int32 X = BX - Step; X < BX + Step; X++)
+                    MinHeight = FMath::Min(MinHeight, GetSurfaceHeight(X, Y));
+
+            // 着色仍按采样点本身的地表方块
+            const int32 SurfaceZ = GetSurfaceHeight(BX, BY);
+            Heights[I + J * NumVerts] = MinHeight;
+            SurfaceIDs[I + J * NumVerts] = UChunkGenerationManager::GetTerrainBlockID(SurfaceZ, SurfaceZ);
+        }
+    }
+
+    // Step 3: 规则网格，顶点位于覆盖范围内最低地表方块的底面再下移 GFarTerrainDepthOffset 个方块，按地表方块着色
+    OutMesh.Vertices.SetNumUninitialized(NumVerts * NumVerts);
+    OutMesh.Normals.SetNumUninitialized(NumVerts * NumVerts);
+    OutMesh.Colors.SetNumUninitialized(NumVerts * NumVerts);
+    for (int32 J = 0; J < NumVerts; J++)
+    {
+        const int32 BY = Samples[J];
+        for (int32 I = 0; I < NumVerts; I++)
+        {
+            const int32 BX = Samples[I];
+            const int32 Index = I + J * NumVerts;
+            OutMesh.Vertices[Index] = FVector(BX * GFarTerrainBlockSize, BY * GFarTerrainBlockSize, (Heights[Index] - GFarTerrainDepthOffset) * GFarTerrainBlockSize);
+
+            // 中心差分求法线（方块单位），边缘退化为单侧差分
+            const int32 I0 = FMath::Max(I - 1, 0), I1 = FMath::Min(I + 1, NumVerts - 1);
+            const int32 J0 = FMath::Max(J - 1, 0), J1 = FMath::Min(J + 1, NumVerts - 1);
+            const float DX = Samples[I1] - Samples[I0];
+            const float DY = Samples[J1] - Samples[J0];
+            const float SlopeX = (Heights[I1 + J * NumVerts] - Heights[I0 + J * NumVerts]) / DX;
+            const float SlopeY = (Heights[I + J1 * NumVerts] - Heights[I + J0 * NumVerts]) / DY;
+            OutMesh.Normals[Index] = FVector(-SlopeX, -SlopeY, 1.0f).GetSafeNormal();
+
+            const FColor* Color = Params.FarTerrainBlockColors.Find(SurfaceIDs[Index]);
+            OutMesh.Colors[Index] = Color ? *Color : GFarTerrainDefaultColor;
+        }
+    }
+
+    // 朝上的四边形：UE 按 (P1-P2) x (P0-P2) 计算正面法线
+    // 按区块分组输出，区块加载后只需跳过对应的下标范围
+    const int32 NumQuads = NumVerts - 1;
+    OutMesh.Triangles.Reset(NumQuads * NumQuads * 6);
+    OutMesh.ChunkTriangleStarts.Reset(RegionSize * RegionSize + 1);
+    for (int32 CY = 0; CY < RegionSize; CY++)
+    {
+        for (int32 CX = 0; CX < RegionSize; CX++)
+        {
+            OutMesh.ChunkTriangleStarts.Add(OutMesh.Triangles.Num());
+            for (int32 J = ChunkFirstQuad[CY]; J < ChunkFirstQuad[CY + 1]; J++)
+            {
+                for (int32 I = ChunkFirstQuad[CX]; I < ChunkFirstQuad[CX + 1]; I++)
+                {
+                    const int32 V00 = I + J * NumVerts;
+                    const int32 V10 = V00 + 1;
+                    const int32 V01 = V00 + NumVerts;
+                    const int32 V11 = V01 + 1;
+                    OutMesh.Triangles.Append({ V00, V11, V10, V00, V01, V11 });
+                }
+            }
+        }
+    }
+    OutMesh.ChunkTriangleStarts.Add(OutMesh.Triangles.Num());
+}
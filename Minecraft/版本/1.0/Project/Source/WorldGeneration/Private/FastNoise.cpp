@@ -33,6 +33,32 @@
 
 #include <algorithm>
 #include <random>
+#include <vector>
+
+// SIMD grid kernels are only built for x64 float noise, everything else uses the scalar path
+#if !defined(FN_USE_DOUBLES) && (defined(_M_X64) || defined(__x86_64__))
+#define FN_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define FN_SIMD_X86 0
+#endif
+
+// GCC/Clang need AVX2 enabled per function, MSVC allows the intrinsics anywhere
+#if FN_SIMD_X86 && (defined(__clang__) || defined(__GNUC__))
+#define FN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FN_TARGET_AVX2
+#endif
+
+// Keep a*b+c as a separate multiply and add so the SIMD kernels stay bit-identical to the scalar path
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
 
 const FN_DECIMAL GRAD_X[] =
 {
@@ -2248,3 +2274,706 @@ void FastNoise::SingleGradientPerturb(unsigned char offset, FN_DECIMAL warpAmp,
 	x += Lerp(lx0x, lx1x, ys) * warpAmp;
 	y += Lerp(ly0x, ly1x, ys) * warpAmp;
 }
+
+// SIMD
+static FastNoise::SIMDLevel DetectSIMDLevel()
+{
+#if FN_SIMD_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (maxLeaf < 7 || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return FastNoise::SIMD_SSE2;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) ? FastNoise::SIMD_AVX2 : FastNoise::SIMD_SSE2;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? FastNoise::SIMD_AVX2 : FastNoise::SIMD_SSE2;
+#endif
+#else
+	return FastNoise::SIMD_None;
+#endif
+}
+
+FastNoise::SIMDLevel FastNoise::GetSupportedSIMDLevel()
+{
+	static const SIMDLevel supported = DetectSIMDLevel();
+	return supported;
+}
+
+FastNoise::SIMDLevel FastNoise::GetActiveSIMDLevel() const
+{
+	return std::min(m_maxSIMDLevel, GetSupportedSIMDLevel());
+}
+
+#if FN_SIMD_X86
+// Perlin row: grad holds per-column gradient components gx00, gy00, gx10, gy10, gx01, gy01, gx11, gy11
+// Returns the number of columns written, the caller finishes the tail with scalar code
+static int PerlinRowSSE2(int width, const FN_DECIMAL* colXd0, const FN_DECIMAL* colXs, const FN_DECIMAL* const* grad,
+	FN_DECIMAL yd0, FN_DECIMAL yd1, FN_DECIMAL ysI, FN_DECIMAL* outRow)
+{
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 vyd0 = _mm_set1_ps(yd0);
+	const __m128 vyd1 = _mm_set1_ps(yd1);
+	const __m128 vys = _mm_set1_ps(ysI);
+
+	int ix = 0;
+	for (; ix + 4 <= width; ix += 4)
+	{
+		__m128 xd0 = _mm_loadu_ps(colXd0 + ix);
+		__m128 xd1 = _mm_sub_ps(xd0, one);
+		__m128 xs = _mm_loadu_ps(colXs + ix);
+
+		__m128 a = _mm_add_ps(_mm_mul_ps(xd0, _mm_loadu_ps(grad[0] + ix)), _mm_mul_ps(vyd0, _mm_loadu_ps(grad[1] + ix)));
+		__m128 b = _mm_add_ps(_mm_mul_ps(xd1, _mm_loadu_ps(grad[2] + ix)), _mm_mul_ps(vyd0, _mm_loadu_ps(grad[3] + ix)));
+		__m128 c = _mm_add_ps(_mm_mul_ps(xd0, _mm_loadu_ps(grad[4] + ix)), _mm_mul_ps(vyd1, _mm_loadu_ps(grad[5] + ix)));
+		__m128 d = _mm_add_ps(_mm_mul_ps(xd1, _mm_loadu_ps(grad[6] + ix)), _mm_mul_ps(vyd1, _mm_loadu_ps(grad[7] + ix)));
+
+		__m128 xf0 = _mm_add_ps(a, _mm_mul_ps(xs, _mm_sub_ps(b, a)));
+		__m128 xf1 = _mm_add_ps(c, _mm_mul_ps(xs, _mm_sub_ps(d, c)));
+
+		_mm_storeu_ps(outRow + ix, _mm_add_ps(xf0, _mm_mul_ps(vys, _mm_sub_ps(xf1, xf0))));
+	}
+	return ix;
+}
+
+FN_TARGET_AVX2 static int PerlinRowAVX2(int width, const FN_DECIMAL* colXd0, const FN_DECIMAL* colXs, const FN_DECIMAL* const* grad,
+	FN_DECIMAL yd0, FN_DECIMAL yd1, FN_DECIMAL ysI, FN_DECIMAL* outRow)
+{
+	const __m256 one = _mm256_set1_ps(1);
+	const __m256 vyd0 = _mm256_set1_ps(yd0);
+	const __m256 vyd1 = _mm256_set1_ps(yd1);
+	const __m256 vys = _mm256_set1_ps(ysI);
+
+	int ix = 0;
+	for (; ix + 8 <= width; ix += 8)
+	{
+		__m256 xd0 = _mm256_loadu_ps(colXd0 + ix);
+		__m256 xd1 = _mm256_sub_ps(xd0, one);
+		__m256 xs = _mm256_loadu_ps(colXs + ix);
+
+		__m256 a = _mm256_add_ps(_mm256_mul_ps(xd0, _mm256_loadu_ps(grad[0] + ix)), _mm256_mul_ps(vyd0, _mm256_loadu_ps(grad[1] + ix)));
+		__m256 b = _mm256_add_ps(_mm256_mul_ps(xd1, _mm256_loadu_ps(grad[2] + ix)), _mm256_mul_ps(vyd0, _mm256_loadu_ps(grad[3] + ix)));
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(xd0, _mm256_loadu_ps(grad[4] + ix)), _mm256_mul_ps(vyd1, _mm256_loadu_ps(grad[5] + ix)));
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(xd1, _mm256_loadu_ps(grad[6] + ix)), _mm256_mul_ps(vyd1, _mm256_loadu_ps(grad[7] + ix)));
+
+		__m256 xf0 = _mm256_add_ps(a, _mm256_mul_ps(xs, _mm256_sub_ps(b, a)));
+		__m256 xf1 = _mm256_add_ps(c, _mm256_mul_ps(xs, _mm256_sub_ps(d, c)));
+
+		_mm256_storeu_ps(outRow + ix, _mm256_add_ps(xf0, _mm256_mul_ps(vys, _mm256_sub_ps(xf1, xf0))));
+	}
+	return ix;
+}
+
+// Gradient lookup for one simplex lane, same hashing as GradCoord2D()
+static inline void SimplexLaneGrad(const unsigned char* perm, const unsigned char* perm12, unsigned char offset,
+	int i, int j, bool upper, FN_DECIMAL* gx, FN_DECIMAL* gy)
+{
+	unsigned char g0 = perm12[(i & 0xff) + perm[(j & 0xff) + offset]];
+	unsigned char g1 = upper ? perm12[((i + 1) & 0xff) + perm[(j & 0xff) + offset]] : perm12[(i & 0xff) + perm[((j + 1) & 0xff) + offset]];
+	unsigned char g2 = perm12[((i + 1) & 0xff) + perm[((j + 1) & 0xff) + offset]];
+
+	gx[0] = GRAD_X[g0]; gy[0] = GRAD_Y[g0];
+	gx[1] = GRAD_X[g1]; gy[1] = GRAD_Y[g1];
+	gx[2] = GRAD_X[g2]; gy[2] = GRAD_Y[g2];
+}
+
+// Simplex row, same operation order as SingleSimplex(), FastFloor() is emulated as truncate minus one for negatives
+static int SimplexRowSSE2(const unsigned char* perm, const unsigned char* perm12, unsigned char offset,
+	int width, const FN_DECIMAL* xs, FN_DECIMAL y, FN_DECIMAL* outRow)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 half = _mm_set1_ps(FN_DECIMAL(0.5));
+	const __m128 vF2 = _mm_set1_ps(F2);
+	const __m128 vG2 = _mm_set1_ps(G2);
+	const __m128 vG2x2 = _mm_set1_ps(2*G2);
+	const __m128 v70 = _mm_set1_ps(70);
+	const __m128 vy = _mm_set1_ps(y);
+
+	alignas(16) int laneI[4];
+	alignas(16) int laneJ[4];
+	alignas(16) FN_DECIMAL gx[3][4];
+	alignas(16) FN_DECIMAL gy[3][4];
+
+	int ix = 0;
+	for (; ix + 4 <= width; ix += 4)
+	{
+		__m128 x = _mm_loadu_ps(xs + ix);
+
+		__m128 t = _mm_mul_ps(_mm_add_ps(x, vy), vF2);
+		__m128 fi = _mm_add_ps(x, t);
+		__m128 fj = _mm_add_ps(vy, t);
+		__m128i i = _mm_add_epi32(_mm_cvttps_epi32(fi), _mm_castps_si128(_mm_cmplt_ps(fi, zero)));
+		__m128i j = _mm_add_epi32(_mm_cvttps_epi32(fj), _mm_castps_si128(_mm_cmplt_ps(fj, zero)));
+
+		t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(i, j)), vG2);
+		__m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+		__m128 y0 = _mm_sub_ps(vy, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+
+		__m128 upper = _mm_cmpgt_ps(x0, y0);
+		__m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_and_ps(upper, one)), vG2);
+		__m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_andnot_ps(upper, one)), vG2);
+		__m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), vG2x2);
+		__m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), vG2x2);
+
+		_mm_store_si128((__m128i*)laneI, i);
+		_mm_store_si128((__m128i*)laneJ, j);
+		const int upperMask = _mm_movemask_ps(upper);
+		for (int l = 0; l < 4; l++)
+		{
+			FN_DECIMAL lgx[3], lgy[3];
+			SimplexLaneGrad(perm, perm12, offset, laneI[l], laneJ[l], (upperMask >> l) & 1, lgx, lgy);
+			for (int c = 0; c < 3; c++)
+			{
+				gx[c][l] = lgx[c];
+				gy[c][l] = lgy[c];
+			}
+		}
+
+		__m128 t0 = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x0, x0)), _mm_mul_ps(y0, y0));
+		__m128 t1 = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x1, x1)), _mm_mul_ps(y1, y1));
+		__m128 t2 = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x2, x2)), _mm_mul_ps(y2, y2));
+
+		__m128 d0 = _mm_add_ps(_mm_mul_ps(x0, _mm_load_ps(gx[0])), _mm_mul_ps(y0, _mm_load_ps(gy[0])));
+		__m128 d1 = _mm_add_ps(_mm_mul_ps(x1, _mm_load_ps(gx[1])), _mm_mul_ps(y1, _mm_load_ps(gy[1])));
+		__m128 d2 = _mm_add_ps(_mm_mul_ps(x2, _mm_load_ps(gx[2])), _mm_mul_ps(y2, _mm_load_ps(gy[2])));
+
+		__m128 s0 = _mm_mul_ps(t0, t0);
+		__m128 s1 = _mm_mul_ps(t1, t1);
+		__m128 s2 = _mm_mul_ps(t2, t2);
+		__m128 n0 = _mm_andnot_ps(_mm_cmplt_ps(t0, zero), _mm_mul_ps(_mm_mul_ps(s0, s0), d0));
+		__m128 n1 = _mm_andnot_ps(_mm_cmplt_ps(t1, zero), _mm_mul_ps(_mm_mul_ps(s1, s1), d1));
+		__m128 n2 = _mm_andnot_ps(_mm_cmplt_ps(t2, zero), _mm_mul_ps(_mm_mul_ps(s2, s2), d2));
+
+		_mm_storeu_ps(outRow + ix, _mm_mul_ps(v70, _mm_add_ps(_mm_add_ps(n0, n1), n2)));
+	}
+	return ix;
+}
+
+FN_TARGET_AVX2 static int SimplexRowAVX2(const unsigned char* perm, const unsigned char* perm12, unsigned char offset,
+	int width, const FN_DECIMAL* xs, FN_DECIMAL y, FN_DECIMAL* outRow)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1);
+	const __m256 half = _mm256_set1_ps(FN_DECIMAL(0.5));
+	const __m256 vF2 = _mm256_set1_ps(F2);
+	const __m256 vG2 = _mm256_set1_ps(G2);
+	const __m256 vG2x2 = _mm256_set1_ps(2*G2);
+	const __m256 v70 = _mm256_set1_ps(70);
+	const __m256 vy = _mm256_set1_ps(y);
+
+	alignas(32) int laneI[8];
+	alignas(32) int laneJ[8];
+	alignas(32) FN_DECIMAL gx[3][8];
+	alignas(32) FN_DECIMAL gy[3][8];
+
+	int ix = 0;
+	for (; ix + 8 <= width; ix += 8)
+	{
+		__m256 x = _mm256_loadu_ps(xs + ix);
+
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(x, vy), vF2);
+		__m256 fi = _mm256_add_ps(x, t);
+		__m256 fj = _mm256_add_ps(vy, t);
+		__m256i i = _mm256_add_epi32(_mm256_cvttps_epi32(fi), _mm256_castps_si256(_mm256_cmp_ps(fi, zero, _CMP_LT_OQ)));
+		__m256i j = _mm256_add_epi32(_mm256_cvttps_epi32(fj), _mm256_castps_si256(_mm256_cmp_ps(fj, zero, _CMP_LT_OQ)));
+
+		t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(i, j)), vG2);
+		__m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+		__m256 y0 = _mm256_sub_ps(vy, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+
+		__m256 upper = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+		__m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_and_ps(upper, one)), vG2);
+		__m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_andnot_ps(upper, one)), vG2);
+		__m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, one), vG2x2);
+		__m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, one), vG2x2);
+
+		_mm256_store_si256((__m256i*)laneI, i);
+		_mm256_store_si256((__m256i*)laneJ, j);
+		const int upperMask = _mm256_movemask_ps(upper);
+		for (int l = 0; l < 8; l++)
+		{
+			FN_DECIMAL lgx[3], lgy[3];
+			SimplexLaneGrad(perm, perm12, offset, laneI[l], laneJ[l], (upperMask >> l) & 1, lgx, lgy);
+			for (int c = 0; c < 3; c++)
+			{
+				gx[c][l] = lgx[c];
+				gy[c][l] = lgy[c];
+			}
+		}
+
+		__m256 t0 = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0));
+		__m256 t1 = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1));
+		__m256 t2 = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x2, x2)), _mm256_mul_ps(y2, y2));
+
+		__m256 d0 = _mm256_add_ps(_mm256_mul_ps(x0, _mm256_load_ps(gx[0])), _mm256_mul_ps(y0, _mm256_load_ps(gy[0])));
+		__m256 d1 = _mm256_add_ps(_mm256_mul_ps(x1, _mm256_load_ps(gx[1])), _mm256_mul_ps(y1, _mm256_load_ps(gy[1])));
+		__m256 d2 = _mm256_add_ps(_mm256_mul_ps(x2, _mm256_load_ps(gx[2])), _mm256_mul_ps(y2, _mm256_load_ps(gy[2])));
+
+		__m256 s0 = _mm256_mul_ps(t0, t0);
+		__m256 s1 = _mm256_mul_ps(t1, t1);
+		__m256 s2 = _mm256_mul_ps(t2, t2);
+		__m256 n0 = _mm256_andnot_ps(_mm256_cmp_ps(t0, zero, _CMP_LT_OQ), _mm256_mul_ps(_mm256_mul_ps(s0, s0), d0));
+		__m256 n1 = _mm256_andnot_ps(_mm256_cmp_ps(t1, zero, _CMP_LT_OQ), _mm256_mul_ps(_mm256_mul_ps(s1, s1), d1));
+		__m256 n2 = _mm256_andnot_ps(_mm256_cmp_ps(t2, zero, _CMP_LT_OQ), _mm256_mul_ps(_mm256_mul_ps(s2, s2), d2));
+
+		_mm256_storeu_ps(outRow + ix, _mm256_mul_ps(v70, _mm256_add_ps(_mm256_add_ps(n0, n1), n2)));
+	}
+	return ix;
+}
+#endif
+
+// Grid Fill
+static FN_DECIMAL InterpGridFunc(FastNoise::Interp interp, FN_DECIMAL t)
+{
+	switch (interp)
+	{
+	case FastNoise::Hermite:
+		return InterpHermiteFunc(t);
+	case FastNoise::Quintic:
+		return InterpQuinticFunc(t);
+	default:
+		return t;
+	}
+}
+
+void FastNoise::FillNoiseGrid(FN_DECIMAL* out, int width, int height, FN_DECIMAL xStart, FN_DECIMAL yStart, FN_DECIMAL xStep, FN_DECIMAL yStep) const
+{
+	if (!out || width <= 0 || height <= 0)
+		return;
+
+	GridKernel kernel = nullptr;
+	bool fractal = false;
+
+	switch (m_noiseType)
+	{
+	case Value:
+		kernel = &FastNoise::SingleValueGrid;
+		break;
+	case ValueFractal:
+		kernel = &FastNoise::SingleValueGrid;
+		fractal = true;
+		break;
+	case Perlin:
+		kernel = &FastNoise::SinglePerlinGrid;
+		break;
+	case PerlinFractal:
+		kernel = &FastNoise::SinglePerlinGrid;
+		fractal = true;
+		break;
+	case Simplex:
+		kernel = &FastNoise::SingleSimplexGrid;
+		break;
+	case SimplexFractal:
+		kernel = &FastNoise::SingleSimplexGrid;
+		fractal = true;
+		break;
+	case Cubic:
+		kernel = &FastNoise::SingleCubicGrid;
+		break;
+	case CubicFractal:
+		kernel = &FastNoise::SingleCubicGrid;
+		fractal = true;
+		break;
+	default:
+		break;
+	}
+
+	if (!kernel || (fractal && m_fractalType != FBM && m_fractalType != Billow && m_fractalType != RigidMulti))
+	{
+		for (int iy = 0; iy < height; iy++)
+			for (int ix = 0; ix < width; ix++)
+				out[ix + iy * width] = GetNoise(xStart + ix * xStep, yStart + iy * yStep);
+		return;
+	}
+
+	// Sample coordinates are separable, so each column/row is scaled once instead of once per sample
+	std::vector<FN_DECIMAL> xs(width);
+	std::vector<FN_DECIMAL> ys(height);
+
+	for (int ix = 0; ix < width; ix++)
+		xs[ix] = (xStart + ix * xStep) * m_frequency;
+	for (int iy = 0; iy < height; iy++)
+		ys[iy] = (yStart + iy * yStep) * m_frequency;
+
+	if (fractal)
+		FillFractalGrid(kernel, xs.data(), width, ys.data(), height, out);
+	else
+		(this->*kernel)(0, xs.data(), width, ys.data(), height, out);
+}
+
+void FastNoise::FillFractalGrid(GridKernel kernel, FN_DECIMAL* xs, int width, FN_DECIMAL* ys, int height, FN_DECIMAL* out) const
+{
+	const int count = width * height;
+
+	(this->*kernel)(m_perm[0], xs, width, ys, height, out);
+
+	switch (m_fractalType)
+	{
+	case Billow:
+		for (int n = 0; n < count; n++)
+			out[n] = FastAbs(out[n]) * 2 - 1;
+		break;
+	case RigidMulti:
+		for (int n = 0; n < count; n++)
+			out[n] = 1 - FastAbs(out[n]);
+		break;
+	default:
+		break;
+	}
+
+	std::vector<FN_DECIMAL> octave(m_octaves > 1 ? count : 0);
+	FN_DECIMAL amp = 1;
+	int i = 0;
+
+	while (++i < m_octaves)
+	{
+		for (int ix = 0; ix < width; ix++)
+			xs[ix] *= m_lacunarity;
+		for (int iy = 0; iy < height; iy++)
+			ys[iy] *= m_lacunarity;
+
+		amp *= m_gain;
+		(this->*kernel)(m_perm[i], xs, width, ys, height, octave.data());
+
+		switch (m_fractalType)
+		{
+		case FBM:
+			for (int n = 0; n < count; n++)
+				out[n] += octave[n] * amp;
+			break;
+		case Billow:
+			for (int n = 0; n < count; n++)
+				out[n] += (FastAbs(octave[n]) * 2 - 1) * amp;
+			break;
+		case RigidMulti:
+			for (int n = 0; n < count; n++)
+				out[n] -= (1 - FastAbs(octave[n])) * amp;
+			break;
+		}
+	}
+
+	if (m_fractalType != RigidMulti)
+	{
+		for (int n = 0; n < count; n++)
+			out[n] *= m_fractalBounding;
+	}
+}
+
+void FastNoise::SingleValueGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const
+{
+	// Column lattice cell and interpolant are the same for every row
+	std::vector<int> colX0(width);
+	std::vector<FN_DECIMAL> colXs(width);
+
+	for (int ix = 0; ix < width; ix++)
+	{
+		int x0 = FastFloor(xs[ix]);
+		colX0[ix] = x0;
+		colXs[ix] = InterpGridFunc(m_interp, xs[ix] - (FN_DECIMAL)x0);
+	}
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		int y0 = FastFloor(ys[iy]);
+		FN_DECIMAL ysI = InterpGridFunc(m_interp, ys[iy] - (FN_DECIMAL)y0);
+
+		// Row hash bases, see Index2D_256()
+		int row0 = m_perm[(y0 & 0xff) + offset];
+		int row1 = m_perm[((y0 + 1) & 0xff) + offset];
+
+		FN_DECIMAL v00 = 0, v10 = 0, v01 = 0, v11 = 0;
+		int lastX0 = 0;
+		FN_DECIMAL* outRow = out + iy * width;
+
+		for (int ix = 0; ix < width; ix++)
+		{
+			int x0 = colX0[ix];
+			if (ix == 0 || x0 != lastX0)
+			{
+				lastX0 = x0;
+				v00 = VAL_LUT[m_perm[(x0 & 0xff) + row0]];
+				v10 = VAL_LUT[m_perm[((x0 + 1) & 0xff) + row0]];
+				v01 = VAL_LUT[m_perm[(x0 & 0xff) + row1]];
+				v11 = VAL_LUT[m_perm[((x0 + 1) & 0xff) + row1]];
+			}
+
+			FN_DECIMAL xf0 = Lerp(v00, v10, colXs[ix]);
+			FN_DECIMAL xf1 = Lerp(v01, v11, colXs[ix]);
+
+			outRow[ix] = Lerp(xf0, xf1, ysI);
+		}
+	}
+}
+
+void FastNoise::SinglePerlinGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const
+{
+	std::vector<int> colX0(width);
+	std::vector<FN_DECIMAL> colXd0(width);
+	std::vector<FN_DECIMAL> colXs(width);
+
+	for (int ix = 0; ix < width; ix++)
+	{
+		int x0 = FastFloor(xs[ix]);
+		colX0[ix] = x0;
+		colXd0[ix] = xs[ix] - (FN_DECIMAL)x0;
+		colXs[ix] = InterpGridFunc(m_interp, colXd0[ix]);
+	}
+
+	const SIMDLevel simdLevel = GetActiveSIMDLevel();
+
+	// SIMD rows read gradient components from per-column buffers: gx00, gy00, gx10, gy10, gx01, gy01, gx11, gy11
+	std::vector<FN_DECIMAL> gradBuffer(simdLevel != SIMD_None ? width * 8 : 0);
+	const FN_DECIMAL* grad[8] = {};
+	if (simdLevel != SIMD_None)
+	{
+		for (int k = 0; k < 8; k++)
+			grad[k] = gradBuffer.data() + k * width;
+	}
+	// Rows inside the same lattice row share gradients, the buffer is only rebuilt when y0 changes
+	bool gradBufferValid = false;
+	int gradBufferY0 = 0;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		int y0 = FastFloor(ys[iy]);
+		FN_DECIMAL yd0 = ys[iy] - (FN_DECIMAL)y0;
+		FN_DECIMAL yd1 = yd0 - 1;
+		FN_DECIMAL ysI = InterpGridFunc(m_interp, yd0);
+
+		// Row hash bases, see Index2D_12()
+		int row0 = m_perm[(y0 & 0xff) + offset];
+		int row1 = m_perm[((y0 + 1) & 0xff) + offset];
+
+		// Gradients of the current lattice cell, reused until the column crosses into the next cell
+		unsigned char g00 = 0, g10 = 0, g01 = 0, g11 = 0;
+		int lastX0 = 0;
+		FN_DECIMAL* outRow = out + iy * width;
+
+		int ix = 0;
+
+#if FN_SIMD_X86
+		if (simdLevel != SIMD_None)
+		{
+			FN_DECIMAL* gradOut = gradBuffer.data();
+			for (int c = 0; c < width && !(gradBufferValid && gradBufferY0 == y0); c++)
+			{
+				int x0 = colX0[c];
+				if (c == 0 || x0 != lastX0)
+				{
+					lastX0 = x0;
+					g00 = m_perm12[(x0 & 0xff) + row0];
+					g10 = m_perm12[((x0 + 1) & 0xff) + row0];
+					g01 = m_perm12[(x0 & 0xff) + row1];
+					g11 = m_perm12[((x0 + 1) & 0xff) + row1];
+				}
+				gradOut[c] = GRAD_X[g00];             gradOut[c + width] = GRAD_Y[g00];
+				gradOut[c + width * 2] = GRAD_X[g10]; gradOut[c + width * 3] = GRAD_Y[g10];
+				gradOut[c + width * 4] = GRAD_X[g01]; gradOut[c + width * 5] = GRAD_Y[g01];
+				gradOut[c + width * 6] = GRAD_X[g11]; gradOut[c + width * 7] = GRAD_Y[g11];
+			}
+			gradBufferValid = true;
+			gradBufferY0 = y0;
+
+			if (simdLevel == SIMD_AVX2)
+				ix = PerlinRowAVX2(width, colXd0.data(), colXs.data(), grad, yd0, yd1, ysI, outRow);
+
+			// The SSE2 row starts where the AVX2 row stopped, so its gradient rows are offset by the same column
+			const FN_DECIMAL* gradTail[8];
+			for (int k = 0; k < 8; k++)
+				gradTail[k] = grad[k] + ix;
+			ix += PerlinRowSSE2(width - ix, colXd0.data() + ix, colXs.data() + ix, gradTail, yd0, yd1, ysI, outRow + ix);
+
+			// Scalar tail reads the same gradients the vector rows used
+			for (; ix < width; ix++)
+			{
+				FN_DECIMAL xd0 = colXd0[ix];
+				FN_DECIMAL xd1 = xd0 - 1;
+
+				FN_DECIMAL xf0 = Lerp(xd0*grad[0][ix] + yd0*grad[1][ix], xd1*grad[2][ix] + yd0*grad[3][ix], colXs[ix]);
+				FN_DECIMAL xf1 = Lerp(xd0*grad[4][ix] + yd1*grad[5][ix], xd1*grad[6][ix] + yd1*grad[7][ix], colXs[ix]);
+
+				outRow[ix] = Lerp(xf0, xf1, ysI);
+			}
+			continue;
+		}
+#endif
+
+		for (; ix < width; ix++)
+		{
+			int x0 = colX0[ix];
+			if (ix == 0 || x0 != lastX0)
+			{
+				lastX0 = x0;
+				g00 = m_perm12[(x0 & 0xff) + row0];
+				g10 = m_perm12[((x0 + 1) & 0xff) + row0];
+				g01 = m_perm12[(x0 & 0xff) + row1];
+				g11 = m_perm12[((x0 + 1) & 0xff) + row1];
+			}
+
+			FN_DECIMAL xd0 = colXd0[ix];
+			FN_DECIMAL xd1 = xd0 - 1;
+
+			FN_DECIMAL xf0 = Lerp(xd0*GRAD_X[g00] + yd0*GRAD_Y[g00], xd1*GRAD_X[g10] + yd0*GRAD_Y[g10], colXs[ix]);
+			FN_DECIMAL xf1 = Lerp(xd0*GRAD_X[g01] + yd1*GRAD_Y[g01], xd1*GRAD_X[g11] + yd1*GRAD_Y[g11], colXs[ix]);
+
+			outRow[ix] = Lerp(xf0, xf1, ysI);
+		}
+	}
+}
+
+void FastNoise::SingleSimplexGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const
+{
+	const SIMDLevel simdLevel = GetActiveSIMDLevel();
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		FN_DECIMAL y = ys[iy];
+
+		// Gradients of the current skewed cell, reused while neighbouring samples stay inside it
+		int lastI = 0, lastJ = 0;
+		bool hasCell = false;
+		unsigned char g0 = 0, g10 = 0, g01 = 0, g2 = 0;
+		FN_DECIMAL* outRow = out + iy * width;
+
+		int ix = 0;
+
+#if FN_SIMD_X86
+		if (simdLevel == SIMD_AVX2)
+			ix = SimplexRowAVX2(m_perm, m_perm12, offset, width, xs, y, outRow);
+		if (simdLevel != SIMD_None)
+			ix += SimplexRowSSE2(m_perm, m_perm12, offset, width - ix, xs + ix, y, outRow + ix);
+#endif
+
+		for (; ix < width; ix++)
+		{
+			FN_DECIMAL x = xs[ix];
+
+			FN_DECIMAL t = (x + y) * F2;
+			int i = FastFloor(x + t);
+			int j = FastFloor(y + t);
+
+			t = (i + j) * G2;
+			FN_DECIMAL X0 = i - t;
+			FN_DECIMAL Y0 = j - t;
+
+			FN_DECIMAL x0 = x - X0;
+			FN_DECIMAL y0 = y - Y0;
+
+			if (!hasCell || i != lastI || j != lastJ)
+			{
+				hasCell = true;
+				lastI = i;
+				lastJ = j;
+
+				int row0 = m_perm[(j & 0xff) + offset];
+				int row1 = m_perm[((j + 1) & 0xff) + offset];
+				g0 = m_perm12[(i & 0xff) + row0];
+				g10 = m_perm12[((i + 1) & 0xff) + row0];
+				g01 = m_perm12[(i & 0xff) + row1];
+				g2 = m_perm12[((i + 1) & 0xff) + row1];
+			}
+
+			int i1, j1;
+			unsigned char g1;
+			if (x0 > y0)
+			{
+				i1 = 1; j1 = 0; g1 = g10;
+			}
+			else
+			{
+				i1 = 0; j1 = 1; g1 = g01;
+			}
+
+			FN_DECIMAL x1 = x0 - (FN_DECIMAL)i1 + G2;
+			FN_DECIMAL y1 = y0 - (FN_DECIMAL)j1 + G2;
+			FN_DECIMAL x2 = x0 - 1 + 2*G2;
+			FN_DECIMAL y2 = y0 - 1 + 2*G2;
+
+			FN_DECIMAL n0, n1, n2;
+
+			t = FN_DECIMAL(0.5) - x0*x0 - y0*y0;
+			if (t < 0) n0 = 0;
+			else
+			{
+				t *= t;
+				n0 = t * t * (x0*GRAD_X[g0] + y0*GRAD_Y[g0]);
+			}
+
+			t = FN_DECIMAL(0.5) - x1*x1 - y1*y1;
+			if (t < 0) n1 = 0;
+			else
+			{
+				t *= t;
+				n1 = t*t*(x1*GRAD_X[g1] + y1*GRAD_Y[g1]);
+			}
+
+			t = FN_DECIMAL(0.5) - x2*x2 - y2*y2;
+			if (t < 0) n2 = 0;
+			else
+			{
+				t *= t;
+				n2 = t*t*(x2*GRAD_X[g2] + y2*GRAD_Y[g2]);
+			}
+
+			outRow[ix] = 70 * (n0 + n1 + n2);
+		}
+	}
+}
+
+void FastNoise::SingleCubicGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const
+{
+	std::vector<int> colX1(width);
+	std::vector<FN_DECIMAL> colXs(width);
+
+	for (int ix = 0; ix < width; ix++)
+	{
+		int x1 = FastFloor(xs[ix]);
+		colX1[ix] = x1;
+		colXs[ix] = xs[ix] - (FN_DECIMAL)x1;
+	}
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		int y1 = FastFloor(ys[iy]);
+		FN_DECIMAL ysI = ys[iy] - (FN_DECIMAL)y1;
+
+		// Row hash bases for lattice rows y1-1 .. y1+2, see Index2D_256()
+		int rows[4];
+		for (int r = 0; r < 4; r++)
+			rows[r] = m_perm[((y1 - 1 + r) & 0xff) + offset];
+
+		// 4x4 lattice values of the current cell, reused until the column crosses into the next cell
+		FN_DECIMAL v[4][4] = {};
+		int lastX1 = 0;
+		FN_DECIMAL* outRow = out + iy * width;
+
+		for (int ix = 0; ix < width; ix++)
+		{
+			int x1 = colX1[ix];
+			if (ix == 0 || x1 != lastX1)
+			{
+				lastX1 = x1;
+				for (int r = 0; r < 4; r++)
+					for (int c = 0; c < 4; c++)
+						v[r][c] = VAL_LUT[m_perm[((x1 - 1 + c) & 0xff) + rows[r]]];
+			}
+
+			FN_DECIMAL xsI = colXs[ix];
+
+			outRow[ix] = CubicLerp(
+				CubicLerp(v[0][0], v[0][1], v[0][2], v[0][3], xsI),
+				CubicLerp(v[1][0], v[1][1], v[1][2], v[1][3], xsI),
+				CubicLerp(v[2][0], v[2][1], v[2][2], v[2][3], xsI),
+				CubicLerp(v[3][0], v[3][1], v[3][2], v[3][3], xsI),
+				ysI) * CUBIC_2D_BOUNDING;
+		}
+	}
+}
@@ -1,34 +1,29 @@
 ﻿#include "HeightGenerator.h"
 #include "WorldGenerationConfig.h"
 #include "FastNoise.h" // FastNoise 经典版
+#include <atomic>
 
-// 静态成员定义
-TMap<int32, FastNoise*> UHeightGenerator::GNoiseCache;
-FCriticalSection UHeightGenerator::GCriticalSection;
-
-int32 UHeightGenerator::GenerateHeightAt(float WorldX, float WorldY, const FWorldGenParams& Params)
+namespace
 {
-    FastNoise* Noise = nullptr;
+    /**
+     * 每线程噪声实例缓存（按种子分组）
+     * 只由所属线程读写，查找时不需要任何锁；实例由 TUniquePtr 持有，线程退出时自动释放
+     */
+    struct FThreadNoiseCache
     {
-        // 线程安全：访问共享缓存
-        FScopeLock Lock(&GCriticalSection);
-        if (FastNoise** Found = GNoiseCache.Find(Params.Seed))
-        {
-            Noise = *Found;
-        }
-        else
-        {
-            // 创建新噪声实例（按种子隔离）
-            Noise = new FastNoise();
-            Noise->SetSeed(Params.Seed);
-            Noise->SetFrequency(Params.TerrainScale); // 控制地形粗糙度
-            Noise->SetNoiseType(FastNoise::Perlin);   // 可替换为 Simplex 更自然
-            GNoiseCache.Add(Params.Seed, Noise);
-        }
-    }
+        TMap<int32, TUniquePtr<FastNoise>> Instances;
+        uint32 Generation = 0;
+    };
 
-    // FastNoise 返回 [-1, 1]，映射到 [0, HeightMultiplier]
-    const float NoiseValue = Noise->GetNoise(WorldX, WorldY);
+    thread_local FThreadNoiseCache GThreadNoiseCache;
+
+    /** 全局缓存代数，ResetNoiseCache 递增后各线程在下次访问时丢弃旧实例 */
+    std::atomic<uint32> GNoiseCacheGeneration{ 0 };
+}
+
+// 将 FastNoise 输出 [-1, 1] 映射为地表高度 [0, WorldHeight-1]
+static int32 NoiseToHeight(float NoiseValue, const FWorldGenParams& Params)
+{
     const float Normalized = (NoiseValue + 1.0f) * 0.5f;
     const float HeightFloat = Normalized * Params.HeightMultiplier;
 
@@ -36,28 +31,76 @@ int32 UHeightGenerator::GenerateHeightAt(float WorldX, float WorldY, const FWorl
     return FMath::Clamp(FMath::RoundToInt(HeightFloat), 0, Params.WorldHeight - 1);
 }
 
+FastNoise* UHeightGenerator::GetNoiseInstance(const FWorldGenParams& Params)
+{
+    FThreadNoiseCache& Cache = GThreadNoiseCache;
+
+    // 缓存已被重置：释放本线程持有的旧实例
+    const uint32 CurrentGeneration = GNoiseCacheGeneration.load(std::memory_order_acquire);
+    if (Cache.Generation != CurrentGeneration)
+    {
+        Cache.Instances.Reset();
+        Cache.Generation = CurrentGeneration;
+    }
+
+    TUniquePtr<FastNoise>& Noise = Cache.Instances.FindOrAdd(Params.Seed);
+    if (!Noise)
+    {
+        // 创建新噪声实例（按种子隔离）
+        Noise = MakeUnique<FastNoise>();
+        Noise->SetSeed(Params.Seed);
+        Noise->SetNoiseType(FastNoise::Perlin);   // 可替换为 Simplex 更自然
+    }
+
+    // 同一种子可能对应不同配置，频率每次同步（实例为本线程独占，可直接修改）
+    Noise->SetFrequency(Params.TerrainScale); // 控制地形粗糙度
+    return Noise.Get();
+}
+
+void UHeightGenerator::ResetNoiseCache()
+{
+    GNoiseCacheGeneration.fetch_add(1, std::memory_order_release);
+
+    // 调用线程（通常为游戏线程）立即释放，其余线程在下次生成时释放
+    GThreadNoiseCache.Instances.Reset();
+    GThreadNoiseCache.Generation = GNoiseCacheGeneration.load(std::memory_order_acquire);
+}
+
+int32 UHeightGenerator::GenerateHeightAt(float WorldX, float WorldY, const FWorldGenParams& Params)
+{
+    FastNoise* Noise = GetNoiseInstance(Params);
+
+    // FastNoise 返回 [-1, 1]，映射到 [0, HeightMultiplier]
+    return NoiseToHeight(Noise->GetNoise(WorldX, WorldY), Params);
+}
+
 void UHeightGenerator::GenerateChunkHeights(
     int32 ChunkX,
     int32 ChunkY,
     const FWorldGenParams& Params,
     TArray<int32>& OutHeights)
 {
+    const int32 Size = Params.ChunkSize;
+
     // 初始化输出数组（16x16 = 256）
-    OutHeights.SetNumZeroed(Params.ChunkSize * Params.ChunkSize);
+    OutHeights.SetNumUninitialized(Size * Size);
+
+    // 整个区块的噪声一次性批量生成：
+    // 噪声类型分派、行坐标与晶格梯度在相邻采样点之间复用，而不是逐点调用 GetNoise
+    // 采样点为整数格子坐标，输出按行主序 x + y * Size 排列，与 OutHeights 一致
+    TArray<float, TInlineAllocator<256>> NoiseValues;
+    NoiseValues.SetNumUninitialized(Size * Size);
+
+    FastNoise* Noise = GetNoiseInstance(Params);
+    Noise->FillNoiseGrid(
+        NoiseValues.GetData(),
+        Size,
+        Size,
+        static_cast<float>(ChunkX * Size),
+        static_cast<float>(ChunkY * Size));
 
-    // 遍历区块内每个格子
-    for (int32 x = 0; x < Params.ChunkSize; x++)
+    for (int32 Index = 0; Index < Size * Size; Index++)
     {
-        for (int32 y = 0; y < Params.ChunkSize; y++) // y: 区块内局部 Y 坐标
-        {
-            // 转换为世界坐标（整数格子中心）
-            const float WorldX = static_cast<float>(ChunkX * Params.ChunkSize + x);
-            const float WorldY = static_cast<float>(ChunkY * Params.ChunkSize + y);
-
-            // 生成该点高度
-            const int32 Height = GenerateHeightAt(WorldX, WorldY, Params);
-            // 存储到高度图（行主序：x + y * width）
-            OutHeights[x + y * Params.ChunkSize] = Height;
-        }
+        OutHeights[Index] = NoiseToHeight(NoiseValues[Index], Params);
     }
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+﻿
+// WorldGenerationChecks.cpp
+#include "FastNoise.h"
+#include "HAL/IConsoleManager.h"
+#include "LogWorldGeneration.h"
+
+/**
+ * WorldGeneration 自检（PIE / 开发版中在控制台输入）
+ * 用于修改噪声 SIMD 网格路径后确认结果未变，只在内存中进行。
+ */
+
+//------------------------------------ 噪声网格 ------------------------------------
+// FillNoiseGrid 在每个 SIMD 级别下须与逐点 GetNoise 逐位一致。
+// 宽度覆盖 AVX2（8 列）、SSE2（4 列）与标量尾部的各种组合，如 12 = 8 + 4、13 = 8 + 4 + 1。
+static void CheckNoiseGrid()
+{
+    const FastNoise::NoiseType Types[] =
+    {
+        FastNoise::Perlin, FastNoise::PerlinFractal, FastNoise::Simplex, FastNoise::SimplexFractal,
+        FastNoise::Value, FastNoise::Cubic,
+    };
+    const int32 Widths[] = { 1, 3, 4, 5, 7, 8, 9, 12, 13, 15, 16, 20, 21, 28, 36 };
+    const int32 Height = 5;
+    const FN_DECIMAL XStart = -7.5f, YStart = 3.25f, XStep = 1.25f, YStep = 0.75f;
+
+    TArray<FN_DECIMAL> Grid;
+    int32 NumFailed = 0;
+    FString Report;
+    for (int32 Level = FastNoise::SIMD_None; Level <= FastNoise::GetSupportedSIMDLevel(); Level++)
+    {
+        int32 NumSamples = 0;
+        int32 NumMismatched = 0;
+        for (const FastNoise::NoiseType Type : Types)
+        {
+            for (const int32 Width : Widths)
+            {
+                FastNoise Noise(1337);
+                Noise.SetNoiseType(Type);
+                Noise.SetFrequency(0.31f);
+                Noise.SetMaxSIMDLevel(static_cast<FastNoise::SIMDLevel>(Level));
+
+                Grid.SetNumUninitialized(Width * Height);
+                Noise.FillNoiseGrid(Grid.GetData(), Width, Height, XStart, YStart, XStep, YStep);
+
+                for (int32 Y = 0; Y < Height; Y++)
+                {
+                    for (int32 X = 0; X < Width; X++)
+                    {
+                        const FN_DECIMAL Expected = Noise.GetNoise(XStart + X * XStep, YStart + Y * YStep);
+                        NumSamples++;
+                        if (FMemory::Memcmp(&Expected, &Grid[X + Y * Width], sizeof(FN_DECIMAL)) != 0)
+                        {
+                            if (NumMismatched++ == 0)
+                            {
+                                Report += FString::Printf(TEXT("\n    first mismatch: type %d width %d at (%d, %d): grid %f, GetNoise %f"),
+                                    static_cast<int32>(Type), Width, X, Y, Grid[X + Y * Width], Expected);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        NumFailed += NumMismatched;
+        Report += FString::Printf(TEXT("\n  SIMD level %d: %d/%d samples mismatched"), Level, NumMismatched, NumSamples);
+    }
+
+    if (NumFailed > 0)
+        UE_LOG(H_LogWorldGeneration, Error, TEXT("WorldGen.Check.NoiseGrid: FAILED%s"), *Report);
+    else
+        UE_LOG(H_LogWorldGeneration, Display, TEXT("WorldGen.Check.NoiseGrid: passed%s"), *Report);
+}
+
+static FAutoConsoleCommand GWorldGenCheckNoiseGridCommand(
+    TEXT("WorldGen.Check.NoiseGrid"),
+    TEXT("Compare FillNoiseGrid against per-sample GetNoise at every supported SIMD level, including widths that are not multiples of 8. Usage: WorldGen.Check.NoiseGrid"),
+    FConsoleCommandDelegate::CreateStatic(&CheckNoiseGrid));
@@ -1,7 +1,10 @@
 ﻿#include "WorldGenerationSubsystem.h"
 #include "ChunkGenerationManager.h"
 #include "WorldGenerationConfig.h"
+#include "HeightGenerator.h"
 #include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
 #include "LogWorldGeneration.h"
 
 void UWorldGenerationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
@@ -9,6 +12,62 @@ void UWorldGenerationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
     Super::Initialize(Collection);
     // 创建区块管理器实例
     ChunkManager = NewObject<UChunkGenerationManager>(this);
+    FarTerrainManager = NewObject<UFarTerrainManager>(this);
+
+    // 远景地形隐藏已加载体素区块下方的部分
+    ChunkManager->OnChunkResidencyChanged.AddUObject(FarTerrainManager, &UFarTerrainManager::SetVoxelChunkLoaded);
+}
+
+void UWorldGenerationSubsystem::Deinitialize()
+{
+    // 关卡结束：释放缓存的噪声实例
+    UHeightGenerator::ResetNoiseCache();
+    Super::Deinitialize();
+}
+
+void UWorldGenerationSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    // 体素区块与远景区域共用的每帧提交预算
+    int32 CommitBudget = 0;
+
+    if (ChunkManager)
+    {
+        // 增量模式下每帧跟随玩家（未跨越区块边界时开销为 O(1)）
+        if (StreamingRadius >= 0 && ChunkManager->CurrentConfig && ChunkManager->ChunkActorClass
+            && ChunkManager->CurrentConfig->Params.bIncrementalStreaming)
+        {
+            if (APlayerController* PC = GetWorld()->GetFirstPlayerController())
+            {
+                if (APawn* Pawn = PC->GetPawn())
+                {
+                    GenerateWorldAroundPlayer(Pawn->GetActorLocation(), StreamingRadius);
+                }
+            }
+        }
+
+        // 视线转向时重新排序请求队列，然后按优先级提交生成任务
+        ChunkManager->UpdateStreamingFocus(ChunkManager->GetStreamingCenter(), GetPlayerViewDirection());
+        ChunkManager->DispatchQueuedRequests();
+        if (ChunkManager->CurrentConfig)
+        {
+            CommitBudget = FMath::Max(1, ChunkManager->CurrentConfig->Params.MaxChunkCommitsPerFrame);
+            CommitBudget -= ChunkManager->ProcessCompletedChunks(GetWorld());
+        }
+    }
+
+    // 远景区域在体素区块之后提交，只使用其剩余的预算，也不挤占其生成任务
+    if (FarTerrainManager)
+    {
+        FarTerrainManager->DispatchQueuedRequests();
+        FarTerrainManager->ProcessCompletedRegions(CommitBudget);
+    }
+}
+
+TStatId UWorldGenerationSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UWorldGenerationSubsystem, STATGROUP_Tickables);
 }
 
 void UWorldGenerationSubsystem::SetChunkActorClass(TSubclassOf<AActor> InClass)
@@ -47,6 +106,10 @@ void UWorldGenerationSubsystem::OnWorldConfigLoadedCallback()
         if (ChunkManager)
         {
             ChunkManager->Initialize(LoadedConfig);
+            if (FarTerrainManager)
+            {
+                FarTerrainManager->Initialize(LoadedConfig);
+            }
             UE_LOG(H_LogWorldGeneration, Log, TEXT("World config loaded asynchronously: %s"), *LoadedConfig->GetName());
         
             OnWorldConfigLoaded.Broadcast();
@@ -58,6 +121,26 @@ void UWorldGenerationSubsystem::OnWorldConfigLoadedCallback()
     }
 }
 
+FChunkStreamingStats UWorldGenerationSubsystem::GetStreamingStats() const
+{
+    return ChunkManager ? ChunkManager->GetStreamingStats() : FChunkStreamingStats();
+}
+
+FVector UWorldGenerationSubsystem::GetPlayerViewDirection() const
+{
+    if (UWorld* World = GetWorld())
+    {
+        if (APlayerController* PC = World->GetFirstPlayerController())
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+            return ViewRotation.Vector();
+        }
+    }
+    return FVector::ZeroVector;
+}
+
 void UWorldGenerationSubsystem::GenerateWorldAroundPlayer(const FVector& PlayerLocation, int32 Radius)
 {
     if (!GetWorld() || !ChunkManager || !ChunkManager->CurrentConfig || !ChunkManager->ChunkActorClass)
@@ -73,17 +156,27 @@ void UWorldGenerationSubsystem::GenerateWorldAroundPlayer(const FVector& PlayerL
 
     const FIntPoint PlayerChunkPos(PlayerChunkX, PlayerChunkY);
 
-    // 卸载远处区块
-    ChunkManager->UnloadDistantChunks(PlayerChunkPos, Radius);
+    // 更新流式中心：玩家移动后队列按新位置重新排序
+    ChunkManager->UpdateStreamingFocus(PlayerChunkPos, GetPlayerViewDirection());
 
-    // 生成周围区块（方形区域）
-    for (int32 dx = -Radius; dx <= Radius; dx++)
+    if (ChunkManager->CurrentConfig->Params.bIncrementalStreaming)
     {
-        for (int32 dy = -Radius; dy <= Radius; dy++)
-        {
-            const int32 TargetChunkX = PlayerChunkX + dx;
-            const int32 TargetChunkY = PlayerChunkY + dy;
-            ChunkManager->RequestChunk(TargetChunkX, TargetChunkY, GetWorld());
-        }
+        // 增量模式：只处理进入/离开窗口的区块，并记住半径供 Tick 跟随玩家
+        StreamingRadius = Radius;
+        ChunkManager->UpdateStreamingWindow(PlayerChunkPos, Radius, GetWorld());
+    }
+    else
+    {
+        // 全量模式：卸载远处区块，并请求圆形范围内所有区块
+        ChunkManager->RescanStreamingArea(PlayerChunkPos, Radius, GetWorld());
     }
+
+    // 远景地形跟随同一中心，体素半径内的区域不构建
+    if (FarTerrainManager)
+    {
+        FarTerrainManager->UpdateStreamingArea(PlayerChunkPos, Radius, GetWorld());
+    }
+
+    // 立即开始生成优先级最高的区块
+    ChunkManager->DispatchQueuedRequests();
 }
\ No newline at end of file
@@ -2,10 +2,104 @@
 
 #include "CoreMinimal.h"
 #include "IChunkInterface.h"
+#include "ChunkVoxelStorage.h"
 #include "UObject/Object.h"
+#include "Containers/Queue.h"
 #include "ChunkGenerationManager.generated.h"
 
 class UWorldGenerationConfig;
+struct FWorldGenParams;
+
+/** 区块 Actor 提交 / 卸载通知：参数为区块坐标与是否已加载 */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChunkResidencyChanged, const FIntPoint& /*ChunkKey*/, bool /*bLoaded*/);
+
+/**
+ * @brief 后台生成完成的区块体素数据（工作线程 → 游戏线程）
+ */
+struct FGeneratedChunkData
+{
+    /** 区块逻辑坐标 (ChunkX, ChunkY) */
+    FIntPoint ChunkKey;
+
+    /** 发起生成时的配置代数，配置切换后旧结果会被丢弃 */
+    uint32 ConfigGeneration = 0;
+
+    /** 体素方块 ID（调色板压缩），布局与 SetChunkData 一致 */
+    FChunkVoxelStorage Voxels;
+};
+
+/**
+ * @brief 排队等待生成的区块请求
+ *
+ * Priority 越小越先生成（距离平方，背对视线方向的区块额外加权）。
+ */
+struct FChunkGenerationRequest
+{
+    FIntPoint ChunkKey;
+    float Priority = 0.0f;
+};
+
+/** 请求堆排序谓词：Priority 小的位于堆顶 */
+struct FChunkGenerationRequestPredicate
+{
+    FORCEINLINE bool operator()(const FChunkGenerationRequest& A, const FChunkGenerationRequest& B) const
+    {
+        return A.Priority < B.Priority;
+    }
+};
+
+/**
+ * @brief 生成任务与管理器共享的结果队列
+ *
+ * 通过线程安全的 TSharedPtr 持有，管理器被回收后仍在运行的任务也能安全写入。
+ */
+struct FChunkGenerationResults
+{
+    TQueue<FGeneratedChunkData, EQueueMode::Mpsc> Completed;
+};
+
+/**
+ * @brief 区块流式加载统计
+ *
+ * StationaryChurnCount 用于验证加载/卸载形状一致：玩家静止时应始终为 0。
+ */
+USTRUCT(BlueprintType)
+struct FChunkStreamingStats
+{
+    GENERATED_BODY()
+
+    /** 加入请求队列的区块总数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 ChunksRequested = 0;
+
+    /** 已在游戏线程提交（生成 Actor）的区块总数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 ChunksCommitted = 0;
+
+    /** 已卸载的区块总数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 ChunksUnloaded = 0;
+
+    /** 被取消的排队/生成中请求总数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 RequestsCancelled = 0;
+
+    /** 玩家静止（中心区块与半径均未变化）时发生的请求或卸载次数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 StationaryChurnCount = 0;
+
+    /** 通过 SpawnActor 新建的区块 Actor 数量（含预热） */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 ChunkActorsSpawned = 0;
+
+    /** 从对象池复用的区块 Actor 数量 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 ChunkActorsReused = 0;
+
+    /** 已加载区块切换 LOD 级别的次数 */
+    UPROPERTY(BlueprintReadOnly, Category = "Streaming")
+    int32 LODTransitions = 0;
+};
 
 /**
  * @brief 区块生成管理器
@@ -34,22 +128,121 @@ public:
     /**
      * @brief 请求指定坐标的区块
      *
-     * 若区块已加载，则返回现有 Actor；否则生成新 Actor。
+     * 若区块已加载，则返回现有 Actor；否则按优先级加入请求队列（已排队或生成中则忽略），
+     * 由 DispatchQueuedRequests 提交后台生成，完成后由 ProcessCompletedChunks 在游戏线程生成 Actor。
      *
      * @param ChunkX 区块在 X 轴的索引（整数，如 -1, 0, 1...）
      * @param ChunkY 区块在 Y 轴的索引（整数）
      * @param World 用于生成 Actor 的世界对象
-     * @return 生成的或已存在的区块 Actor，失败返回 nullptr
+     * @return 已存在的区块 Actor；尚未加载（排队/生成中）或失败返回 nullptr
      */
     AActor* RequestChunk(int32 ChunkX, int32 ChunkY, UWorld* World);
 
+    /**
+     * @brief 更新流式加载的中心区块与视线方向
+     *
+     * 中心区块变化或视线明显转向时，重新计算队列中所有请求的优先级。
+     *
+     * @param CenterChunk 玩家当前所在的区块坐标 (X, Y)
+     * @param ViewDirection 摄像机朝向（仅使用水平分量，零向量表示不考虑方向）
+     */
+    void UpdateStreamingFocus(const FIntPoint& CenterChunk, const FVector& ViewDirection);
+
+    /** 当前流式加载中心区块 */
+    FIntPoint GetStreamingCenter() const { return StreamingCenter; }
+
+    /**
+     * @brief 按优先级把排队的请求提交为后台生成任务
+     *
+     * 同时运行的任务数不超过 FWorldGenParams::MaxConcurrentGenerationTasks。
+     */
+    void DispatchQueuedRequests();
+
+    /**
+     * @brief 提交已完成的后台生成结果（游戏线程每帧调用）
+     *
+     * 每次最多提交 FWorldGenParams::MaxChunkCommitsPerFrame 个区块：
+     * 先执行排队的 LOD 刷新，再生成区块 Actor 并调用 SetChunkData / RefreshRendering。
+     *
+     * @param World 用于生成 Actor 的世界对象
+     * @return 本次实际提交的区块数量（含 LOD 刷新）
+     */
+    int32 ProcessCompletedChunks(UWorld* World);
+
+    /**
+     * @brief 生成区块体素数据（方块 ID 数组）
+     *
+     * 纯数据计算，不访问任何 UObject，可在工作线程调用。
+     * 调用 HeightGenerator 生成地表高度，然后填充土/草方块。
+     *
+     * @param ChunkX 区块 X 索引
+     * @param ChunkY 区块 Y 索引
+     * @param Params 生成参数（按值拷贝进任务）
+     * @param OutVoxels 输出体素（16 x 16 x WorldHeight）
+     */
+    static void BuildChunkVoxels(int32 ChunkX, int32 ChunkY, const FWorldGenParams& Params, FChunkVoxelStorage& OutVoxels);
+
+    /**
+     * @brief 地形方块分配规则：高度 Z 处的方块 ID（地表高度为 SurfaceZ，Z 不超过 SurfaceZ）
+     *
+     * 体素区块与远景地形共用，保证远景颜色与实际地表方块一致。
+     */
+    static int32 GetTerrainBlockID(int32 Z, int32 SurfaceZ);
+
+    /** 正在后台生成、尚未提交的区块数量 */
+    int32 GetNumPendingChunks() const { return PendingChunks.Num(); }
+
+    /** 排队等待生成的区块数量 */
+    int32 GetNumQueuedChunks() const { return QueuedChunks.Num(); }
+
+    /**
+     * @brief 增量流式加载：只处理进入或离开窗口的区块
+     *
+     * 记录上一次的中心区块与半径，按行计算新旧圆形窗口的区间差：
+     * 进入加载窗口的区块加入请求队列，离开卸载窗口（半径 + UnloadHysteresis）的区块被卸载或取消。
+     * 玩家停留在同一区块时为 O(1)，跨越区块边界时为 O(R)，可以每帧调用。
+     *
+     * @param CenterChunk 玩家当前所在的区块坐标 (X, Y)
+     * @param Radius 加载半径（单位：区块数）
+     * @param World 用于生成 Actor 的世界对象
+     */
+    void UpdateStreamingWindow(const FIntPoint& CenterChunk, int32 Radius, UWorld* World);
+
+    /**
+     * @brief 全量流式加载：扫描整个圆形范围
+     *
+     * 先卸载超出卸载半径的区块，再请求加载半径内所有未加载区块。
+     *
+     * @param CenterChunk 玩家当前所在的区块坐标 (X, Y)
+     * @param Radius 加载半径（单位：区块数）
+     * @param World 用于生成 Actor 的世界对象
+     */
+    void RescanStreamingArea(const FIntPoint& CenterChunk, int32 Radius, UWorld* World);
+
+    /** 流式加载统计 */
+    const FChunkStreamingStats& GetStreamingStats() const { return StreamingStats; }
+
+    /**
+     * @brief 预先生成隐藏的区块 Actor 放入对象池
+     *
+     * 把 SpawnActor 的开销提前到加载阶段，数量不超过 MaxPooledChunkActors。
+     *
+     * @param World 用于生成 Actor 的世界对象
+     * @param Count 期望的池内 Actor 数量
+     */
+    void WarmUpChunkPool(UWorld* World, int32 Count);
+
+    /** 对象池中空闲的区块 Actor 数量 */
+    int32 GetNumPooledChunkActors() const { return ChunkActorPool.Num(); }
+
     /**
      * @brief 卸载远离玩家的区块以节省内存
      *
-     * 遍历已加载区块，销毁超出渲染距离的区块 Actor，并从缓存中移除。
+     * 遍历已加载区块，销毁超出卸载半径（RenderDistance + UnloadHysteresis）的区块 Actor，并从缓存中移除；
+     * 同时取消超出范围、尚未完成的排队与生成请求。
      *
      * @param PlayerChunkPos 玩家当前所在的区块坐标 (X, Y)
-     * @param RenderDistance 渲染半径（单位：区块数）
+     * @param RenderDistance 加载半径（单位：区块数）
      */
     void UnloadDistantChunks(const FIntPoint& PlayerChunkPos, int32 RenderDistance);
 
@@ -64,6 +257,9 @@ public:
     /** 当前生效的世界生成配置 */
     TObjectPtr<UWorldGenerationConfig> CurrentConfig;
 
+    /** 区块 Actor 加入 / 移出 LoadedChunks 时广播（远景地形据此隐藏被体素区块覆盖的部分） */
+    FOnChunkResidencyChanged OnChunkResidencyChanged;
+
 private:
     /**
      * @brief 已加载区块的缓存映射
@@ -72,6 +268,61 @@ private:
      * 值：弱引用指向区块 Actor（避免阻止 GC）
      */
     TMap<FIntPoint, TWeakObjectPtr<AActor>> LoadedChunks;
+
+    /** 已提交后台生成、等待提交的区块（移除即表示取消，结果到达后丢弃） */
+    TSet<FIntPoint> PendingChunks;
+
+    /** 等待生成的请求（按 Priority 组织的最小堆，可能含已取消的过期项） */
+    TArray<FChunkGenerationRequest> RequestQueue;
+
+    /** 仍有效的排队区块，用于去重；移除即表示取消 */
+    TSet<FIntPoint> QueuedChunks;
+
+    /** 已提交但结果尚未被取走的后台任务数量（包括已取消的任务） */
+    int32 NumTasksInFlight = 0;
+
+    /** 流式加载中心区块 */
+    FIntPoint StreamingCenter = FIntPoint::ZeroValue;
+
+    /** 水平视线方向（单位向量，零向量表示未知） */
+    FVector2D StreamingViewDirection = FVector2D::ZeroVector;
+
+    /** 增量流式窗口状态（上一次的中心与半径） */
+    bool bHasStreamingWindow = false;
+    FIntPoint WindowCenter = FIntPoint::ZeroValue;
+    int32 WindowRadius = 0;
+    int32 WindowUnloadRadius = 0;
+
+    /** 上一次流式更新的中心与半径，用于判断玩家是否静止 */
+    bool bHasLastUpdate = false;
+    FIntPoint LastUpdateCenter = FIntPoint::ZeroValue;
+    int32 LastUpdateRadius = 0;
+
+    /** 当前流式更新是否为静止更新（期间的请求/卸载计入 StationaryChurnCount） */
+    bool bStationaryUpdate = false;
+
+    /** 上一次计算 LOD 时的中心区块 */
+    bool bHasLODCenter = false;
+    FIntPoint LODCenter = FIntPoint::ZeroValue;
+
+    /** 已切换级别、等待刷新渲染的区块（按距离排序，最近的在末尾） */
+    TArray<FIntPoint> LODRefreshQueue;
+
+    /** 仍有效的 LOD 刷新项，用于去重；移除即表示取消 */
+    TSet<FIntPoint> QueuedLODRefreshes;
+
+    /** 流式加载统计 */
+    FChunkStreamingStats StreamingStats;
+
+    /** 已回收的空闲区块 Actor（隐藏，保留组件与缓冲区供复用） */
+    UPROPERTY()
+    TArray<TObjectPtr<AActor>> ChunkActorPool;
+
+    /** 后台任务的结果队列 */
+    TSharedPtr<FChunkGenerationResults, ESPMode::ThreadSafe> GenerationResults = MakeShared<FChunkGenerationResults, ESPMode::ThreadSafe>();
+
+    /** 配置代数，每次 Initialize 递增 */
+    uint32 ConfigGeneration = 0;
  
     /**
      * @brief 实际生成区块 Actor 并设置其世界位置
@@ -80,11 +331,51 @@ private:
     AActor* SpawnChunkActor(int32 ChunkX, int32 ChunkY, UWorld* World);
 
     /**
-     * @brief 为区块生成体素数据（方块 ID 数组）
+     * @brief 获取区块 Actor：优先从对象池复用并移动到区块位置，池空时才生成新 Actor
+     * @return 可用的区块 Actor，失败返回 nullptr
+     */
+    AActor* AcquireChunkActor(int32 ChunkX, int32 ChunkY, UWorld* World);
+
+    /** 回收区块 Actor：池未满时隐藏后放回池中，否则销毁 */
+    void ReleaseChunkActor(AActor* Chunk);
+
+    /** 计算区块请求优先级（越小越先生成） */
+    float ComputeChunkPriority(const FIntPoint& ChunkKey) const;
+
+    /** 重新计算队列中所有请求的优先级并重建堆 */
+    void ReprioritizeQueue();
+
+    /** 立即为区块启动后台生成任务 */
+    void LaunchGenerationTask(const FIntPoint& ChunkKey);
+
+    /** 卸载单个区块，或取消其排队/生成中的请求 */
+    void UnloadChunk(const FIntPoint& ChunkKey);
+
+    /** 与四个水平相邻的已加载区块互相登记，并刷新受影响的相邻区块（边界方块可见性变化） */
+    void LinkChunkNeighbors(const FIntPoint& ChunkKey, AActor* Chunk);
+
+    /** 解除与相邻区块的登记（卸载前调用） */
+    void UnlinkChunkNeighbors(const FIntPoint& ChunkKey, AActor* Chunk);
+
+    /** 卸载半径 = 加载半径 + UnloadHysteresis */
+    int32 GetUnloadRadius(int32 LoadRadius) const;
+
+    /** 记录本次流式更新的中心与半径，并判断是否为静止更新 */
+    void BeginStreamingUpdate(const FIntPoint& CenterChunk, int32 Radius);
+
+    /**
+     * @brief 按到中心区块的距离计算 LOD 级别（LODDistances 中不超过该距离的阈值个数）
+     * @param CurrentLOD 区块当前级别：切回更精细的级别时需再靠近 LODHysteresis
+     */
+    int32 ComputeChunkLOD(const FIntPoint& ChunkKey, const FIntPoint& CenterChunk, int32 CurrentLOD) const;
+
+    /**
+     * @brief 中心区块变化后重新计算已加载区块的 LOD
      *
-     * 调用 HeightGenerator 生成地表高度，然后填充土/草方块。
+     * 只检查距离可能跨过 LOD 阈值的环（耗时与环面积成正比，而不是已加载区块数）；
+     * 先统一切换级别，刷新排入 LODRefreshQueue，由 ProcessCompletedChunks 按每帧提交预算执行。
      */
-    void GenerateChunkData(AActor* Chunk, int32 ChunkX, int32 ChunkY);
+    void UpdateChunkLODs(const FIntPoint& CenterChunk);
 
     /**
      * @brief 计算两个区块之间的欧氏距离平方（避免开方运算）
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FarTerrainActor.generated.h"
+
+class UProceduralMeshComponent;
+class UMaterialInterface;
+
+/**
+ * @brief 远景地形网格数据（可在工作线程构建）
+ *
+ * 规则网格，顶点坐标相对区域原点；顶点色为地表方块颜色。
+ * 四边形不跨越区块边界，三角形按区块分组，便于隐藏已被体素区块覆盖的部分。
+ */
+struct FFarTerrainMeshData
+{
+    TArray<FVector> Vertices;
+    TArray<int32> Triangles;
+    TArray<FVector> Normals;
+    TArray<FColor> Colors;
+
+    /** 区域内区块 (CX, CY) 的三角形下标位于 [ChunkTriangleStarts[S], ChunkTriangleStarts[S + 1])，S = CX + CY * RegionSize */
+    TArray<int32> ChunkTriangleStarts;
+
+    FORCEINLINE bool IsEmpty() const { return Triangles.Num() == 0; }
+};
+
+/**
+ * @brief 远景地形 Actor
+ *
+ * 体素区块之外的低精度地形：每个区域一个 ProceduralMeshComponent（独立包围盒，可单独视锥剔除），
+ * 没有体素数据、没有 AChunkActor，也没有碰撞。卸载的区域组件回收复用。
+ */
+UCLASS()
+class WORLDGENERATION_API AFarTerrainActor : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    AFarTerrainActor();
+
+    /**
+     * @brief 提交区域网格（替换已有的同一区域）
+     * @param RegionKey 区域坐标
+     * @param Location 区域原点的世界坐标
+     * @param MeshData 网格数据，顶点相对区域原点（保留在 Actor 中，供之后按区块重新筛选）
+     * @param HiddenChunks 按区块槽位 CX + CY * RegionSize 标记不显示的区块
+     */
+    void ApplyRegionMesh(const FIntPoint& RegionKey, const FVector& Location, FFarTerrainMeshData&& MeshData, const TBitArray<>& HiddenChunks);
+
+    /**
+     * @brief 更新区域内不显示的区块（只重建索引，不重新构建网格）
+     * @param RegionKey 区域坐标
+     * @param HiddenChunks 按区块槽位 CX + CY * RegionSize 标记不显示的区块
+     */
+    void SetHiddenChunks(const FIntPoint& RegionKey, const TBitArray<>& HiddenChunks);
+
+    /** 移除区域网格，组件放回空闲列表 */
+    void RemoveRegion(const FIntPoint& RegionKey);
+
+    /** 移除全部区域（配置切换） */
+    void ClearRegions();
+
+    /** 是否已有该区域的网格 */
+    bool HasRegion(const FIntPoint& RegionKey) const { return RegionMeshes.Contains(RegionKey); }
+
+    /** 已显示的区域数量 */
+    int32 GetNumRegions() const { return RegionMeshes.Num(); }
+
+    /** 远景地形材质（使用顶点色） */
+    UPROPERTY(EditAnywhere, Category = "FarTerrain")
+    TObjectPtr<UMaterialInterface> Material;
+
+private:
+    /** 已显示的区域 → 网格组件 */
+    UPROPERTY(Transient)
+    TMap<FIntPoint, TObjectPtr<UProceduralMeshComponent>> RegionMeshes;
+
+    /** 已回收的空闲组件 */
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UProceduralMeshComponent>> FreeMeshes;
+
+    /** 已显示区域的完整网格数据 */
+    TMap<FIntPoint, FFarTerrainMeshData> RegionMeshData;
+
+    /** 取出空闲组件，没有则新建 */
+    UProceduralMeshComponent* AcquireMeshComponent();
+
+    /** 只用未隐藏区块的三角形重建网格段，全部隐藏时隐藏组件 */
+    void UpdateMeshSection(UProceduralMeshComponent* Mesh, const FFarTerrainMeshData& MeshData, const TBitArray<>& HiddenChunks);
+};
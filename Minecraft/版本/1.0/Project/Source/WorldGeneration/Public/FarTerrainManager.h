@@ -0,0 +1,178 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Containers/Queue.h"
+#include "FarTerrainActor.h"
+#include "FarTerrainManager.generated.h"
+
+class UWorldGenerationConfig;
+struct FWorldGenParams;
+
+/**
+ * @brief 后台构建完成的远景区域网格（工作线程 → 游戏线程）
+ */
+struct FFarTerrainRegionData
+{
+    /** 区域坐标（区域 = FarTerrainRegionSize x FarTerrainRegionSize 个区块） */
+    FIntPoint RegionKey;
+
+    /** 发起构建时的配置代数，配置切换后旧结果会被丢弃 */
+    uint32 ConfigGeneration = 0;
+
+    FFarTerrainMeshData Mesh;
+};
+
+/**
+ * @brief 构建任务与管理器共享的结果队列
+ */
+struct FFarTerrainResults
+{
+    TQueue<FFarTerrainRegionData, EQueueMode::Mpsc> Completed;
+};
+
+/**
+ * @brief 远景地形管理器
+ *
+ * 在体素流式加载半径之外，用 UHeightGenerator::GenerateChunkHeights 的高度图按 FarTerrainSampleStep
+ * 降采样构建每个区域一个的网格，按地表方块着色，不生成体素也不生成区块 Actor。
+ * 按更大的 FarTerrainRadius 随玩家向外流式加载，卸载滞后一个区域。
+ *
+ * 网格顶点放在其覆盖范围内最低地表方块的底面再下移一个最低精度 LOD 单元（8 个方块），
+ * 与降采样后地表更低的 LOD 区块相接处也不会高出体素地表；四边形按区块划分、不跨越区块边界。
+ * 体素区块加载后隐藏网格中位于该区块的四边形（只重建索引），已加载区块下方（挖开的洞、
+ * 降采样后地表更低的 LOD 区块）不会出现远景网格；完全位于体素加载半径内的区域不构建，
+ * 已显示的区域被完全覆盖后在其区块全部加载时卸载。
+ */
+UCLASS()
+class WORLDGENERATION_API UFarTerrainManager : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief 初始化配置（配置切换时清除全部区域）
+     * @param Config 世界生成配置
+     */
+    void Initialize(UWorldGenerationConfig* Config);
+
+    /**
+     * @brief 更新远景区域：请求进入远景半径的区域，卸载离开的区域
+     *
+     * 中心区块与体素半径都未变化时为 O(1)，可以每帧调用。
+     *
+     * @param CenterChunk 玩家当前所在的区块坐标 (X, Y)
+     * @param VoxelRadius 体素区块加载半径（单位：区块数）
+     * @param World 用于生成远景 Actor 的世界对象
+     */
+    void UpdateStreamingArea(const FIntPoint& CenterChunk, int32 VoxelRadius, UWorld* World);
+
+    /** 按距离提交排队的区域构建任务（同时最多 MaxRegionTasksInFlight 个，不挤占体素区块生成） */
+    void DispatchQueuedRequests();
+
+    /**
+     * @brief 提交已完成的区域网格（游戏线程每帧调用）
+     *
+     * 与体素区块共用 MaxChunkCommitsPerFrame：由调用方传入体素区块提交后的剩余预算，
+     * 体素区块集中加载时远景区域顺延到之后的帧。
+     *
+     * @param Budget 本帧最多提交的区域数量
+     * @return 本次实际提交的区域数量
+     */
+    int32 ProcessCompletedRegions(int32 Budget);
+
+    /**
+     * @brief 体素区块加载/卸载通知（绑定 UChunkGenerationManager::OnChunkResidencyChanged）
+     *
+     * 所在区域已显示时标记为待更新，下一次 ProcessCompletedRegions 时重新隐藏/显示对应的四边形。
+     *
+     * @param ChunkKey 区块坐标
+     * @param bLoaded 区块是否已加载
+     */
+    void SetVoxelChunkLoaded(const FIntPoint& ChunkKey, bool bLoaded);
+
+    /**
+     * @brief 构建区域网格
+     *
+     * 纯数据计算，不访问任何 UObject，可在工作线程调用。
+     *
+     * @param RegionKey 区域坐标
+     * @param Params 生成参数（按值拷贝进任务）
+     * @param OutMesh 输出网格，顶点相对区域原点
+     */
+    static void BuildRegionMesh(const FIntPoint& RegionKey, const FWorldGenParams& Params, FFarTerrainMeshData& OutMesh);
+
+    /** 已显示的区域数量 */
+    int32 GetNumLoadedRegions() const { return LoadedRegions.Num(); }
+
+    /** 排队与构建中的区域数量 */
+    int32 GetNumPendingRegions() const { return QueuedRegions.Num() + PendingRegions.Num(); }
+
+    /** 当前生效的世界生成配置 */
+    TObjectPtr<UWorldGenerationConfig> CurrentConfig;
+
+private:
+    /** 同时运行的区域构建任务上限 */
+    static constexpr int32 MaxRegionTasksInFlight = 2;
+
+    /** 显示全部区域的 Actor（首次需要时生成） */
+    TWeakObjectPtr<AFarTerrainActor> FarTerrainActor;
+
+    /** 已显示的区域 */
+    TSet<FIntPoint> LoadedRegions;
+
+    /** 排队等待构建的区域（按距离排序，最近的在末尾） */
+    TArray<FIntPoint> RequestQueue;
+
+    /** 仍有效的排队区域；移除即表示取消 */
+    TSet<FIntPoint> QueuedRegions;
+
+    /** 已提交后台构建的区域（移除即表示取消，结果到达后丢弃） */
+    TSet<FIntPoint> PendingRegions;
+
+    /** 已加载的体素区块（远景网格在这些区块下方隐藏） */
+    TSet<FIntPoint> VoxelChunks;
+
+    /** 体素区块加载状态变化、需要重新筛选四边形的已显示区域 */
+    TSet<FIntPoint> DirtyRegions;
+
+    /** 已提交但结果尚未被取走的后台任务数量（包括已取消的任务） */
+    int32 NumTasksInFlight = 0;
+
+    /** 上一次更新的中心区块与体素半径 */
+    bool bHasStreamingArea = false;
+    FIntPoint StreamingCenter = FIntPoint::ZeroValue;
+    int32 StreamingVoxelRadius = 0;
+
+    /** 后台任务的结果队列 */
+    TSharedPtr<FFarTerrainResults, ESPMode::ThreadSafe> RegionResults = MakeShared<FFarTerrainResults, ESPMode::ThreadSafe>();
+
+    /** 配置代数，每次 Initialize 递增 */
+    uint32 ConfigGeneration = 0;
+
+    /** 获取（必要时生成）远景 Actor */
+    AFarTerrainActor* GetOrSpawnFarTerrainActor(UWorld* World);
+
+    /** 区域内距 CenterChunk 最近 / 最远区块的距离平方 */
+    void GetRegionDistanceSq(const FIntPoint& RegionKey, const FIntPoint& CenterChunk, int32& OutMinSq, int32& OutMaxSq) const;
+
+    /** 卸载区域，或取消其排队/构建中的请求 */
+    void UnloadRegion(const FIntPoint& RegionKey);
+
+    /** 区块所在的区域坐标 */
+    FIntPoint GetRegionOfChunk(const FIntPoint& ChunkKey) const;
+
+    /**
+     * @brief 区域内已加载体素区块的掩码
+     * @param RegionKey 区域坐标
+     * @param OutHidden 按区块槽位 CX + CY * RegionSize 标记已加载的区块
+     * @return 区域内的区块是否全部已加载
+     */
+    bool GetHiddenChunks(const FIntPoint& RegionKey, TBitArray<>& OutHidden) const;
+
+    /** 完全被体素区块覆盖、且区块已全部加载的区域（可以卸载） */
+    bool IsRegionCovered(const FIntPoint& RegionKey, bool bAllChunksLoaded) const;
+
+    /** 按体素区块的加载状态更新 DirtyRegions 中区域的可见四边形 */
+    void UpdateDirtyRegions();
+};
@@ -52,6 +52,11 @@ public:
 	enum FractalType { FBM, Billow, RigidMulti };
 	enum CellularDistanceFunction { Euclidean, Manhattan, Natural };
 	enum CellularReturnType { CellValue, NoiseLookup, Distance, Distance2, Distance2Add, Distance2Sub, Distance2Mul, Distance2Div };
+	enum SIMDLevel { SIMD_None, SIMD_SSE2, SIMD_AVX2 };
+
+	// Returns the widest SIMD level usable on this CPU, detected once at runtime
+	// SIMD_None on non-x64 targets or when FN_USE_DOUBLES is defined
+	static SIMDLevel GetSupportedSIMDLevel();
 
 	// Sets seed used for all noise types
 	// Default: 1337
@@ -161,6 +166,14 @@ public:
 	// Returns the maximum warp distance from original location when using GradientPerturb{Fractal}(...)
 	FN_DECIMAL GetGradientPerturbAmp() const { return m_gradientPerturbAmp; }
 
+	// Caps the SIMD level used by FillNoiseGrid(), the widest level supported by the CPU is used up to this cap
+	// Perlin and Simplex grids are evaluated 4 (SSE2) or 8 (AVX2) samples at a time, output is bit-identical at every level
+	// Default: SIMD_AVX2
+	void SetMaxSIMDLevel(SIMDLevel level) { m_maxSIMDLevel = level; }
+
+	// Returns the SIMD level cap used by FillNoiseGrid()
+	SIMDLevel GetMaxSIMDLevel() const { return m_maxSIMDLevel; }
+
 	//2D
 	FN_DECIMAL GetValue(FN_DECIMAL x, FN_DECIMAL y) const;
 	FN_DECIMAL GetValueFractal(FN_DECIMAL x, FN_DECIMAL y) const;
@@ -181,6 +194,12 @@ public:
 
 	FN_DECIMAL GetNoise(FN_DECIMAL x, FN_DECIMAL y) const;
 
+	// Fills a width * height buffer with 2D noise in a single call
+	// out[ix + iy * width] receives the same value as GetNoise(xStart + ix * xStep, yStart + iy * yStep)
+	// Value, Perlin, Simplex, Cubic and their fractal types share lattice work between neighbouring samples,
+	// other noise types fall back to calling GetNoise() per sample
+	void FillNoiseGrid(FN_DECIMAL* out, int width, int height, FN_DECIMAL xStart, FN_DECIMAL yStart, FN_DECIMAL xStep = 1, FN_DECIMAL yStep = 1) const;
+
 	void GradientPerturb(FN_DECIMAL& x, FN_DECIMAL& y) const;
 	void GradientPerturbFractal(FN_DECIMAL& x, FN_DECIMAL& y) const;
 
@@ -237,7 +256,10 @@ private:
 
 	FN_DECIMAL m_gradientPerturbAmp = FN_DECIMAL(1);
 
+	SIMDLevel m_maxSIMDLevel = SIMD_AVX2;
+
 	void CalculateFractalBounding();
+	SIMDLevel GetActiveSIMDLevel() const;
 
 	//2D
 	FN_DECIMAL SingleValueFractalFBM(FN_DECIMAL x, FN_DECIMAL y) const;
@@ -266,6 +288,16 @@ private:
 
 	void SingleGradientPerturb(unsigned char offset, FN_DECIMAL warpAmp, FN_DECIMAL frequency, FN_DECIMAL& x, FN_DECIMAL& y) const;
 
+	//2D Grid
+	// Grid kernels take pre-scaled sample coordinates: xs[width] for columns, ys[height] for rows
+	typedef void (FastNoise::*GridKernel)(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+
+	void FillFractalGrid(GridKernel kernel, FN_DECIMAL* xs, int width, FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+	void SingleValueGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+	void SinglePerlinGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+	void SingleSimplexGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+	void SingleCubicGrid(unsigned char offset, const FN_DECIMAL* xs, int width, const FN_DECIMAL* ys, int height, FN_DECIMAL* out) const;
+
 	//3D
 	FN_DECIMAL SingleValueFractalFBM(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
 	FN_DECIMAL SingleValueFractalBillow(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
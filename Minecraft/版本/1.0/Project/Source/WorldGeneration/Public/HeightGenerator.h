@@ -11,7 +11,7 @@ class FastNoise;
  * @brief 高度生成器（静态工具类）
  *
  * 使用 FastNoise 库生成程序化地形高度。
- * 所有方法均为静态，线程安全（通过临界区保护噪声实例缓存）。
+ * 所有方法均为静态，线程安全（每个线程持有独立的噪声实例缓存，查找无锁）。
  */
 UCLASS()
 class UHeightGenerator : public UObject
@@ -35,6 +35,7 @@ public:
      * @brief 生成整个区块（16x16）的地表高度图
      *
      * 输出数组按行主序存储：OutHeights[x + y * 16]
+     * 内部通过 FastNoise::FillNoiseGrid 一次性生成整块噪声，结果与逐点 GenerateHeightAt 一致。
      *
      * @param ChunkX 区块 X 索引
      * @param ChunkY 区块 Y 索引
@@ -48,9 +49,15 @@ public:
         TArray<int32>& OutHeights
     );
 
+    /**
+     * @brief 释放所有线程缓存的噪声实例
+     *
+     * 调用线程立即释放，其他线程在下一次生成高度时释放旧实例。
+     * 在世界关闭时调用。
+     */
+    static void ResetNoiseCache();
+
 private:
-    /** 噪声实例缓存（按种子分组） */
-    static TMap<int32, FastNoise*> GNoiseCache;
-    /** 保护缓存的临界区（确保线程安全） */
-    static FCriticalSection GCriticalSection;
+    /** 获取（必要时创建）当前线程、当前种子对应的噪声实例 */
+    static FastNoise* GetNoiseInstance(const FWorldGenParams& Params);
 };
\ No newline at end of file
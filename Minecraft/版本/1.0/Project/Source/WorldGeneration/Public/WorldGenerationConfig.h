@@ -5,6 +5,8 @@
 #include "Engine/DataAsset.h"
 #include "WorldGenerationConfig.generated.h"
 
+class UMaterialInterface;
+
 /**
  * 世界数据资产（DataAsset）
  * FWorldGenParams - 世界生成的核心参数
@@ -34,6 +36,69 @@ struct FWorldGenParams
     /** 区块横向尺寸（必须与 ChunkActor::SizeX/SizeZ 一致！） */
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunk", meta = (ClampMin = "1"))
     int32 ChunkSize = 16;
+
+    /** 每帧最多提交的区块数量（后台生成完成后在游戏线程生成 Actor 并设置数据） */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "1"))
+    int32 MaxChunkCommitsPerFrame = 4;
+
+    /** 同时运行的后台生成任务上限，其余请求按优先级排队 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "1"))
+    int32 MaxConcurrentGenerationTasks = 8;
+
+    /** 视线方向权重：背对摄像机的区块优先级按距离平方乘以 (1 + 权重) 排后 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0.0"))
+    float ViewDirectionPriorityWeight = 3.0f;
+
+    /** 增量流式加载：只处理进入/离开窗口的区块，并在每帧跟随玩家；关闭则每次全量扫描圆形区域 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming")
+    bool bIncrementalStreaming = true;
+
+    /** 卸载滞后圈数：区块超出 加载半径 + 该值 后才卸载，避免在边界来回加载/卸载 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 UnloadHysteresis = 1;
+
+    /** 区块 Actor 对象池容量：卸载的区块隐藏后回收复用，超出容量才销毁 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 MaxPooledChunkActors = 64;
+
+    /** 首次流式加载前预先生成的池内 Actor 数量 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 ChunkPoolWarmupCount = 16;
+
+    /**
+     * 距离 LOD 阈值（单位：区块数，递增）：第 i 项为切换到 LOD i+1（2^(i+1) 倍降采样）的距离，最多 3 级
+     * 为空则关闭 LOD，所有区块都按完整精度渲染
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD")
+    TArray<int32> LODDistances = { 8, 16, 24 };
+
+    /** LOD 滞后距离（区块数）：切回更精细的级别需再靠近该距离，避免在阈值附近来回重建 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD", meta = (ClampMin = "0"))
+    int32 LODHysteresis = 1;
+
+    /**
+     * 远景地形半径（单位：区块数）：体素区块之外只用高度图构建的低精度网格，0 为关闭
+     * 应大于体素加载半径，完全位于体素加载半径内的区域不会构建
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FarTerrain", meta = (ClampMin = "0"))
+    int32 FarTerrainRadius = 48;
+
+    /** 远景地形区域边长（单位：区块数），每个区域一个网格 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FarTerrain", meta = (ClampMin = "1"))
+    int32 FarTerrainRegionSize = 8;
+
+    /** 远景地形采样间隔（单位：方块数，不超过 ChunkSize），越大网格越粗 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FarTerrain", meta = (ClampMin = "1"))
+    int32 FarTerrainSampleStep = 4;
+
+    /** 远景地形按地表方块 ID 着色（顶点色），未列出的方块使用灰色 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FarTerrain")
+    TMap<int32, FColor> FarTerrainBlockColors = {
+        { 1, FColor(95, 159, 53) },     // 草
+        { 2, FColor(84, 84, 84) },      // 基岩
+        { 3, FColor(125, 125, 125) },   // 石头
+        { 7, FColor(134, 96, 67) }      // 泥土
+    };
 };
 
 
@@ -50,4 +115,8 @@ public:
     /** 生成参数集合 */
     UPROPERTY(EditAnywhere, Category = "World Generation")
     FWorldGenParams Params;
+
+    /** 远景地形材质（使用顶点色） */
+    UPROPERTY(EditAnywhere, Category = "World Generation")
+    TObjectPtr<UMaterialInterface> FarTerrainMaterial;
 };
@@ -1,9 +1,10 @@
 ﻿#pragma once
 #include "Subsystems/WorldSubsystem.h"
 #include "Engine/AssetManager.h"
+#include "ChunkGenerationManager.h"
+#include "FarTerrainManager.h"
 #include "WorldGenerationSubsystem.generated.h"
 
-class UChunkGenerationManager;
 class UWorldGenerationConfig;
 
 //  新增：声明动态多播委托（支持蓝图绑定）
@@ -14,9 +15,10 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWorldConfigLoadedDelegate);
  *
  * 作为全局子系统，协调区块加载、卸载与渲染。
  * 绑定到当前关卡 UWorldSubsystem，在关卡开始/结束时自动创建/销毁。
+ * 每帧 Tick 提交后台生成完成的区块（受每帧预算限制）。
  */
 UCLASS()
-class WORLDGENERATION_API UWorldGenerationSubsystem : public UWorldSubsystem
+class WORLDGENERATION_API UWorldGenerationSubsystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 
@@ -24,6 +26,13 @@ public:
 	/** 子系统初始化（引擎自动调用） */
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 
+	/** 子系统销毁（引擎自动调用），释放噪声缓存 */
+	virtual void Deinitialize() override;
+
+	/** 每帧提交已完成的区块生成结果 */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
 	/**
 	 * @brief 异步设置世界生成配置
 	 * @param Config 配置资源软引用，支持异步加载
@@ -34,7 +43,8 @@ public:
 	/**
 	 * @brief 围绕玩家位置生成/卸载区块
 	 *
-	 * 通过每帧调用实现动态加载，适用于玩家移动时触发
+	 * 通过每帧调用实现动态加载，适用于玩家移动时触发。
+	 * 增量模式（bIncrementalStreaming）下只需调用一次，之后由 Tick 自动跟随玩家。
 	 *
 	 * @param PlayerLocation 玩家世界坐标（FVector）
 	 * @param Radius 渲染半径（单位：区块数量）
@@ -42,6 +52,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "WorldGen")
 	void GenerateWorldAroundPlayer(const FVector& PlayerLocation, int32 Radius);
 
+	/** 获取区块流式加载统计（玩家静止时 StationaryChurnCount 应保持不变） */
+	UFUNCTION(BlueprintPure, Category = "WorldGen")
+	FChunkStreamingStats GetStreamingStats() const;
+
 	/** 设置区块 Actor 类型（由外部指定） */
 	UFUNCTION(BlueprintCallable, Category = "WorldGen")
 	void SetChunkActorClass(TSubclassOf<AActor> InClass);
@@ -50,6 +64,10 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "WorldGen")
 	TObjectPtr<UChunkGenerationManager> ChunkManager;
 
+	/** 远景地形（体素区块之外的高度图网格） */
+	UPROPERTY(BlueprintReadOnly, Category = "WorldGen")
+	TObjectPtr<UFarTerrainManager> FarTerrainManager;
+
 	//  新增：公开委托，供 GameMode 或蓝图监听
 	UPROPERTY(BlueprintAssignable, Category = "WorldGen")
 	FOnWorldConfigLoadedDelegate OnWorldConfigLoaded;
@@ -64,6 +82,12 @@ private:
 	/** 防止重复加载 */
 	bool bIsLoadingConfig = false;
 
+	/** 增量流式加载半径（-1 表示尚未开始，Tick 不跟随玩家） */
+	int32 StreamingRadius = -1;
+
 	/** 异步加载完成回调 */
 	void OnWorldConfigLoadedCallback();
+
+	/** 获取本地玩家摄像机朝向（无玩家时返回零向量） */
+	FVector GetPlayerViewDirection() const;
 };
\ No newline at end of file
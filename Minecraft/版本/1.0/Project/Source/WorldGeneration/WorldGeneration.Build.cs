@@ -15,7 +15,8 @@ public class WorldGeneration: ModuleRules
         );
         PrivateDependencyModuleNames.AddRange(new string[]
         {
-            "ChunkBlock"   
+            "ChunkBlock",
+            "ProceduralMeshComponent"
         }
         );
     }